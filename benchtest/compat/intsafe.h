@@ -0,0 +1,53 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COMPAT_INTSAFE_HEADER
+#define COMPAT_INTSAFE_HEADER
+
+/**
+ * Just enough of the Windows types used by the common headers to build the conversion writers on other platforms.
+ */
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int64_t LONGLONG;
+typedef int32_t HRESULT;
+typedef uint8_t boolean;
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define BI_RGB 0L
+#define STDMETHODCALLTYPE
+
+inline void Sleep(DWORD millis)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+}
+
+inline uint32_t _byteswap_ulong(uint32_t value)
+{
+	return __builtin_bswap32(value);
+}
+#endif
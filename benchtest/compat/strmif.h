@@ -0,0 +1,35 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef COMPAT_STRMIF_HEADER
+#define COMPAT_STRMIF_HEADER
+
+#include "intsafe.h"
+
+struct AM_MEDIA_TYPE
+{
+	BYTE* pbFormat;
+};
+
+/**
+ * The parts of the DirectShow media sample the writers use.
+ */
+struct IMediaSample
+{
+	virtual ~IMediaSample() = default;
+	virtual HRESULT GetPointer(BYTE** ppBuffer) = 0;
+	virtual LONG GetSize() = 0;
+	virtual HRESULT GetMediaType(AM_MEDIA_TYPE** ppMediaType) = 0;
+};
+#endif
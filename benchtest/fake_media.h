@@ -0,0 +1,169 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FAKE_MEDIA_HEADER
+#define FAKE_MEDIA_HEADER
+
+#include <cstdint>
+#include <vector>
+#include "../common/VideoFrameWriter.h"
+
+/**
+ * A source frame held in memory, satisfies the VF interface the writers expect of a captured frame.
+ */
+class fake_frame
+{
+public:
+	fake_frame(int pWidth, int pHeight, size_t pLength) :
+		mWidth(pWidth),
+		mHeight(pHeight),
+		mLength(pLength),
+		mStorage(pLength + 128)
+	{
+		// 64 byte aligned like a DMA buffer
+		mData = mStorage.data() + (64 - (reinterpret_cast<uintptr_t>(mStorage.data()) & 63));
+	}
+
+	fake_frame(const pixel_format& pFormat, int pWidth, int pHeight) :
+		fake_frame(pWidth, pHeight, ImageBytes(pFormat, pWidth, pHeight))
+	{
+	}
+
+	static size_t ImageBytes(const pixel_format& pFormat, int pWidth, int pHeight)
+	{
+		DWORD rowBytes;
+		DWORD imageBytes;
+		pFormat.GetImageDimensions(pWidth, pHeight, &rowBytes, &imageBytes);
+		return imageBytes;
+	}
+
+	// fills the frame with noise so no kernel gets to take a shortcut
+	void Fill(uint32_t seed)
+	{
+		for (size_t i = 0; i < mLength; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			mData[i] = static_cast<uint8_t>(seed >> 24);
+		}
+	}
+
+	uint8_t* Data()
+	{
+		return mData;
+	}
+
+	void SetFrameIndex(uint64_t pIndex)
+	{
+		mIndex = pIndex;
+	}
+
+	int GetWidth() const
+	{
+		return mWidth;
+	}
+
+	int GetHeight() const
+	{
+		return mHeight;
+	}
+
+	uint64_t GetFrameIndex() const
+	{
+		return mIndex;
+	}
+
+	long GetLength() const
+	{
+		return static_cast<long>(mLength);
+	}
+
+	void Start(void** data)
+	{
+		*data = mData;
+	}
+
+	void End()
+	{
+	}
+
+private:
+	int mWidth;
+	int mHeight;
+	size_t mLength;
+	uint64_t mIndex{0};
+	std::vector<uint8_t> mStorage;
+	uint8_t* mData;
+};
+
+/**
+ * A media sample over caller owned memory, if the renderer would pad each line the sample reports a media type with
+ * the padded width exactly as a renderer allocated sample does.
+ */
+class fake_sample : public IMediaSample
+{
+public:
+	fake_sample(uint8_t* pBuffer, long pSize, int pPaddedWidth = 0) :
+		mBuffer(pBuffer),
+		mSize(pSize)
+	{
+		mHeader.bmiHeader.biWidth = pPaddedWidth;
+		mMediaType.pbFormat = reinterpret_cast<BYTE*>(&mHeader);
+	}
+
+	virtual ~fake_sample() = default;
+
+	HRESULT STDMETHODCALLTYPE GetPointer(BYTE** ppBuffer) override
+	{
+		*ppBuffer = mBuffer;
+		return S_OK;
+	}
+
+	LONG STDMETHODCALLTYPE GetSize() override
+	{
+		return mSize;
+	}
+
+	HRESULT STDMETHODCALLTYPE GetMediaType(AM_MEDIA_TYPE** ppMediaType) override
+	{
+		*ppMediaType = mHeader.bmiHeader.biWidth > 0 ? &mMediaType : nullptr;
+		return *ppMediaType ? S_OK : S_FALSE;
+	}
+
+	#ifdef _WIN32
+	// the rest of the interface is never used by the writers
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void**) override { return E_NOINTERFACE; }
+	ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+	ULONG STDMETHODCALLTYPE Release() override { return 1; }
+	HRESULT STDMETHODCALLTYPE GetTime(REFERENCE_TIME*, REFERENCE_TIME*) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE SetTime(REFERENCE_TIME*, REFERENCE_TIME*) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE IsSyncPoint() override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE SetSyncPoint(BOOL) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE IsPreroll() override { return S_FALSE; }
+	HRESULT STDMETHODCALLTYPE SetPreroll(BOOL) override { return E_NOTIMPL; }
+	LONG STDMETHODCALLTYPE GetActualDataLength() override { return mSize; }
+	HRESULT STDMETHODCALLTYPE SetActualDataLength(LONG) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE SetMediaType(AM_MEDIA_TYPE*) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE IsDiscontinuity() override { return S_FALSE; }
+	HRESULT STDMETHODCALLTYPE SetDiscontinuity(BOOL) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE GetMediaTime(LONGLONG*, LONGLONG*) override { return E_NOTIMPL; }
+	HRESULT STDMETHODCALLTYPE SetMediaTime(LONGLONG*, LONGLONG*) override { return E_NOTIMPL; }
+	#endif
+
+private:
+	uint8_t* mBuffer;
+	long mSize;
+	VIDEOINFOHEADER2 mHeader{};
+	AM_MEDIA_TYPE mMediaType{};
+};
+#endif
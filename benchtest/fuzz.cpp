@@ -0,0 +1,854 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#define NO_QUILL
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#include "../common/conversion_registry.h"
+#include "../common/deinterlace.h"
+#include "../common/no_signal.h"
+#include "fake_media.h"
+
+/**
+ * Differential fuzzer for the conversion kernels, random frames (size, source stride, renderer padding & content) are
+ * converted by every kernel variant this cpu supports (instruction set, width specialisation, stripes, tiling, source
+ * memory type, luma measurement & preview) and the visible part of the output compared bit for bit with the unstriped
+ * scalar kernel. Previews are compared with a box filter of the scalar kernel's output & the scalar kernel's output is
+ * point sampled as a straight through frame would be. The deinterlacer's kernels are checked the same way against its
+ * scalar kernels.
+ *
+ * Source frames are allocated at their exact size and the destination is surrounded by guard bytes so any kernel
+ * writing outside the sample is reported, build with sanitizers (the default for the cmake build) to also catch reads
+ * beyond the end of the source frame.
+ *
+ * usage: fuzztest [--seed N] [--iterations N] [--strategy NAME|DEINTERLACE|PREVIEW|NO_SIGNAL] [--verbose]
+ */
+namespace
+{
+	// bytes either side of the destination which no kernel may touch
+	constexpr size_t guardBytes = 256;
+	constexpr uint8_t guardValue = 0xA5;
+
+	/**
+	 * A captured frame held in a heap allocation of exactly its length so an over read is visible to the sanitizer.
+	 */
+	class fuzz_frame
+	{
+	public:
+		fuzz_frame(int pWidth, int pHeight, size_t pLength, std::mt19937& rng) :
+			mWidth(pWidth),
+			mHeight(pHeight),
+			mLength(pLength),
+			mData(std::make_unique<uint8_t[]>(pLength))
+		{
+			std::uniform_int_distribution<int> byte(0, 255);
+			std::generate_n(mData.get(), mLength, [&] { return static_cast<uint8_t>(byte(rng)); });
+		}
+
+		int GetWidth() const
+		{
+			return mWidth;
+		}
+
+		int GetHeight() const
+		{
+			return mHeight;
+		}
+
+		uint64_t GetFrameIndex() const
+		{
+			return 0;
+		}
+
+		long GetLength() const
+		{
+			return static_cast<long>(mLength);
+		}
+
+		void Start(void** data)
+		{
+			*data = mData.get();
+		}
+
+		void End()
+		{
+		}
+
+	private:
+		int mWidth;
+		int mHeight;
+		size_t mLength;
+		std::unique_ptr<uint8_t[]> mData;
+	};
+
+	struct fuzz_case
+	{
+		int width;
+		int height;
+		int padding;
+		// bytes added to each source line, only formats whose stride is derived from the frame length accept this
+		int sourcePadding;
+	};
+
+	struct fuzz_variant
+	{
+		cpu_isa isa;
+		uint8_t stripes;
+		int tileLines;
+		source_memory sourceMemory;
+		// luma measured into enabled light level & active area meters
+		bool measure{false};
+		// planar outputs box filtered into a preview at this scale, 0 for no preview
+		int previewScale{0};
+	};
+
+	struct fuzz_options
+	{
+		uint32_t seed{0x5EED};
+		int iterations{200};
+		std::string strategy{};
+		bool verbose{false};
+	};
+
+	/**
+	 * A destination buffer with guard bytes either side.
+	 */
+	class fuzz_output
+	{
+	public:
+		explicit fuzz_output(size_t pImageBytes, int pPaddedWidth) :
+			mImageBytes(pImageBytes),
+			mStorage(pImageBytes + 2 * guardBytes, guardValue),
+			mSample(mStorage.data() + guardBytes, static_cast<long>(pImageBytes), pPaddedWidth)
+		{
+		}
+
+		IMediaSample* Sample()
+		{
+			return &mSample;
+		}
+
+		const uint8_t* Image() const
+		{
+			return mStorage.data() + guardBytes;
+		}
+
+		// offset (relative to the image) of the first modified guard byte or 0 if both guards are intact
+		ptrdiff_t GuardViolation() const
+		{
+			for (size_t i = 0; i < guardBytes; ++i)
+			{
+				if (mStorage[i] != guardValue)
+				{
+					return static_cast<ptrdiff_t>(i) - static_cast<ptrdiff_t>(guardBytes);
+				}
+				if (mStorage[guardBytes + mImageBytes + i] != guardValue)
+				{
+					return static_cast<ptrdiff_t>(mImageBytes + i);
+				}
+			}
+			return 0;
+		}
+
+	private:
+		size_t mImageBytes;
+		std::vector<uint8_t> mStorage;
+		fake_sample mSample;
+	};
+
+	// the visible part of each line of a plane of the output, the renderer's padding is left undefined by the writers
+	struct plane_layout
+	{
+		size_t offset;
+		size_t stride;
+		size_t visibleBytes;
+		int lines;
+	};
+
+	std::vector<plane_layout> OutputPlanes(const pixel_format& target, int width, int paddedWidth, int height)
+	{
+		const auto w = static_cast<size_t>(width);
+		const auto pw = static_cast<size_t>(paddedWidth);
+		const auto lumaBytes = pw * height;
+		switch (target.format)
+		{
+		case pixel_format::YV16:
+			return {{0, pw, w, height}, {lumaBytes, pw / 2, w / 2, height}, {lumaBytes * 3 / 2, pw / 2, w / 2, height}};
+		case pixel_format::NV16:
+			return {{0, pw, w, height}, {lumaBytes, pw, w, height}};
+		case pixel_format::NV12:
+			return {{0, pw, w, height}, {lumaBytes, pw, w, height / 2}};
+		case pixel_format::P210:
+			return {{0, pw * 2, w * 2, height}, {lumaBytes * 2, pw * 2, w * 2, height}};
+		case pixel_format::P010:
+			return {{0, pw * 2, w * 2, height}, {lumaBytes * 2, pw * 2, w * 2, height / 2}};
+		case pixel_format::RGB48:
+			return {{0, pw * 6, w * 6, height}};
+		case pixel_format::BGRA:
+			return {{0, pw * 4, w * 4, height}};
+		default:
+			return {};
+		}
+	}
+
+	bool HasLengthDerivedStride(const pixel_format& format)
+	{
+		return format == R12B || format == R12L;
+	}
+
+	fuzz_case NextCase(const frame_conversion<fuzz_frame>& conversion, std::mt19937& rng)
+	{
+		// mostly small frames so many shapes are covered, sometimes a specialised width to reach those kernels
+		std::uniform_int_distribution<int> pick(0, 9);
+		std::uniform_int_distribution<int> smallWidth(1, 400);
+		std::uniform_int_distribution<int> specialised(0, static_cast<int>(std::size(specialisedWidths)) - 1);
+		std::uniform_int_distribution<int> height(1, 24);
+		std::uniform_int_distribution<int> padding(0, 64);
+		std::uniform_int_distribution<int> sourcePadding(0, 96);
+
+		fuzz_case c{};
+		c.width = pick(rng) < 3 ? specialisedWidths[specialised(rng)] : smallWidth(rng) * 2;
+		c.height = height(rng);
+		// the renderer pads to an even width, 4:2:0 output is only requested for even heights
+		c.padding = pick(rng) < 4 ? 0 : padding(rng) * 2;
+		if (conversion.target.subsampling == YUV_420)
+		{
+			c.height += c.height & 1;
+		}
+		c.sourcePadding = HasLengthDerivedStride(conversion.source) && pick(rng) < 5 ? sourcePadding(rng) * 4 : 0;
+		return c;
+	}
+
+	std::vector<fuzz_variant> Variants(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<int> tileLines(1, 16);
+		std::vector<fuzz_variant> variants;
+		for (const auto isa : {ISA_SCALAR, ISA_SSE2, ISA_SSSE3, ISA_AVX2, ISA_AVX512})
+		{
+			if (!GetCpuFeatures().Supports(isa))
+			{
+				continue;
+			}
+			variants.push_back({isa, 1, 0, SOURCE_CACHED});
+			variants.push_back({isa, 3, 0, SOURCE_CACHED, true, minPreviewScale});
+			variants.push_back({isa, 1, tileLines(rng) * 2, SOURCE_CACHED, true, maxPreviewScale});
+			variants.push_back({isa, 2, tileLines(rng) * 2, SOURCE_WRITE_COMBINED, false, minPreviewScale});
+		}
+		return variants;
+	}
+
+	// offset of the first visible byte which differs or -1 if the outputs match
+	ptrdiff_t FirstDifference(const fuzz_output& expected, const fuzz_output& actual,
+	                          const std::vector<plane_layout>& planes)
+	{
+		for (const auto& plane : planes)
+		{
+			for (int line = 0; line < plane.lines; ++line)
+			{
+				const auto offset = plane.offset + line * plane.stride;
+				const auto e = expected.Image() + offset;
+				const auto a = actual.Image() + offset;
+				if (const auto m = std::mismatch(e, e + plane.visibleBytes, a); m.first != e + plane.visibleBytes)
+				{
+					return m.first - expected.Image();
+				}
+			}
+		}
+		return -1;
+	}
+
+	// the preview of the reference output, i.e. each box of the visible output averaged with rounding
+	std::vector<uint8_t> ExpectedPreview(const fuzz_output& expected, const std::vector<plane_layout>& planes,
+	                                     const preview_frame& preview)
+	{
+		const auto& source = preview.source;
+		const auto scale = preview.scale;
+		const auto outWidth = preview.videoFormat.cx;
+		const auto outHeight = preview.videoFormat.cy;
+		auto sample = [&](size_t plane, int x, int y) -> uint32_t
+		{
+			const auto* line = expected.Image() + planes[plane].offset + y * planes[plane].stride;
+			return source.bytesPerSample == 1 ? line[x] : reinterpret_cast<const uint16_t*>(line)[x] >> 8;
+		};
+		auto mean = [](uint32_t sum, int count)
+		{
+			return static_cast<uint8_t>((sum + count / 2) / count);
+		};
+
+		std::vector<uint8_t> out(static_cast<size_t>(outWidth) * outHeight * 3 / 2);
+		for (int y = 0; y < outHeight; ++y)
+		{
+			for (int x = 0; x < outWidth; ++x)
+			{
+				uint32_t sum = 0;
+				for (int j = 0; j < scale; ++j)
+				{
+					for (int i = 0; i < scale; ++i)
+					{
+						sum += sample(0, x * scale + i, y * scale + j);
+					}
+				}
+				out[static_cast<size_t>(y) * outWidth + x] = mean(sum, scale * scale);
+			}
+		}
+		// each chroma sample of the preview covers 2x2 boxes of luma
+		const auto chromaLines = 2 * scale >> source.chromaVShift;
+		auto* uv = out.data() + static_cast<size_t>(outWidth) * outHeight;
+		for (int y = 0; y < outHeight / 2; ++y)
+		{
+			for (int x = 0; x < outWidth / 2; ++x)
+			{
+				for (int channel = 0; channel < 2; ++channel)
+				{
+					uint32_t sum = 0;
+					for (int j = 0; j < chromaLines; ++j)
+					{
+						for (int i = 0; i < scale; ++i)
+						{
+							const auto cx = x * scale + i;
+							const auto cy = y * chromaLines + j;
+							// YV16 stores V before U
+							sum += source.planes == 2 ? sample(1, cx * 2 + channel, cy) : sample(2 - channel, cx, cy);
+						}
+					}
+					uv[static_cast<size_t>(y) * outWidth + x * 2 + channel] = mean(sum, chromaLines * scale);
+				}
+			}
+		}
+		return out;
+	}
+
+	/**
+	 * Point samples the reference output as the capture pin does for a writer which did not box filter a preview & checks
+	 * the luma of each preview pixel is that of the output pixel at the centre of its box.
+	 */
+	bool CheckPointSample(const frame_conversion<fuzz_frame>& conversion, const fuzz_case& c, const fuzz_output& expected,
+	                      const std::vector<plane_layout>& planes)
+	{
+		video_format format{};
+		format.pixelFormat = conversion.target;
+		format.cx = c.width;
+		format.cy = c.height;
+		format.CalculateDimensions();
+		preview_sink sink{minPreviewScale};
+		sink.SetActive(true);
+		sink.Sample(expected.Image(), format, c.padding);
+		const auto* preview = sink.Acquire(std::chrono::milliseconds(0));
+		if (!preview)
+		{
+			// too small to preview
+			return true;
+		}
+		const auto half = preview->scale / 2;
+		for (int y = 0; y < preview->videoFormat.cy; ++y)
+		{
+			const auto* line = expected.Image() + planes[0].offset + (y * preview->scale + half) * planes[0].stride;
+			for (int x = 0; x < preview->videoFormat.cx; ++x)
+			{
+				const auto sx = x * preview->scale + half;
+				uint8_t want;
+				if (conversion.target == RGB48)
+				{
+					const auto* rgb = reinterpret_cast<const uint16_t*>(line) + sx * 3;
+					want = preview_detail::FromRgb(rgb[0] >> 8, rgb[1] >> 8, rgb[2] >> 8).y;
+				}
+				else if (conversion.target == BGRA)
+				{
+					const auto* bgra = line + sx * 4;
+					want = preview_detail::FromRgb(bgra[2], bgra[1], bgra[0]).y;
+				}
+				else
+				{
+					want = conversion.target.bitDepth > 8 ? reinterpret_cast<const uint16_t*>(line)[sx] >> 8 : line[sx];
+				}
+				const auto got = preview->data[static_cast<size_t>(y) * preview->videoFormat.cx + x];
+				if (got != want)
+				{
+					fprintf(stderr, "Point sampled preview differs at %d,%d (expected 0x%02x, got 0x%02x)\n", x, y,
+					        want, got);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Point samples a black frame of every output format, at a few sizes & paddings, which must preview as limited range
+	 * black. Frames are allocated at their exact size so the sanitizer reports any read beyond the end.
+	 */
+	bool CheckPointSampleFormats(const fuzz_options& options)
+	{
+		auto ok = true;
+		for (const auto& pixelFormat : all_pixel_formats)
+		{
+			for (const auto& [cx, cy, padding] : {std::tuple{64, 8, 0}, {200, 18, 10}, {722, 34, 64}})
+			{
+				video_format format{};
+				format.pixelFormat = pixelFormat;
+				format.cx = cx;
+				format.cy = cy;
+				format.quantisation = QUANTISATION_LIMITED;
+				format.pixelFormat.GetImageDimensions(cx + padding, cy, &format.lineLength, &format.imageSize);
+				auto frame = std::make_unique<uint8_t[]>(format.imageSize);
+				no_signal_detail::render_black(frame.get(), format);
+
+				preview_sink sink{minPreviewScale};
+				sink.SetActive(true);
+				sink.Sample(frame.get(), format, padding);
+				const auto* preview = sink.Acquire(std::chrono::milliseconds(0));
+				if (!preview)
+				{
+					fprintf(stderr, "No point sampled preview of %s\n", pixelFormat.name.c_str());
+					ok = false;
+					continue;
+				}
+				const auto lumaBytes = static_cast<size_t>(preview->videoFormat.cx) * preview->videoFormat.cy;
+				for (size_t i = 0; i < preview->data.size(); ++i)
+				{
+					if (const uint8_t want = i < lumaBytes ? 16 : 128; preview->data[i] != want)
+					{
+						fprintf(stderr, "Point sampled preview of %s %dx%d pad %d differs at offset %zu (expected 0x%02x, "
+						        "got 0x%02x)\n", pixelFormat.name.c_str(), cx, cy, padding, i, want, preview->data[i]);
+						ok = false;
+						break;
+					}
+				}
+				if (options.verbose)
+				{
+					printf("  %s %dx%d pad %d\n", pixelFormat.name.c_str(), cx, cy, padding);
+				}
+			}
+		}
+		return ok;
+	}
+
+	/**
+	 * Renders the no signal frame of every output format, which must preview as black & grey only with the caption
+	 * visible whenever the frame is large enough to show it. Frames are allocated at their exact size so the sanitizer
+	 * reports any write beyond the end.
+	 */
+	bool CheckNoSignalFrames(const fuzz_options& options)
+	{
+		auto ok = true;
+		for (const auto& pixelFormat : all_pixel_formats)
+		{
+			for (const auto& [cx, cy, captioned] : {std::tuple{40, 8, false}, {720, 480, true}, {1920, 1080, true}})
+			{
+				video_format format{};
+				format.pixelFormat = pixelFormat;
+				format.cx = cx;
+				format.cy = cy;
+				format.quantisation = QUANTISATION_LIMITED;
+				format.CalculateDimensions();
+				auto frame = std::make_unique<uint8_t[]>(format.imageSize);
+				no_signal_detail::render_no_signal(frame.get(), format);
+
+				preview_sink sink{minPreviewScale};
+				sink.SetActive(true);
+				sink.Sample(frame.get(), format, 0);
+				const auto* preview = sink.Acquire(std::chrono::milliseconds(0));
+				if (!preview)
+				{
+					fprintf(stderr, "No preview of the %s no signal frame\n", pixelFormat.name.c_str());
+					ok = false;
+					continue;
+				}
+				// RGB is converted to YUV by the preview so may be a step away from the YUV grey
+				const auto lumaBytes = static_cast<size_t>(preview->videoFormat.cx) * preview->videoFormat.cy;
+				auto lit = false;
+				for (size_t i = 0; i < preview->data.size() && ok; ++i)
+				{
+					const auto v = preview->data[i];
+					const auto valid = i < lumaBytes ? v == 16 || std::abs(v - 180) <= 1 : std::abs(v - 128) <= 1;
+					lit |= i < lumaBytes && v != 16;
+					if (!valid)
+					{
+						fprintf(stderr, "No signal frame of %s %dx%d is neither black nor grey at preview offset %zu "
+						        "(0x%02x)\n", pixelFormat.name.c_str(), cx, cy, i, v);
+						ok = false;
+					}
+				}
+				if (ok && lit != captioned)
+				{
+					fprintf(stderr, "No signal frame of %s %dx%d %s a caption\n", pixelFormat.name.c_str(), cx, cy,
+					        captioned ? "is missing" : "unexpectedly has");
+					ok = false;
+				}
+
+				// copied into a sample whose lines are padded by the renderer, the image must be unchanged
+				constexpr int pixelsToPad = 24;
+				const auto paddedSize = no_signal_frames::PaddedImageSize(format, pixelsToPad);
+				auto padded = std::make_unique<uint8_t[]>(paddedSize);
+				no_signal_frames::CopyTo(padded.get(), frame.get(), format, pixelsToPad);
+				preview_sink paddedSink{minPreviewScale};
+				paddedSink.SetActive(true);
+				paddedSink.Sample(padded.get(), format, pixelsToPad);
+				const auto* paddedPreview = paddedSink.Acquire(std::chrono::milliseconds(0));
+				if (!paddedPreview || paddedPreview->data != preview->data)
+				{
+					fprintf(stderr, "No signal frame of %s %dx%d changes when padded by %d pixels\n",
+					        pixelFormat.name.c_str(), cx, cy, pixelsToPad);
+					ok = false;
+				}
+				if (options.verbose)
+				{
+					printf("  %s %dx%d\n", pixelFormat.name.c_str(), cx, cy);
+				}
+			}
+		}
+		return ok;
+	}
+
+	void Describe(const frame_conversion<fuzz_frame>& conversion, const fuzz_case& c, const fuzz_variant& v,
+	              const char* isa)
+	{
+		fprintf(stderr, "  %s %dx%d pad %d source pad %d: %s, %d stripes, %d tile lines, %s source%s, preview 1/%d\n",
+		        to_string(conversion.strategy), c.width, c.height, c.padding, c.sourcePadding, isa, v.stripes,
+		        v.tileLines, to_string(v.sourceMemory), v.measure ? ", measuring" : "", v.previewScale);
+	}
+
+	bool FuzzOnce(const frame_conversion<fuzz_frame>& conversion, std::mt19937& rng,
+	              std::vector<std::unique_ptr<conversion_pool>>& pools, const fuzz_options& options)
+	{
+		const auto c = NextCase(conversion, rng);
+
+		DWORD rowBytes;
+		DWORD imageBytes;
+		conversion.source.GetImageDimensions(c.width, c.height, &rowBytes, &imageBytes);
+		fuzz_frame src{c.width, c.height, imageBytes + static_cast<size_t>(c.sourcePadding) * c.height, rng};
+
+		conversion.target.GetImageDimensions(c.width + c.padding, c.height, &rowBytes, &imageBytes);
+		const auto paddedWidth = c.padding > 0 ? c.width + c.padding : 0;
+		const auto planes = OutputPlanes(conversion.target, c.width, c.width + c.padding, c.height);
+		if (planes.empty())
+		{
+			fprintf(stderr, "No output layout for %s\n", conversion.target.name.c_str());
+			return false;
+		}
+
+		fuzz_output expected{imageBytes, paddedWidth};
+		{
+			auto reference = conversion.create(log_data{}, c.width, c.height, ISA_SCALAR);
+			if (reference->WriteTo(&src, expected.Sample()) != S_OK)
+			{
+				fprintf(stderr, "Reference kernel failed\n");
+				Describe(conversion, c, {ISA_SCALAR, 1, 0, SOURCE_CACHED}, to_string(ISA_SCALAR));
+				return false;
+			}
+			if (const auto at = expected.GuardViolation(); at != 0)
+			{
+				fprintf(stderr, "Reference kernel wrote outside the sample at offset %td\n", at);
+				Describe(conversion, c, {ISA_SCALAR, 1, 0, SOURCE_CACHED}, to_string(ISA_SCALAR));
+				return false;
+			}
+		}
+		if (!CheckPointSample(conversion, c, expected, planes))
+		{
+			Describe(conversion, c, {ISA_SCALAR, 1, 0, SOURCE_CACHED}, to_string(ISA_SCALAR));
+			return false;
+		}
+
+		auto ok = true;
+		for (const auto& v : Variants(rng))
+		{
+			auto writer = conversion.create(log_data{}, c.width, c.height, v.isa);
+			// kernels only exist for some instruction sets, anything else falls back to one that is checked separately
+			if (writer->GetIsa() != v.isa)
+			{
+				continue;
+			}
+			writer->SetConversionPool(v.stripes > 1 ? pools[v.stripes].get() : nullptr);
+			writer->SetTileLines(v.tileLines);
+			writer->SetSourceMemory(v.sourceMemory);
+			light_level_meter lightLevelMeter;
+			lightLevelMeter.SetEnabled(v.measure);
+			writer->SetLightLevelMeter(&lightLevelMeter);
+			active_area_meter activeAreaMeter;
+			activeAreaMeter.SetEnabled(v.measure);
+			writer->SetActiveAreaMeter(&activeAreaMeter);
+			preview_sink previewSink{std::max(v.previewScale, minPreviewScale)};
+			previewSink.SetActive(v.previewScale > 0);
+			writer->SetPreviewSink(&previewSink);
+
+			fuzz_output actual{imageBytes, paddedWidth};
+			if (writer->WriteTo(&src, actual.Sample()) != S_OK)
+			{
+				fprintf(stderr, "Kernel failed\n");
+				Describe(conversion, c, v, to_string(writer->GetIsa()));
+				ok = false;
+				continue;
+			}
+			if (const auto at = actual.GuardViolation(); at != 0)
+			{
+				fprintf(stderr, "Kernel wrote outside the sample at offset %td\n", at);
+				Describe(conversion, c, v, to_string(writer->GetIsa()));
+				ok = false;
+				continue;
+			}
+			if (const auto at = FirstDifference(expected, actual, planes); at >= 0)
+			{
+				fprintf(stderr, "Output differs from the scalar kernel at offset %td (expected 0x%02x, got 0x%02x)\n",
+				        at, expected.Image()[at], actual.Image()[at]);
+				Describe(conversion, c, v, to_string(writer->GetIsa()));
+				ok = false;
+				continue;
+			}
+			if (const auto* preview = previewSink.Acquire(std::chrono::milliseconds(0)))
+			{
+				const auto want = ExpectedPreview(expected, planes, *preview);
+				if (const auto m = std::ranges::mismatch(want, preview->data); m.in1 != want.end())
+				{
+					fprintf(stderr, "Preview differs from the scalar kernel at offset %td (expected 0x%02x, got 0x%02x)\n",
+					        m.in1 - want.begin(), *m.in1, *m.in2);
+					Describe(conversion, c, v, to_string(writer->GetIsa()));
+					ok = false;
+					continue;
+				}
+			}
+			if (options.verbose)
+			{
+				Describe(conversion, c, v, to_string(writer->GetIsa()));
+			}
+		}
+		return ok;
+	}
+
+	/**
+	 * A pair of consecutive woven frames where, component by component, the second either matches the first or differs
+	 * by up to twice the motion threshold so detection is exercised on both sides of the threshold.
+	 */
+	std::vector<uint8_t> NextDeinterlaceFrames(bool v210, size_t bytes, std::mt19937& rng)
+	{
+		const int bits = v210 ? 10 : 8;
+		const int components = v210 ? 3 : 4;
+		const int maxValue = (1 << bits) - 1;
+		const int maxDelta = 2 * (deinterlaceMotionThreshold << (bits - 8));
+		std::uniform_int_distribution<int> value(0, maxValue);
+		std::uniform_int_distribution<int> delta(-maxDelta, maxDelta);
+		std::uniform_int_distribution<int> pick(0, 2);
+		std::vector<uint8_t> frames(bytes * 2);
+		for (size_t i = 0; i < bytes; i += 4)
+		{
+			uint32_t previous = 0;
+			uint32_t current = 0;
+			for (int c = 0; c < components; ++c)
+			{
+				const auto p = value(rng);
+				const auto n = pick(rng) == 0 ? p : std::clamp(p + delta(rng), 0, maxValue);
+				previous |= static_cast<uint32_t>(p) << c * bits;
+				current |= static_cast<uint32_t>(n) << c * bits;
+			}
+			memcpy(frames.data() + i, &previous, 4);
+			memcpy(frames.data() + bytes + i, &current, 4);
+		}
+		return frames;
+	}
+
+	bool FuzzDeinterlaceOnce(std::mt19937& rng, const fuzz_options& options)
+	{
+		std::uniform_int_distribution<int> width(1, 400);
+		std::uniform_int_distribution<int> height(1, 24);
+		std::bernoulli_distribution coin;
+		const auto v210 = coin(rng);
+		const auto w = width(rng) * 2;
+		const auto h = height(rng);
+		const auto rowBytes = v210 ? (w + 47) / 48 * 128 : w * 2;
+		const auto mode = coin(rng) ? DEINTERLACE_BOB : DEINTERLACE_MOTION_ADAPTIVE;
+		const auto order = coin(rng) ? FIELD_ORDER_TOP_FIRST : FIELD_ORDER_BOTTOM_FIRST;
+		const auto bytes = static_cast<size_t>(rowBytes) * h;
+		const auto frames = NextDeinterlaceFrames(v210, bytes, rng);
+		const auto& format = v210 ? V210 : YUV2;
+
+		auto describe = [&](cpu_isa isa, int field)
+		{
+			fprintf(stderr, "  DEINTERLACE %s %dx%d: %s, %s, %s, field %d\n", v210 ? "v210" : "uyvy", w, h,
+			        to_string(isa), to_string(mode), to_string(order), field);
+		};
+
+		std::vector<uint8_t> expected[2];
+		auto ok = true;
+		for (const auto isa : {ISA_SCALAR, ISA_SSE2, ISA_AVX2})
+		{
+			deinterlacer d{isa};
+			d.Load(frames.data(), rowBytes, h, format, order, mode, 0, false);
+			d.Load(frames.data() + bytes, rowBytes, h, format, order, mode, 1, isa == ISA_SSE2);
+			if (d.GetIsa() != isa)
+			{
+				continue;
+			}
+			for (int field = 0; field < 2; ++field)
+			{
+				const auto* out = d.Render(field);
+				if (isa == ISA_SCALAR)
+				{
+					expected[field].assign(out, out + bytes);
+					// each field keeps its own lines
+					const auto parity = order == FIELD_ORDER_BOTTOM_FIRST ? 1 - field : field;
+					for (int y = parity; y < h; y += 2)
+					{
+						const auto offset = static_cast<size_t>(y) * rowBytes;
+						if (memcmp(out + offset, frames.data() + bytes + offset, rowBytes) != 0)
+						{
+							fprintf(stderr, "Deinterlaced field does not keep line %d\n", y);
+							describe(isa, field);
+							ok = false;
+						}
+					}
+				}
+				else if (const auto m = std::mismatch(out, out + bytes, expected[field].begin()); m.first != out + bytes)
+				{
+					const auto at = m.first - out;
+					fprintf(stderr, "Deinterlaced field differs from the scalar kernel at offset %td (expected 0x%02x, got 0x%02x)\n",
+					        at, expected[field][at], out[at]);
+					describe(isa, field);
+					ok = false;
+				}
+				else if (options.verbose)
+				{
+					describe(isa, field);
+				}
+			}
+		}
+		return ok;
+	}
+
+	bool parse(int argc, char* argv[], fuzz_options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg{argv[i]};
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--verbose")
+			{
+				options.verbose = true;
+			}
+			else if (arg == "--seed" && hasValue)
+			{
+				options.seed = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 0));
+			}
+			else if (arg == "--iterations" && hasValue)
+			{
+				options.iterations = std::max(std::stoi(argv[++i]), 1);
+			}
+			else if (arg == "--strategy" && hasValue)
+			{
+				options.strategy = argv[++i];
+			}
+			else
+			{
+				fprintf(stderr, "Unknown argument %s\n", arg.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	fuzz_options options;
+	if (!parse(argc, argv, options))
+	{
+		fprintf(stderr, "usage: fuzztest [--seed N] [--iterations N] [--strategy NAME|DEINTERLACE|PREVIEW|NO_SIGNAL] "
+		        "[--verbose]\n");
+		return 2;
+	}
+
+	// indexed by stripe count
+	std::vector<std::unique_ptr<conversion_pool>> pools(4);
+	for (uint8_t stripes = 2; stripes < pools.size(); ++stripes)
+	{
+		pools[stripes] = std::make_unique<conversion_pool>(log_data{}, stripes, false);
+	}
+
+	auto failures = 0;
+	auto matched = false;
+	for (const auto& conversion : conversion_registry<fuzz_frame>::Instance().Conversions())
+	{
+		// sdk conversions need a capture card
+		if (conversion.IsLastResort())
+		{
+			continue;
+		}
+		if (!options.strategy.empty() && options.strategy != to_string(conversion.strategy))
+		{
+			continue;
+		}
+		matched = true;
+		// each conversion gets its own sequence so a failure can be replayed with --strategy & the same seed
+		std::mt19937 rng{options.seed ^ static_cast<uint32_t>(conversion.strategy) * 0x9E3779B9u};
+		auto conversionFailures = 0;
+		for (int i = 0; i < options.iterations; ++i)
+		{
+			if (!FuzzOnce(conversion, rng, pools, options))
+			{
+				fprintf(stderr, "  iteration %d of seed 0x%x\n", i, options.seed);
+				++conversionFailures;
+			}
+		}
+		printf("%-12s %s\n", to_string(conversion.strategy), conversionFailures == 0 ? "ok" : "FAILED");
+		fflush(stdout);
+		failures += conversionFailures;
+	}
+	if (options.strategy.empty() || options.strategy == "DEINTERLACE")
+	{
+		matched = true;
+		std::mt19937 rng{options.seed};
+		auto deinterlaceFailures = 0;
+		for (int i = 0; i < options.iterations; ++i)
+		{
+			if (!FuzzDeinterlaceOnce(rng, options))
+			{
+				fprintf(stderr, "  iteration %d of seed 0x%x\n", i, options.seed);
+				++deinterlaceFailures;
+			}
+		}
+		printf("%-12s %s\n", "DEINTERLACE", deinterlaceFailures == 0 ? "ok" : "FAILED");
+		failures += deinterlaceFailures;
+	}
+	if (options.strategy.empty() || options.strategy == "PREVIEW")
+	{
+		matched = true;
+		const auto previewOk = CheckPointSampleFormats(options);
+		printf("%-12s %s\n", "PREVIEW", previewOk ? "ok" : "FAILED");
+		failures += previewOk ? 0 : 1;
+	}
+	if (options.strategy.empty() || options.strategy == "NO_SIGNAL")
+	{
+		matched = true;
+		const auto noSignalOk = CheckNoSignalFrames(options);
+		printf("%-12s %s\n", "NO_SIGNAL", noSignalOk ? "ok" : "FAILED");
+		failures += noSignalOk ? 0 : 1;
+	}
+	if (!matched)
+	{
+		fprintf(stderr, "No conversion named %s\n", options.strategy.c_str());
+		return 2;
+	}
+	printf("%d failures from seed 0x%x\n", failures, options.seed);
+	return failures == 0 ? 0 : 1;
+}
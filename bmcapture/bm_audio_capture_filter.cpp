@@ -13,12 +13,44 @@
  * If not, see <https://www.gnu.org/licenses/>.
  */
 #include "bm_audio_capture_pin.h"
+#include "cpu_features.h"
 
 // audio is limited to 48kHz and an audio packet is only delivered with a video frame
 // lowest fps is 23.976 so the max no of samples should be 48000/(24000/1001) = 2002
 // but there can be backlogs so allow for a few frames for safety
 constexpr uint16_t maxSamplesPerFrame = 8192;
 
+namespace
+{
+	// reorders 16 samples per pass to match the DirectShow channel order, returns the number of samples processed
+	EZ_TARGET_AVX2
+	int reorder_channels_avx2(const uint16_t* inputSamples, uint16_t* outputSamples, size_t inputSampleCount,
+	                          WORD channelCount)
+	{
+		const auto chunks = inputSampleCount / 16;
+		const __m256i shuffle_mask = channelCount == 8
+			?
+			_mm256_setr_epi8(
+				0, 1, 2, 3, 6, 7, 4, 5, 12, 13, 14, 15, 8, 9, 10, 11,
+				0, 1, 2, 3, 6, 7, 4, 5, 12, 13, 14, 15, 8, 9, 10, 11
+			)
+			:
+			_mm256_setr_epi8(
+				0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 10, 11, 14, 15, 12, 13,
+				0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 10, 11, 14, 15, 12, 13
+			);
+		int i = 0;
+		for (size_t j = 0; j < chunks; j++)
+		{
+			__m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSamples + i));
+			__m256i shuffled = _mm256_shuffle_epi8(samples, shuffle_mask);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(outputSamples + i), shuffled);
+			i += 16;
+		}
+		return i;
+	}
+}
+
 blackmagic_audio_capture_pin::blackmagic_audio_capture_pin(HRESULT* phr, blackmagic_capture_filter* pParent,
                                                            bool pPreview) :
 	hdmi_audio_capture_pin(
@@ -210,34 +242,12 @@ HRESULT blackmagic_audio_capture_pin::FillBuffer(IMediaSample* pms)
 		uint16_t* outputSamples = reinterpret_cast<uint16_t*>(pmsData);
 		auto inputSampleCount = mCurrentFrame->GetLength() / sizeof(uint16_t);
 		auto i = 0;
-		#ifdef __AVX2__
-		if (mAudioFormat.outputChannelCount == 8 || mAudioFormat.outputChannelCount == 4)
+		if (GetCpuFeatures().Supports(ISA_AVX2)
+			&& (mAudioFormat.outputChannelCount == 8 || mAudioFormat.outputChannelCount == 4))
 		{
-			auto chunks = inputSampleCount / 16;
-			const __m256i shuffle_mask = mAudioFormat.outputChannelCount == 8
-				?
-				_mm256_setr_epi8(
-					0, 1, 2, 3, 6, 7, 4, 5, 12, 13, 14, 15, 8, 9, 10, 11,
-					0, 1, 2, 3, 6, 7, 4, 5, 12, 13, 14, 15, 8, 9, 10, 11
-				)
-				:
-				_mm256_setr_epi8(
-					0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 10, 11, 14, 15, 12, 13,
-					0, 1, 2, 3, 6, 7, 4, 5, 8, 9, 10, 11, 14, 15, 12, 13
-				);
-			for (auto j = 0; j < chunks; j++)
-			{
-				__m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputSamples + i));
-				__m256i shuffled = _mm256_shuffle_epi8(samples, shuffle_mask);
-				_mm256_storeu_si256(reinterpret_cast<__m256i*>(outputSamples + i), shuffled);
-				i += 16;
-			}
-		}
-		else if (mAudioFormat.outputChannelCount == 6)
-		{
-			// ignore, alignment issues in writing 96 bytes from each lane, maybe use sse instead?
+			i = reorder_channels_avx2(inputSamples, outputSamples, inputSampleCount, mAudioFormat.outputChannelCount);
 		}
-		#endif
+		// 6 channels is left to the scalar path, alignment issues in writing 96 bytes from each lane, maybe use sse instead?
 		// input is 1 2 3 4 5 6 7 8 repeating but have to swap 3 and 4 & 5/6 7/8
 		if (mAudioFormat.outputChannelCount == 8)
 		{
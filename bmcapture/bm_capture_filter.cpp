@@ -15,6 +15,7 @@
 #include "bm_capture_filter.h"
 #include "bm_audio_capture_pin.h"
 #include "bm_video_capture_pin.h"
+#include "preview_video_pin.h"
 
 #define REG_KEY_BASE L"BMCapture"
 
@@ -48,7 +49,7 @@ CUnknown* blackmagic_capture_filter::CreateInstance(LPUNKNOWN punk, HRESULT* phr
 	return pNewObject;
 }
 
-void blackmagic_capture_filter::LoadFormat(video_format* videoFormat, const video_signal* videoSignal)
+void blackmagic_capture_filter::LoadFormat(video_format* videoFormat, const video_signal* videoSignal) const
 {
 	videoFormat->cx = videoSignal->cx;
 	videoFormat->cy = videoSignal->cy;
@@ -69,10 +70,10 @@ void blackmagic_capture_filter::LoadFormat(video_format* videoFormat, const vide
 		videoFormat->pixelFormat = AY10;
 		break;
 	case bmdFormat8BitARGB:
-		videoFormat->pixelFormat = RGBA; // seems dubious but appears to work in practice
+		videoFormat->pixelFormat = ARGB;
 		break;
 	case bmdFormat8BitBGRA:
-		videoFormat->pixelFormat = RGBA; // seems dubious but appears to work in practice
+		videoFormat->pixelFormat = BGRA;
 		break;
 	case bmdFormat10BitRGB:
 		videoFormat->pixelFormat = R210;
@@ -95,6 +96,12 @@ void blackmagic_capture_filter::LoadFormat(video_format* videoFormat, const vide
 		// unsupported
 		break;
 	}
+	// each field of an interlaced signal becomes a progressive frame
+	if (IsDeinterlaced(GetDeinterlaceMode(), to_field_order(videoSignal->fieldDominance), videoFormat->pixelFormat))
+	{
+		videoFormat->fps *= 2;
+		videoFormat->frameInterval /= 2;
+	}
 	videoFormat->quantisation = videoFormat->pixelFormat.rgb ? QUANTISATION_FULL : QUANTISATION_UNKNOWN;
 	videoFormat->CalculateDimensions();
 }
@@ -472,13 +479,6 @@ blackmagic_capture_filter::blackmagic_capture_filter(LPUNKNOWN punk, HRESULT* ph
 	// video pin must have a default format in order to ensure a renderer is present in the graph
 	LoadFormat(&mVideoFormat, &mVideoSignal);
 
-	// compatibility bodge for renderers (madvr) that don't resize buffers correctly at all times
-	if (mVideoSignal.pixelFormat == bmdFormat8BitARGB)
-	{
-		mVideoFormat.pixelFormat = RGBA;
-		mVideoFormat.CalculateDimensions();
-	}
-
 	#ifndef NO_QUILL
 	LOG_WARNING(
 		mLogData.logger,
@@ -488,14 +488,21 @@ blackmagic_capture_filter::blackmagic_capture_filter(LPUNKNOWN punk, HRESULT* ph
 		mVideoFormat.hdrMeta.transferFunction, mVideoFormat.imageSize);
 	#endif
 
-	auto vp = new blackmagic_video_capture_pin(phr, this, false, mVideoFormat);
-	vp->UpdateFrameWriterStrategy();
-	vp->ResizeMetrics(mVideoFormat.fps);
+	const auto cp = new blackmagic_video_capture_pin(phr, this, false, mVideoFormat);
+	cp->UpdateFrameWriterStrategy();
+	cp->ResizeMetrics(mVideoFormat.fps);
 
-	vp = new blackmagic_video_capture_pin(phr, this, true, mVideoFormat);
+	const auto vp = new blackmagic_video_capture_pin(phr, this, true, mVideoFormat);
 	vp->UpdateFrameWriterStrategy();
 	vp->ResizeMetrics(mVideoFormat.fps);
 
+	if (GetPreviewScale())
+	{
+		const auto pp = new preview_video_pin(phr, this, GetPreviewScale(), BM_DECKLINK);
+		pp->ResizeMetrics(mVideoFormat.fps);
+		cp->SetPreviewSink(pp->GetSink());
+	}
+
 	if (mDeviceInfo.audioChannelCount > 0 && mAudioCaptureEnabled)
 	{
 		mAudioSignal.bitDepth = 16;
@@ -541,6 +548,7 @@ void blackmagic_capture_filter::LoadSignalFromDisplayMode(video_signal* newSigna
 	newSignal->frameDurationScale = static_cast<uint16_t>(frameDurationScale);
 	newSignal->cx = newDisplayMode->GetWidth(); // NOLINT(clang-diagnostic-implicit-int-conversion)
 	newSignal->cy = newDisplayMode->GetHeight(); // NOLINT(clang-diagnostic-implicit-int-conversion)
+	newSignal->fieldDominance = newDisplayMode->GetFieldDominance();
 
 	BSTR displayModeStr = nullptr;
 	if (newDisplayMode->GetName(&displayModeStr) == S_OK)
@@ -1052,7 +1060,8 @@ HRESULT blackmagic_capture_filter::processVideoFrame(IDeckLinkVideoInputFrame* v
 
 		mVideoFormat = newVideoFormat;
 		mVideoFrame = std::make_shared<video_frame>(mLogData, newVideoFormat, frameNotificationTime, mVideoFrameTime,
-		                                            frameDuration, mCurrentVideoFrameIndex, videoFrame);
+		                                            frameDuration, mCurrentVideoFrameIndex,
+		                                            to_field_order(mVideoSignal.fieldDominance), videoFrame);
 	}
 
 	// signal listeners
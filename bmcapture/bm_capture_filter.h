@@ -154,7 +154,7 @@ public:
 	HRESULT processAudioPacket(IDeckLinkAudioInputPacket* audioPacket, const int64_t& frameNotificationTime, bool hasVideoFrame);
 
 protected:
-	static void LoadFormat(video_format* videoFormat, const video_signal* videoSignal);
+	void LoadFormat(video_format* videoFormat, const video_signal* videoSignal) const;
 	static void LoadSignalFromDisplayMode(video_signal* newSignal, IDeckLinkDisplayMode* newDisplayMode);
 	static void LoadFormat(audio_format* audioFormat, const audio_signal* audioSignal);
 
@@ -23,6 +23,7 @@
 
 #include "DeckLinkAPI_h.h"
 #include "domain.h"
+#include "deinterlace.h"
 #include "logging.h"
 
 struct device_info
@@ -51,6 +52,7 @@ struct video_signal
 	uint16_t frameDurationScale{24000};
 	uint16_t cx{3840};
 	uint16_t cy{2160};
+	BMDFieldDominance fieldDominance{bmdProgressiveFrame};
 	uint8_t aspectX{16};
 	uint8_t aspectY{9};
 	bool locked{false};
@@ -279,6 +281,17 @@ inline const char* to_string(BMDColorspace e)
 	}
 }
 
+// segmented frames carry a progressive picture split across two fields so are not deinterlaced
+inline field_order to_field_order(BMDFieldDominance e)
+{
+	switch (e)
+	{
+	case bmdUpperFieldFirst: return FIELD_ORDER_TOP_FIRST;
+	case bmdLowerFieldFirst: return FIELD_ORDER_BOTTOM_FIRST;
+	default: return FIELD_ORDER_PROGRESSIVE;
+	}
+}
+
 inline const char* to_string(BMDPixelFormat e)
 {
 	switch (e)
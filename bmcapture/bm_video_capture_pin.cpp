@@ -24,6 +24,9 @@ static int64_t get_steady_clock_uptime_mics()
 }
 
 
+// standard consumer formats, generally require conversion due to lack of native renderer support
+static const std::vector<pixel_format> convertibleFormats{YUV2, V210, R210, R12B, R12L, R10B, R10L, AY10, ARGB};
+
 blackmagic_video_capture_pin::blackmagic_video_capture_pin(HRESULT* phr, blackmagic_capture_filter* pParent,
                                                            bool pPreview, video_format pVideoFormat) :
 	hdmi_video_capture_pin(
@@ -33,18 +36,8 @@ blackmagic_video_capture_pin::blackmagic_video_capture_pin(HRESULT* phr, blackma
 		pPreview ? L"Preview" : L"Capture",
 		pPreview ? "VideoPreview" : "VideoCapture",
 		std::move(pVideoFormat),
-		{
-			// standard consumer formats
-			{YUV2, {YV16, YUV2_YV16}},
-			{V210, {P210, V210_P210}}, // supported natively by madvr
-			{R210, {RGB48, R210_BGR48}}, // supported natively by jrvr >= MC34
-			// unlikely to be seen in the wild so just fallback to RGB using decklink sdk
-			{AY10, {RGBA, ANY_RGB}},
-			{R12B, {RGBA, ANY_RGB}},
-			{R12L, {RGBA, ANY_RGB}},
-			{R10B, {RGBA, ANY_RGB}},
-			{R10L, {RGBA, ANY_RGB}},
-		},
+		conversion_registry<video_frame>::Instance().Fallbacks(convertibleFormats,
+		                                                       pParent->IsDitherTo8BitEnabled()),
 		BM_DECKLINK
 	)
 {
@@ -71,6 +64,7 @@ HRESULT blackmagic_video_capture_pin::GetDeliveryBuffer(IMediaSample** ppSample,
 			#endif
 
 			mHasSignal = false;
+			mNextField.reset();
 			break;
 		}
 		if (IsStreamStopped())
@@ -80,28 +74,40 @@ HRESULT blackmagic_video_capture_pin::GetDeliveryBuffer(IMediaSample** ppSample,
 			#endif
 
 			mHasSignal = false;
+			mNextField.reset();
 			BACKOFF;
 			continue;
 		}
-		// grab next frame 
-		DWORD dwRet = WaitForSingleObject(handle, 1000);
 
-		// unknown, try again
-		if (dwRet == WAIT_FAILED)
+		if (mNextField)
 		{
-			#ifndef NO_QUILL
-			LOG_TRACE_L1(mLogData.logger, "[{}] Wait for frame failed, retrying", mLogData.prefix);
-			#endif
-
-			mHasSignal = false;
-			continue;
+			// the second field of a deinterlaced frame follows the first without waiting for the next frame
+			mDeinterlacer.Render(1);
+			mCurrentFrame = std::move(mNextField);
 		}
-
-		if (dwRet == WAIT_OBJECT_0)
+		else
 		{
+			// grab next frame 
+			DWORD dwRet = WaitForSingleObject(handle, 1000);
+
+			// unknown, try again
+			if (dwRet == WAIT_FAILED)
+			{
+				#ifndef NO_QUILL
+				LOG_TRACE_L1(mLogData.logger, "[{}] Wait for frame failed, retrying", mLogData.prefix);
+				#endif
+
+				mHasSignal = false;
+				continue;
+			}
+
+			if (dwRet != WAIT_OBJECT_0)
+			{
+				continue;
+			}
+
 			mCurrentFrame = mFilter->GetVideoFrame();
 			auto newVideoFormat = mCurrentFrame->GetVideoFormat();
-			hasFrame = true;
 
 			mHasSignal = true;
 
@@ -113,45 +119,130 @@ HRESULT blackmagic_video_capture_pin::GetDeliveryBuffer(IMediaSample** ppSample,
 				continue;
 			}
 
-			retVal = video_capture_pin::GetDeliveryBuffer(ppSample, pStartTime, pEndTime, dwFlags);
-
-			if (FAILED(retVal))
+			const auto deinterlaced = IsDeinterlaced(mFilter->GetDeinterlaceMode(), mCurrentFrame->GetFieldOrder(),
+			                                         newVideoFormat.pixelFormat);
+			TrackDeinterlacing(deinterlaced);
+			if (deinterlaced)
 			{
-				hasFrame = false;
-
-				#ifndef NO_QUILL
-				LOG_WARNING(mLogData.logger,
-				            "[{}] Video frame buffered but unable to get delivery buffer, retry after backoff",
-				            mLogData.prefix);
-				#endif
+				// each field is a new picture so repeat detection (and inverse telecine) is off while deinterlacing
+				SplitFields();
 			}
-
-			if (hasFrame)
+			else
 			{
-				int64_t now;
-				mFilter->GetReferenceTime(&now);
-				mFrameTs.snap(now, BUFFER_ALLOCATED);
-
-				if (mFirst)
+				// a repeat is dropped before a buffer is even allocated for it
+				void* frameData;
+				mCurrentFrame->Start(&frameData);
+				const auto repeated = SkipRepeatedFrame(static_cast<const uint8_t*>(frameData),
+				                                        mCurrentFrame->GetLength());
+				mCurrentFrame->End();
+				if (repeated)
 				{
-					OnChangeMediaType();
+					// the next frame delivered follows on from this one
+					mFrameCounter = mCurrentFrame->GetFrameIndex();
+					mCurrentFrame.reset();
+					continue;
 				}
 			}
-			else
+		}
+		hasFrame = true;
+
+		retVal = video_capture_pin::GetDeliveryBuffer(ppSample, pStartTime, pEndTime, dwFlags);
+
+		if (FAILED(retVal))
+		{
+			hasFrame = false;
+
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger,
+			            "[{}] Video frame buffered but unable to get delivery buffer, retry after backoff",
+			            mLogData.prefix);
+			#endif
+		}
+
+		if (hasFrame)
+		{
+			int64_t now;
+			mFilter->GetReferenceTime(&now);
+			mFrameTs.snap(now, BUFFER_ALLOCATED);
+
+			if (mFirst)
 			{
-				mCurrentFrame.reset();
-				SHORT_BACKOFF;
+				OnChangeMediaType();
 			}
 		}
+		else
+		{
+			mCurrentFrame.reset();
+			mNextField.reset();
+			SHORT_BACKOFF;
+		}
 	}
 	return retVal;
 }
 
+/**
+ * Deinterlacing starts, stops or changes as the registry setting or the field order of the signal changes, repeat
+ * detection only applies to frames which are not deinterlaced.
+ */
+void blackmagic_video_capture_pin::TrackDeinterlacing(bool deinterlaced)
+{
+	const auto mode = deinterlaced ? mFilter->GetDeinterlaceMode() : DEINTERLACE_OFF;
+	const auto fieldOrder = deinterlaced ? mCurrentFrame->GetFieldOrder() : FIELD_ORDER_PROGRESSIVE;
+	if (mode == mDeinterlaceMode && fieldOrder == mFieldOrder)
+	{
+		return;
+	}
+
+	#ifndef NO_QUILL
+	if (deinterlaced)
+	{
+		LOG_INFO(mLogData.logger, "[{}] Deinterlacing {} frames ({}) at {:.3f} fps", mLogData.prefix,
+		         to_string(fieldOrder), to_string(mode), mVideoFormat.fps);
+	}
+	else
+	{
+		LOG_INFO(mLogData.logger, "[{}] Deinterlacing stopped at {:.3f} fps", mLogData.prefix, mVideoFormat.fps);
+	}
+	#endif
+
+	mDeinterlaceMode = mode;
+	mFieldOrder = fieldOrder;
+
+	// fields are numbered frame index * 2 + field so the counter is rebased to make the next frame delivered follow on
+	// from the last one rather than look like a jump over (or back across) many dropped frames
+	if (mFrameCounter != 0)
+	{
+		mFrameCounter = mCurrentFrame->GetFrameIndex() * (deinterlaced ? 2 : 1) - 1;
+	}
+}
+
+/**
+ * Replaces the current frame, woven from two fields, with the first of the two progressive frames deinterlaced from it,
+ * the second is delivered next.
+ */
+void blackmagic_video_capture_pin::SplitFields()
+{
+	const auto pixelFormat = mCurrentFrame->GetVideoFormat().pixelFormat;
+	const auto height = mCurrentFrame->GetHeight();
+	void* frameData;
+	mCurrentFrame->Start(&frameData);
+	mDeinterlacer.Load(static_cast<const uint8_t*>(frameData), mCurrentFrame->GetLength() / height, height,
+	                   pixelFormat, mFieldOrder, mDeinterlaceMode, mCurrentFrame->GetFrameIndex(),
+	                   mFilter->IsStreamingLoadEnabled(BM_DECKLINK));
+	mCurrentFrame->End();
+
+	// neither field holds on to the woven frame so its DeckLink buffer can be reused as soon as the filter lets go of it
+	const auto* fields = mDeinterlacer.Render(0);
+	mNextField = std::make_shared<video_frame>(*mCurrentFrame, 1, fields);
+	mCurrentFrame = std::make_shared<video_frame>(*mCurrentFrame, 0, fields);
+}
+
 HRESULT blackmagic_video_capture_pin::FillBuffer(IMediaSample* pms)
 {
 	auto retVal = S_OK;
 	auto endTime = mCurrentFrame->GetFrameTime();
 	auto startTime = endTime - mCurrentFrame->GetFrameDuration();
+	ApplyCadence(&startTime, &endTime);
 	pms->SetTime(&startTime, &endTime);
 	mPreviousFrameTime = mCurrentFrameTime;
 	mCurrentFrameTime = endTime;
@@ -162,7 +253,16 @@ HRESULT blackmagic_video_capture_pin::FillBuffer(IMediaSample* pms)
 
 	mFrameCounter = mCurrentFrame->GetFrameIndex();
 
+	if (mUpdatedMediaType)
+	{
+		CMediaType cmt(m_mt);
+		AM_MEDIA_TYPE* sendMediaType = CreateMediaType(&cmt);
+		pms->SetMediaType(sendMediaType);
+		DeleteMediaType(sendMediaType);
+		mUpdatedMediaType = false;
+	}
 	AppendHdrSideDataIfNecessary(pms, endTime);
+	AppendActiveAreaSideDataIfNecessary(pms, endTime);
 
 	int64_t now;
 	mFilter->GetReferenceTime(&now);
@@ -172,6 +272,7 @@ HRESULT blackmagic_video_capture_pin::FillBuffer(IMediaSample* pms)
 	{
 		return S_FALSE;
 	}
+	PreviewDelivered(pms);
 
 	mFrameTs.snap(mCurrentFrame->GetCaptureTime(), WAIT_COMPLETE);
 	mFilter->GetReferenceTime(&now);
@@ -242,6 +343,9 @@ void blackmagic_video_capture_pin::DoThreadDestroy()
 	LOG_INFO(mLogData.logger, "[{}] blackmagic_video_capture_pin::DoThreadDestroy", mLogData.prefix);
 	#endif
 
+	mNextField.reset();
+	mDeinterlacer.Reset();
+
 	mFilter->PinThreadDestroyed();
 }
 
@@ -26,6 +26,7 @@
 #include "VideoFrameWriter.h"
 #include "any_rgb.h"
 #include "straight_through.h"
+#include "deinterlace.h"
 #include <memory>
 
 class blackmagic_video_capture_pin final :
@@ -54,25 +55,28 @@ protected:
 	std::shared_ptr<video_frame> mCurrentFrame;
 
 private:
+	// notes a change in whether (and how) frames are deinterlaced
+	void TrackDeinterlacing(bool deinterlaced);
+	void SplitFields();
+
+	deinterlacer mDeinterlacer;
+	// the second field of the last frame deinterlaced, if not yet delivered
+	std::shared_ptr<video_frame> mNextField;
+	deinterlace_mode mDeinterlaceMode{DEINTERLACE_OFF};
+	field_order mFieldOrder{FIELD_ORDER_PROGRESSIVE};
+
 	void OnFrameWriterStrategyUpdated() override
 	{
 		switch (mFrameWriterStrategy)
 		{
 		case ANY_RGB:
 			mFrameWriter = std::make_unique<any_rgb>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
+			ConfigureFrameWriter();
 			break;
 		case STRAIGHT_THROUGH:
 			mFrameWriter = std::make_unique<straight_through>(mLogData, mVideoFormat.cx, mVideoFormat.cy,
 				&mVideoFormat.pixelFormat);
-			break;
-		case YUY2_YV16:
-		case Y210_P210:
-		case UYVY_YV16:
-		case BGR10_BGR48:
-			#ifndef NO_QUILL
-			LOG_ERROR(mLogData.logger, "[{}] Conversion strategy {} is not supported by bmcapture",
-				mLogData.prefix, to_string(mFrameWriterStrategy));
-			#endif
+			ConfigureFrameWriter();
 			break;
 		default:
 			hdmi_video_capture_pin::OnFrameWriterStrategyUpdated();
@@ -22,7 +22,9 @@ class straight_through : public IVideoFrameWriter<video_frame>
 {
 public:
 	straight_through(const log_data& pLogData, int pX, int pY, const pixel_format* pPixelFormat)
-		: IVideoFrameWriter(pLogData, pX, pY, pPixelFormat)
+		: IVideoFrameWriter(pLogData, pX, pY, pPixelFormat),
+		  mHeight(pY),
+		  mLumaBytes(PlanarLumaBytes(*pPixelFormat))
 	{
 	}
 
@@ -36,7 +38,28 @@ public:
 		}
 		// TODO handle padding?
 
-		return srcFrame->CopyData(dstFrame);
+		BYTE* out;
+		auto hr = dstFrame->GetPointer(&out);
+		if (FAILED(hr))
+		{
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger, "[{}] Unable to fill buffer , can't get pointer to output buffer [{:#08x}]",
+			            mLogData.prefix, hr);
+			#endif
+
+			return S_FALSE;
+		}
+
+		void* data;
+		srcFrame->Start(&data);
+		CopyMeasured(out, static_cast<const uint8_t*>(data), srcFrame->GetLength(), mHeight, mLumaBytes);
+		srcFrame->End();
+
+		return S_OK;
 	}
+
+private:
+	int mHeight;
+	int mLumaBytes;
 };
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@
 
 #include <DeckLinkAPI_h.h>
 #include "domain.h"
+#include "deinterlace.h"
 #include "logging.h"
 #include <strmif.h>
 
@@ -30,12 +31,13 @@ class video_frame
 {
 public:
 	video_frame(log_data logData, video_format format, int64_t captureTime, int64_t frameTime, int64_t duration,
-	            uint64_t index, IDeckLinkVideoFrame* frame) :
+	            uint64_t index, field_order fieldOrder, IDeckLinkVideoFrame* frame) :
 		mFormat(std::move(format)),
 		mCaptureTime(captureTime),
 		mFrameTime(frameTime),
 		mFrameDuration(duration),
 		mFrameIndex(index),
+		mFieldOrder(fieldOrder),
 		mLogData(std::move(logData)),
 		mFrame(frame)
 	{
@@ -51,48 +53,51 @@ public:
 		mLength = frame->GetRowBytes() * mFormat.cy;
 	}
 
+	/**
+	 * A progressive frame holding one field of a deinterlaced frame, it lasts half as long as the frame & is numbered as
+	 * if the signal were progressive at the field rate. The data belongs to the deinterlacer.
+	 */
+	video_frame(const video_frame& frame, int field, const uint8_t* data) :
+		mFormat(frame.mFormat),
+		mCaptureTime(frame.mCaptureTime),
+		mFrameTime(frame.mFrameTime - (1 - field) * (frame.mFrameDuration / 2)),
+		mFrameDuration(frame.mFrameDuration / 2),
+		mFrameIndex(frame.mFrameIndex * 2 + field),
+		mLength(frame.mLength),
+		mData(data),
+		mLogData(frame.mLogData)
+	{
+	}
+
 	~video_frame()
 	{
+		if (!mBuffer)
+		{
+			return;
+		}
 		auto ct = mBuffer->Release();
 		#ifndef NO_QUILL
 		LOG_TRACE_L3(mLogData.logger, "[{}] VideoFrame Access (del) {} {}", mLogData.prefix, mFrameIndex, ct);
 		#endif
 	}
 
-	HRESULT CopyData(IMediaSample* dst) const
+	void Start(void** data) const
 	{
-		BYTE* out;
-		auto hr = dst->GetPointer(&out);
-		if (FAILED(hr))
+		if (mData)
 		{
-			#ifndef NO_QUILL
-			LOG_WARNING(mLogData.logger, "[{}] Unable to fill buffer , can't get pointer to output buffer [{:#08x}]",
-			            mLogData.prefix, hr);
-			#endif
-
-			return S_FALSE;
+			*data = const_cast<uint8_t*>(mData);
+			return;
 		}
-
-		mBuffer->StartAccess(bmdBufferAccessRead);
-
-		void* data;
-		mBuffer->GetBytes(&data);
-		memcpy(out, data, mLength);
-
-		mBuffer->EndAccess(bmdBufferAccessRead);
-
-		return S_OK;
-	}
-
-	void Start(void** data) const
-	{
 		mBuffer->StartAccess(bmdBufferAccessRead);
 		mBuffer->GetBytes(data);
 	}
 
 	void End() const
 	{
-		mBuffer->EndAccess(bmdBufferAccessRead);
+		if (mBuffer)
+		{
+			mBuffer->EndAccess(bmdBufferAccessRead);
+		}
 	}
 
 	uint64_t GetFrameIndex() const { return mFrameIndex; }
@@ -111,6 +116,8 @@ public:
 
 	long GetLength() const { return mLength; }
 
+	field_order GetFieldOrder() const { return mFieldOrder; }
+
 	IDeckLinkVideoFrame* GetRawFrame() const { return mFrame; }
 
 private:
@@ -120,6 +127,9 @@ private:
 	int64_t mFrameDuration{0};
 	uint64_t mFrameIndex{0};
 	long mLength{0};
+	field_order mFieldOrder{FIELD_ORDER_PROGRESSIVE};
+	// set instead of the buffer when this frame is a deinterlaced field
+	const uint8_t* mData{nullptr};
 	IDeckLinkVideoFrame* mFrame = nullptr;
 	IDeckLinkVideoBuffer* mBuffer = nullptr;
 	log_data mLogData;
@@ -21,19 +21,88 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
+#include <iterator>
+#include <type_traits>
+#include <utility>
 #include <intsafe.h>
 #include <strmif.h>
 #include <dvdmedia.h>
 #include "domain.h"
 #include "logging.h"
+#include "cpu_features.h"
+#include "conversion_pool.h"
+#include "frame_copy.h"
+#include "light_level.h"
+#include "active_area.h"
+#include "preview.h"
 
 #define S_PADDING_POSSIBLE    ((HRESULT)200L)
 
+// lines converted before they are measured, few enough that the luma just written is still in L1
+inline constexpr int measuredChunkLines = 8;
+
+// bytes per sample of the luma plane that starts a planar format, 0 if the format is not planar
+inline int PlanarLumaBytes(const pixel_format& pf)
+{
+	switch (pf.format)
+	{
+	case pixel_format::P010:
+	case pixel_format::P210:
+		return 2;
+	case pixel_format::NV12:
+	case pixel_format::NV16:
+	case pixel_format::YV16:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// widths of almost every real source, kernels are instantiated for each so that group counts & line tails are constants
+inline constexpr int specialisedWidths[] = {1280, 1920, 2048, 3840, 4096, 7680};
+
+// how the source frame memory is mapped, DMA targets may be write combined or uncached which makes regular loads slow
+enum source_memory : uint8_t
+{
+	SOURCE_CACHED,
+	SOURCE_WRITE_COMBINED
+};
+
+inline const char* to_string(source_memory e)
+{
+	switch (e)
+	{
+	case SOURCE_CACHED: return "cached";
+	case SOURCE_WRITE_COMBINED: return "write combined";
+	default: return "unknown";
+	}
+}
+
+// the measurements taken of the luma of a frame as it is converted, null for any not being taken
+struct luma_measures
+{
+	light_level_frame* lightLevel{nullptr};
+	active_area_frame* activeArea{nullptr};
+};
+
+// a destination plane for ConvertPlanes
+struct output_plane
+{
+	uint8_t* data;
+	// bytes per line
+	int stride;
+	// log2 of the vertical chroma subsampling, i.e. 1 for the UV plane of a 4:2:0 format
+	int vShift{0};
+};
+
 template<typename VF>
 class IVideoFrameWriter
 {
 public:
-	IVideoFrameWriter(log_data pLogData, int pX, int pY, const pixel_format* pPixelFormat) : mLogData(std::move(pLogData))
+	IVideoFrameWriter(log_data pLogData, int pX, int pY, const pixel_format* pPixelFormat) :
+		mLogData(std::move(pLogData)),
+		mWidth(pX),
+		mOutputBytesPerSample(pPixelFormat->bitDepth > 8 ? 2 : 1)
 	{
 		pPixelFormat->GetImageDimensions(pX, pY, &mOutputRowLength, &mOutputImageSize);
 	}
@@ -42,8 +111,354 @@ public:
 
 	virtual HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) = 0;
 
+	cpu_isa GetIsa() const
+	{
+		return mIsa;
+	}
+
+	// the width the kernel was compiled for, 0 if it handles any width
+	int GetSpecialisedWidth() const
+	{
+		return mSpecialisedWidth;
+	}
+
+	// pixels the renderer asked to pad each line by, the sample's stride is the width plus this
+	int GetPixelsToPad() const
+	{
+		return mPixelsToPad;
+	}
+
+	// frames are converted in stripes on the pool when one is set, the pool is owned by the pin & outlives the writer
+	void SetConversionPool(conversion_pool* pPool)
+	{
+		mPool = pPool;
+	}
+
+	// planar outputs are staged in cache in tiles of this many lines, 0 writes each line directly to the sample
+	void SetTileLines(int pTileLines)
+	{
+		const auto tileLines = std::clamp(pTileLines, 0, maxConversionTileLines) & ~1;
+		if (tileLines != mTileLines)
+		{
+			#ifndef NO_QUILL
+			LOG_INFO(mLogData.logger, "[{}] Staging output in tiles of {} lines", mLogData.prefix, tileLines);
+			#endif
+			mTileLines = tileLines;
+		}
+	}
+
+	void SetSourceMemory(source_memory pSourceMemory)
+	{
+		if (pSourceMemory != mSourceMemory)
+		{
+			#ifndef NO_QUILL
+			LOG_INFO(mLogData.logger, "[{}] Reading {} source frames", mLogData.prefix, to_string(pSourceMemory));
+			#endif
+			mSourceMemory = pSourceMemory;
+		}
+	}
+
+	// writers with a 10-bit luma output measure the light level of each frame into the meter while it is enabled, the
+	// meter is owned by the pin & outlives the writer
+	void SetLightLevelMeter(light_level_meter* pMeter)
+	{
+		mLightLevelMeter = pMeter;
+	}
+
+	// writers with a planar luma output find the active area of each frame into the meter while it is enabled, the
+	// meter is owned by the pin & outlives the writer
+	void SetActiveAreaMeter(active_area_meter* pMeter)
+	{
+		mActiveAreaMeter = pMeter;
+	}
+
+	// writers with a planar output box filter a frame into the sink whenever the preview pin is due one, the pin
+	// point samples the delivered frame for any other writer, the sink is owned by the preview pin & outlives the writer
+	void SetPreviewSink(preview_sink* pSink)
+	{
+		mPreviewSink = pSink;
+	}
+
 protected:
-	HRESULT CheckFrameSizes(uint64_t frameIndex, long srcSize, IMediaSample* dstFrame)
+	// the measures of this frame wanted by the enabled meters, only writers with a 10-bit luma output offer lightLevel
+	luma_measures StartMeasuring(light_level_frame* lightLevel, active_area_frame* activeArea) const
+	{
+		return {
+			.lightLevel = mLightLevelMeter && mLightLevelMeter->IsEnabled() ? lightLevel : nullptr,
+			.activeArea = mActiveAreaMeter && mActiveAreaMeter->IsEnabled() ? activeArea : nullptr
+		};
+	}
+
+	void EndMeasuring(const luma_measures& measures, int width, int height) const
+	{
+		if (measures.lightLevel)
+		{
+			mLightLevelMeter->AddFrame(*measures.lightLevel);
+		}
+		if (measures.activeArea)
+		{
+			mActiveAreaMeter->AddFrame(*measures.activeArea, width, height);
+		}
+	}
+
+	/**
+	 * Calls convert(line, lineCount), relative to the lines passed to a ConvertPlanes callback, in chunks of a few lines
+	 * and measures each chunk of the luma output (of T, i.e. 8 or 16-bit samples) as soon as it is written, i.e. while
+	 * it is still in cache, so measuring never reads the frame back from memory. firstLine is the line of the frame
+	 * the callback starts at. The lines are converted in one call if nothing is being measured.
+	 */
+	template <typename T, typename F>
+	void ConvertMeasured(const luma_measures& measures, const uint8_t* luma, int lumaStride, int width, int firstLine,
+	                     int lineCount, F&& convert)
+	{
+		if (measures.lightLevel == nullptr && measures.activeArea == nullptr)
+		{
+			convert(0, lineCount);
+			return;
+		}
+		light_level_lines lightLevel;
+		active_area_lines activeArea;
+		for (int line = 0; line < lineCount; line += measuredChunkLines)
+		{
+			const int lines = std::min(measuredChunkLines, lineCount - line);
+			convert(line, lines);
+			const auto* chunk = luma + static_cast<size_t>(line) * lumaStride;
+			if constexpr (sizeof(T) == 2)
+			{
+				if (measures.lightLevel)
+				{
+					lightLevel.Add(chunk, lumaStride, width, firstLine + line, lines);
+				}
+			}
+			if (measures.activeArea)
+			{
+				activeArea.Add<T>(chunk, lumaStride, width, firstLine + line, lines);
+			}
+		}
+		if (measures.lightLevel)
+		{
+			measures.lightLevel->Merge(lightLevel);
+		}
+		if (measures.activeArea)
+		{
+			measures.activeArea->Merge(activeArea);
+		}
+	}
+
+	/**
+	 * Copies a frame already in the output format, as copy_frame would, for writers which pass the source straight
+	 * through. When a meter is enabled and the output has a planar luma plane of lumaBytes per sample, the luma plane is
+	 * copied a few lines at a time and each chunk measured from the source lines that were just read, so measuring never
+	 * reads the frame a second time.
+	 */
+	void CopyMeasured(uint8_t* dst, const uint8_t* src, size_t len, int height, int lumaBytes)
+	{
+		light_level_frame lightLevel;
+		active_area_frame activeArea;
+		const auto measures = StartMeasuring(lumaBytes == 2 ? &lightLevel : nullptr,
+		                                     lumaBytes > 0 ? &activeArea : nullptr);
+		const auto lumaLen = static_cast<size_t>(mOutputRowLength) * height;
+		if ((measures.lightLevel == nullptr && measures.activeArea == nullptr) || lumaLen > len)
+		{
+			copy_frame(dst, src, len);
+			return;
+		}
+		// chunks are small so decide how to copy from the size of the whole frame
+		const auto streaming = len >= streamingCopyThreshold;
+		const auto copy = [streaming](uint8_t* d, const uint8_t* s, size_t n)
+		{
+			if (streaming)
+			{
+				copy_streaming(d, s, n);
+			}
+			else
+			{
+				memcpy(d, s, n);
+			}
+		};
+		const auto copyLines = [&](int line, int lines)
+		{
+			const auto offset = static_cast<size_t>(line) * mOutputRowLength;
+			copy(dst + offset, src + offset, static_cast<size_t>(lines) * mOutputRowLength);
+		};
+		const auto stride = static_cast<int>(mOutputRowLength);
+		if (lumaBytes == 2)
+		{
+			ConvertMeasured<uint16_t>(measures, src, stride, mWidth, 0, height, copyLines);
+		}
+		else
+		{
+			ConvertMeasured<uint8_t>(measures, src, stride, mWidth, 0, height, copyLines);
+		}
+		copy(dst + lumaLen, src + lumaLen, len - lumaLen);
+		EndMeasuring(measures, mWidth, height);
+	}
+
+	/**
+	 * Calls convert(srcLines, firstLine, lineCount) for each stripe of the frame, in parallel if there is a pool.
+	 * srcLines points to the source data for firstLine which, for a write combined source, is a copy of the lines in
+	 * a cache resident bounce tile read via streaming loads. Every call but the last in a frame covers an even number of
+	 * lines so 4:2:0 outputs can always pair up lines, each stripe starts on a multiple of groupLines.
+	 */
+	template <typename F>
+	void ConvertStripes(const uint8_t* src, int srcStride, int height, F&& convert, int groupLines = 2)
+	{
+		auto convertStripe = [&](int firstLine, int lineCount)
+		{
+			if (mSourceMemory == SOURCE_CACHED)
+			{
+				convert(src + static_cast<size_t>(firstLine) * srcStride, firstLine, lineCount);
+				return;
+			}
+			const int linesPerTile = std::max(2, static_cast<int>(bounceTileSize / srcStride) & ~1);
+			uint8_t* tile = GetBounceTile(static_cast<size_t>(linesPerTile) * srcStride);
+			for (int line = firstLine; line < firstLine + lineCount; line += linesPerTile)
+			{
+				const int lines = std::min(linesPerTile, firstLine + lineCount - line);
+				copy_streaming_load(tile, src + static_cast<size_t>(line) * srcStride,
+				                    static_cast<size_t>(lines) * srcStride);
+				convert(tile, line, lines);
+			}
+		};
+		if (mPool == nullptr || mPool->GetStripeCount() < 2 || height < 2 * mPool->GetStripeCount())
+		{
+			convertStripe(0, height);
+		}
+		else
+		{
+			mPool->Run(height, convertStripe, groupLines);
+		}
+	}
+
+	/**
+	 * As per ConvertStripes for a kernel which writes to several planes, convert(srcLines, lineCount, dst) is passed the
+	 * address of the first line to write in each plane. A callback which measures the frame may instead take
+	 * (srcLines, firstLine, lineCount, dst) to also be told which line of the frame it starts at.
+	 *
+	 * In tiled mode, the kernel writes tiles of mTileLines lines of each plane to a cache resident staging area which is
+	 * then streamed to the sample a whole tile at a time. This keeps the kernel's stores, which otherwise alternate
+	 * between planes that are megabytes apart, within a few pages & leaves the sample to be written in long sequential
+	 * runs of non temporal stores.
+	 *
+	 * When the preview pin is due a frame, each tile (or, if not tiled, each group of previewGroupLines) is box
+	 * filtered into the preview straight after it is converted so the preview never reads the sample back from memory.
+	 */
+	template <size_t P, typename F>
+	void ConvertPlanes(const uint8_t* src, int srcStride, int height, const output_plane (&planes)[P], F&& convert)
+	{
+		static_assert(P == 2 || P == 3, "planar outputs are Y followed by UV or by U & V");
+		auto convertLines = [&](const uint8_t* srcLines, int firstLine, int lineCount, uint8_t* const* dst)
+		{
+			if constexpr (std::is_invocable_v<F&, const uint8_t*, int, int, uint8_t* const*>)
+			{
+				convert(srcLines, firstLine, lineCount, dst);
+			}
+			else
+			{
+				convert(srcLines, lineCount, dst);
+			}
+		};
+		preview_frame* preview = nullptr;
+		int strides[P];
+		for (size_t p = 0; p < P; ++p)
+		{
+			strides[p] = planes[p].stride;
+		}
+		if (mPreviewSink)
+		{
+			preview = mPreviewSink->Begin({
+				.width = std::min(mWidth, planes[0].stride / mOutputBytesPerSample),
+				.height = height,
+				.bytesPerSample = mOutputBytesPerSample,
+				.planes = static_cast<int>(P),
+				.chromaVShift = planes[1].vShift
+			});
+		}
+		ConvertStripes(src, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			preview_lines previewLines(preview);
+			uint8_t* dst[P];
+			if (mTileLines == 0)
+			{
+				const int chunkLines = preview ? previewGroupLines : lineCount;
+				for (int line = 0; line < lineCount; line += chunkLines)
+				{
+					const int lines = std::min(chunkLines, lineCount - line);
+					for (size_t p = 0; p < P; ++p)
+					{
+						const auto planeLine = static_cast<size_t>((firstLine + line) >> planes[p].vShift);
+						dst[p] = planes[p].data + planeLine * planes[p].stride;
+					}
+					convertLines(srcLines + static_cast<size_t>(line) * srcStride, firstLine + line, lines, dst);
+					previewLines.Add(dst, strides, firstLine + line, lines);
+				}
+				return;
+			}
+
+			// each plane's tile is followed by some slack as kernels may store a vector beyond the end of a line
+			size_t tileSize[P];
+			size_t stagingSize = 0;
+			for (size_t p = 0; p < P; ++p)
+			{
+				tileSize[p] = static_cast<size_t>(mTileLines >> planes[p].vShift) * planes[p].stride;
+				stagingSize += (tileSize[p] + 64 + 63) & ~static_cast<size_t>(63);
+			}
+			uint8_t* staging = GetStagingTile(stagingSize);
+			for (int line = 0; line < lineCount; line += mTileLines)
+			{
+				const int lines = std::min(mTileLines, lineCount - line);
+				uint8_t* tile = staging;
+				for (size_t p = 0; p < P; ++p)
+				{
+					dst[p] = tile;
+					tile += (tileSize[p] + 64 + 63) & ~static_cast<size_t>(63);
+				}
+				convertLines(srcLines + static_cast<size_t>(line) * srcStride, firstLine + line, lines, dst);
+				previewLines.Add(dst, strides, firstLine + line, lines);
+				// tiles start on an even line so a subsampled plane never shares a line between tiles
+				for (size_t p = 0; p < P; ++p)
+				{
+					const auto shift = planes[p].vShift;
+					copy_streaming(planes[p].data + static_cast<size_t>((firstLine + line) >> shift) * planes[p].stride,
+					               dst[p], static_cast<size_t>(lines >> shift) * planes[p].stride);
+				}
+			}
+		}, preview ? previewGroupLines : 2);
+		if (preview)
+		{
+			mPreviewSink->End(preview);
+		}
+	}
+
+	/**
+	 * Replaces convert with make.template operator()<width>() if width is one of specialisedWidths. Each kernel
+	 * specialised for a width must fall back to the generic one if it is ever passed a frame of a different width.
+	 */
+	template <typename Fn, typename Make>
+	void SpecialiseForWidth(int width, Fn& convert, Make&& make)
+	{
+		[&]<size_t... I>(std::index_sequence<I...>)
+		{
+			((width == specialisedWidths[I] && (convert = make.template operator()<specialisedWidths[I]>(),
+			                                    (mSpecialisedWidth = width) != 0)) || ...);
+		}(std::make_index_sequence<std::size(specialisedWidths)>{});
+	}
+
+	void LogKernel([[maybe_unused]] const char* conversion) const
+	{
+		#ifndef NO_QUILL
+		if (mSpecialisedWidth)
+		{
+			LOG_INFO(mLogData.logger, "[{}] Using {} kernel specialised for width {} for {} conversion (cpu: {})",
+				mLogData.prefix, to_string(mIsa), mSpecialisedWidth, conversion, GetCpuFeatures().brand);
+			return;
+		}
+		LOG_INFO(mLogData.logger, "[{}] Using {} kernel for {} conversion (cpu: {})", mLogData.prefix,
+			to_string(mIsa), conversion, GetCpuFeatures().brand);
+		#endif
+	}
+
+	HRESULT CheckFrameSizes([[maybe_unused]] uint64_t frameIndex, long srcSize, IMediaSample* dstFrame)
 	{
 		auto sizeDelta = srcSize - dstFrame->GetSize();
 		if (sizeDelta > 0)
@@ -93,8 +508,19 @@ protected:
 	}
 
 	log_data mLogData;
+	// pixels per line of the frames converted
+	int mWidth;
+	int mOutputBytesPerSample;
 	DWORD mOutputImageSize{0};
 	DWORD mOutputRowLength{0};
 	int mPixelsToPad{0};
+	cpu_isa mIsa{ISA_SCALAR};
+	int mSpecialisedWidth{0};
+	int mTileLines{0};
+	conversion_pool* mPool{nullptr};
+	source_memory mSourceMemory{SOURCE_CACHED};
+	light_level_meter* mLightLevelMeter{nullptr};
+	active_area_meter* mActiveAreaMeter{nullptr};
+	preview_sink* mPreviewSink{nullptr};
 };
 #endif
\ No newline at end of file
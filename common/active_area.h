@@ -0,0 +1,254 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ACTIVE_AREA_HEADER
+#define ACTIVE_AREA_HEADER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <mutex>
+#include <emmintrin.h>
+#include "domain.h"
+
+// 8-bit luma codes above this are picture rather than bar, high enough to ignore noise in the bars (which are
+// nominally 16) & low enough that all but the darkest content counts
+inline constexpr int activeAreaThreshold = 32;
+// the reported area is the union of that measured over this many seconds of frames so a dark scene, in which the
+// edges of the picture may read as black, does not shrink it
+inline constexpr size_t activeAreaWindowSeconds = 5;
+
+namespace active_area_detail
+{
+	// 1 bits for each byte of a bright sample in the 16 bytes at p
+	template <typename T>
+	uint32_t BrightMask(const T* p)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i black;
+		if constexpr (sizeof(T) == 1)
+		{
+			black = _mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8(activeAreaThreshold)), _mm_setzero_si128());
+		}
+		else
+		{
+			// 10-bit codes are held in the most significant bits
+			black = _mm_cmpeq_epi16(_mm_subs_epu16(v, _mm_set1_epi16(activeAreaThreshold << 8)), _mm_setzero_si128());
+		}
+		return ~static_cast<uint32_t>(_mm_movemask_epi8(black)) & 0xFFFF;
+	}
+
+	template <typename T>
+	bool IsBright(T sample)
+	{
+		return sample > (sizeof(T) == 1 ? activeAreaThreshold : activeAreaThreshold << 8);
+	}
+
+	// the first bright sample in [from, width), width if there is none
+	template <typename T>
+	int FirstBright(const T* y, int from, int width)
+	{
+		constexpr int lanes = 16 / sizeof(T);
+		int x = from;
+		for (; x + lanes <= width; x += lanes)
+		{
+			if (const auto mask = BrightMask(y + x))
+			{
+				return x + std::countr_zero(mask) / static_cast<int>(sizeof(T));
+			}
+		}
+		for (; x < width; ++x)
+		{
+			if (IsBright(y[x]))
+			{
+				return x;
+			}
+		}
+		return width;
+	}
+
+	// the last bright sample in [from, width), -1 if there is none
+	template <typename T>
+	int LastBright(const T* y, int from, int width)
+	{
+		constexpr int lanes = 16 / sizeof(T);
+		int x = width;
+		for (; x > from && (x - from) % lanes != 0; --x)
+		{
+			if (IsBright(y[x - 1]))
+			{
+				return x - 1;
+			}
+		}
+		for (; x > from; x -= lanes)
+		{
+			if (const auto mask = BrightMask(y + x - lanes))
+			{
+				return x - lanes + (31 - std::countl_zero(mask)) / static_cast<int>(sizeof(T));
+			}
+		}
+		return -1;
+	}
+}
+
+/**
+ * Bounds of the bright samples in the lines measured by one stripe, merged into the frame once the stripe is done.
+ */
+struct active_area_lines
+{
+	int top{INT_MAX};
+	int bottom{-1};
+	int left{INT_MAX};
+	int right{-1};
+
+	/**
+	 * Luma samples of 8 bits or 16 bits (holding a 10-bit code in the most significant bits). Once the bounds are
+	 * known, a picture line is only read until its first bright sample & from its end back to the rightmost bright
+	 * column found so far so, other than black lines, typically only the bars themselves are read.
+	 */
+	template <typename T>
+	void Add(const uint8_t* luma, int stride, int width, int firstLine, int lineCount)
+	{
+		for (int line = 0; line < lineCount; ++line)
+		{
+			const auto* y = reinterpret_cast<const T*>(luma + static_cast<size_t>(line) * stride);
+			const auto first = active_area_detail::FirstBright(y, 0, width);
+			if (first == width)
+			{
+				continue;
+			}
+			top = std::min(top, firstLine + line);
+			bottom = std::max(bottom, firstLine + line);
+			left = std::min(left, first);
+			right = std::max(right, active_area_detail::LastBright(y, std::max(first, right + 1), width));
+		}
+	}
+};
+
+/**
+ * Bounds of the bright samples in a frame, stripes converted in parallel merge their lines into it as they complete.
+ */
+struct active_area_frame
+{
+	std::atomic<int> top{INT_MAX};
+	std::atomic<int> bottom{-1};
+	std::atomic<int> left{INT_MAX};
+	std::atomic<int> right{-1};
+
+	void Merge(const active_area_lines& lines)
+	{
+		if (lines.bottom < 0)
+		{
+			return;
+		}
+		Update(top, lines.top, std::less{});
+		Update(bottom, lines.bottom, std::greater{});
+		Update(left, lines.left, std::less{});
+		Update(right, lines.right, std::greater{});
+	}
+
+private:
+	template <typename Cmp>
+	static void Update(std::atomic<int>& value, int candidate, Cmp cmp)
+	{
+		auto v = value.load(std::memory_order_relaxed);
+		while (cmp(candidate, v) && !value.compare_exchange_weak(v, candidate, std::memory_order_relaxed))
+		{
+		}
+	}
+};
+
+/**
+ * The active area, i.e. the picture inside any letterbox or pillarbox bars, of the frames converted by the writers.
+ * Frames which are entirely black say nothing about the bars so are ignored.
+ */
+class active_area_meter
+{
+public:
+	// writers only measure frames while the meter is enabled
+	void SetEnabled(bool pEnabled)
+	{
+		if (pEnabled != mEnabled.exchange(pEnabled, std::memory_order_relaxed) && !pEnabled)
+		{
+			std::lock_guard lock(mMutex);
+			mWindow.fill({});
+		}
+	}
+
+	bool IsEnabled() const
+	{
+		return mEnabled.load(std::memory_order_relaxed);
+	}
+
+	void AddFrame(const active_area_frame& frame, int width, int height)
+	{
+		const auto bottom = frame.bottom.load(std::memory_order_relaxed);
+		if (bottom < 0)
+		{
+			return;
+		}
+		std::lock_guard lock(mMutex);
+		auto& current = mWindow[mCurrent];
+		if (!current.exists() || current.width != width || current.height != height)
+		{
+			current = {
+				.top = INT_MAX, .bottom = -1, .left = INT_MAX, .right = -1, .width = width, .height = height
+			};
+		}
+		current.top = std::min(current.top, frame.top.load(std::memory_order_relaxed));
+		current.bottom = std::max(current.bottom, bottom);
+		current.left = std::min(current.left, frame.left.load(std::memory_order_relaxed));
+		current.right = std::max(current.right, frame.right.load(std::memory_order_relaxed));
+	}
+
+	// the union over the window, to be called once a second as it also moves the window on
+	active_area Measure()
+	{
+		std::lock_guard lock(mMutex);
+		active_area measured{};
+		// newest first, any seconds at a different resolution to the newest are from before a format change
+		for (size_t i = 0; i < mWindow.size(); ++i)
+		{
+			const auto& s = mWindow[(mCurrent + mWindow.size() - i) % mWindow.size()];
+			if (!s.exists())
+			{
+				continue;
+			}
+			if (!measured.exists())
+			{
+				measured = s;
+			}
+			else if (measured.width == s.width && measured.height == s.height)
+			{
+				measured.top = std::min(measured.top, s.top);
+				measured.bottom = std::max(measured.bottom, s.bottom);
+				measured.left = std::min(measured.left, s.left);
+				measured.right = std::max(measured.right, s.right);
+			}
+		}
+		mCurrent = (mCurrent + 1) % mWindow.size();
+		mWindow[mCurrent] = {};
+		return measured;
+	}
+
+private:
+	std::atomic<bool> mEnabled{false};
+	std::mutex mMutex;
+	std::array<active_area, activeAreaWindowSeconds> mWindow{};
+	size_t mCurrent{0};
+};
+#endif
@@ -0,0 +1,157 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ARGB_BGRA_HEADER
+#define ARGB_BGRA_HEADER
+
+#include "VideoFrameWriter.h"
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * 8-bit ARGB to BGRA (i.e. RGB32), each pixel is the same 32bit word with the byte order reversed.
+ */
+template <typename VF>
+class argb_bgra : public IVideoFrameWriter<VF>
+{
+public:
+	argb_bgra(const log_data& pLogData, uint32_t pX, uint32_t pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &BGRA)
+	{
+		const auto& cpu = GetCpuFeatures();
+		if (pMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		else if (pMaxIsa >= ISA_SSSE3 && cpu.Supports(ISA_SSSE3))
+		{
+			mConvert = convert_ssse3;
+			this->mIsa = ISA_SSSE3;
+		}
+		this->LogKernel("ARGB to BGRA");
+	}
+
+	~argb_bgra() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+
+		const int srcStride = width * 4;
+		const int dstStride = (width + this->mPixelsToPad) * 4;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvert(srcLines, srcStride, outData + static_cast<size_t>(firstLine) * dstStride, dstStride, width,
+			         lineCount);
+		});
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to BGRA in {:.3f} ms", this->mLogData.prefix,
+		             execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = void(*)(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+
+	static void convert_line_scalar(const uint32_t* srcLine, uint32_t* dstLine, int x, int width)
+	{
+		for (; x < width; ++x)
+		{
+			dstLine[x] = _byteswap_ulong(srcLine[x]);
+		}
+	}
+
+	EZ_TARGET_SSSE3
+	static void convert_ssse3(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+	{
+		const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+		const int simdWidth = width & ~3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(y) * srcStride);
+			uint32_t* dstLine = reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * dstStride);
+			for (int x = 0; x < simdWidth; x += 4)
+			{
+				const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcLine + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dstLine + x), _mm_shuffle_epi8(px, shuffle));
+			}
+			convert_line_scalar(srcLine, dstLine, simdWidth, width);
+		}
+	}
+
+	EZ_TARGET_AVX2
+	static void convert_avx2(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+		);
+		const int simdWidth = width & ~15;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(y) * srcStride);
+			uint32_t* dstLine = reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * dstStride);
+			for (int x = 0; x < simdWidth; x += 16) // 2 x 8 pixels per pass
+			{
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x + 8));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLine + x), _mm256_shuffle_epi8(a, shuffle));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLine + x + 8), _mm256_shuffle_epi8(b, shuffle));
+			}
+			convert_line_scalar(srcLine, dstLine, simdWidth, width);
+		}
+	}
+
+	static void convert_scalar(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			convert_line_scalar(reinterpret_cast<const uint32_t*>(src + static_cast<size_t>(y) * srcStride),
+			                    reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * dstStride), 0, width);
+		}
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
@@ -0,0 +1,180 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef AY10_P210_HEADER
+#define AY10_P210_HEADER
+
+#include "VideoFrameWriter.h"
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * AY10 is 10-bit 4:2:2:4 YUVA, each pixel is a big endian 32bit word holding 2 bits of padding then the chroma sample
+ * (Cb for even pixels, Cr for odd pixels), Y and A. Rows start on a 256-byte boundary.
+ *
+ * P210 carries the same 4:2:2 samples so the conversion is a straight repack, alpha is discarded.
+ */
+template <typename VF>
+class ay10_p210 : public IVideoFrameWriter<VF>
+{
+public:
+	ay10_p210(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &P210)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("AY10 to P210");
+	}
+
+	~ay10_p210() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		auto actualWidth = width + this->mPixelsToPad;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// P210 format: 16-bit samples, full res Y plane followed by a full height interleaved UV plane
+		auto outSpan = std::span(outData, dstSize);
+		auto planeSize = actualWidth * height * 2;
+
+		uint8_t* yPlane = outSpan.subspan(0, planeSize).data();
+		uint8_t* uvPlane = outSpan.subspan(planeSize, planeSize).data();
+
+		// Each row starts on 256-byte boundary
+		const int srcStride = (width * 4 + 255) / 256 * 256;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const auto dstStride = actualWidth * 2;
+		const output_plane planes[]{{yPlane, dstStride}, {uvPlane, dstStride}};
+		light_level_frame lightLevel;
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(&lightLevel, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint16_t>(measures, dst[0], dstStride, width, firstLine, lineCount,
+			                                         [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * dstStride,
+				         dst[1] + line * dstStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to P210 in {:.3f} ms", this->mLogData.prefix,
+		             execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad);
+
+	static void convert_line_scalar(const uint32_t* srcLine, uint16_t* dstLineY, uint16_t* dstLineUV, int x, int width)
+	{
+		for (; x < width; ++x)
+		{
+			const uint32_t srcPixel = _byteswap_ulong(srcLine[x]);
+			dstLineY[x] = static_cast<uint16_t>(srcPixel >> 4 & 0xFFC0);
+			// chroma alternates Cb, Cr which is exactly the P210 UV interleave
+			dstLineUV[x] = static_cast<uint16_t>(srcPixel >> 14 & 0xFFC0);
+		}
+	}
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                         int pixelsToPad)
+	{
+		// per lane pick (lo, hi) bytes of Y (bytes 2, 1) for the 4 pixels then chroma (bytes 1, 0)
+		const __m256i shuffle = _mm256_setr_epi8(
+			2, 1, 6, 5, 10, 9, 14, 13, 1, 0, 5, 4, 9, 8, 13, 12,
+			2, 1, 6, 5, 10, 9, 14, 13, 1, 0, 5, 4, 9, 8, 13, 12
+		);
+		// Y is at bits 13-4 and chroma at bits 11-2 of the picked words
+		const __m256i multiplier = _mm256_setr_epi16(16, 16, 16, 16, 4, 4, 4, 4, 16, 16, 16, 16, 4, 4, 4, 4);
+		const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFFC0));
+		const int effectiveWidth = width + pixelsToPad;
+		const int simdWidth = width & ~15;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + lineNo * srcStride);
+			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + lineNo * effectiveWidth * 2);
+
+			for (int x = 0; x < simdWidth; x += 16) // 16 pixels per pass = 1 ymm of Y and 1 ymm of UV
+			{
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x));
+				__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x + 8));
+				a = _mm256_and_si256(_mm256_mullo_epi16(_mm256_shuffle_epi8(a, shuffle), multiplier), mask);
+				b = _mm256_and_si256(_mm256_mullo_epi16(_mm256_shuffle_epi8(b, shuffle), multiplier), mask);
+				// 8 Y samples in the lower lane, 8 UV samples in the upper lane
+				a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+				b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(3, 1, 2, 0));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineY + x), _mm256_permute2x128_si256(a, b, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineUV + x), _mm256_permute2x128_si256(a, b, 0x31));
+			}
+			convert_line_scalar(srcLine, dstLineY, dstLineUV, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad)
+	{
+		auto effectiveWidth = width + pixelsToPad;
+
+		for (int y = 0; y < height; y++)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + y * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + y * effectiveWidth * 2);
+			convert_line_scalar(srcLine, dstLineY, dstLineUV, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
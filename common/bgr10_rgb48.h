@@ -16,6 +16,7 @@
 #define BGR10_RGB48_HEADER
 
 #include "VideoFrameWriter.h"
+#include "packed_rgb10.h"
 
 #ifndef NO_QUILL
 #include <quill/StopWatch.h>
@@ -30,8 +31,21 @@ template <typename VF>
 class bgr10_rgb48 : public IVideoFrameWriter<VF>
 {
 public:
-	bgr10_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY) : IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
+	bgr10_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
 	{
+		const auto& cpu = GetCpuFeatures();
+		if (pMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		else if (pMaxIsa >= ISA_SSSE3 && cpu.Supports(ISA_SSSE3))
+		{
+			mConvert = convert_ssse3;
+			this->mIsa = ISA_SSSE3;
+		}
+		this->LogKernel("BGR10 to RGB48");
 	}
 
 	~bgr10_rgb48() override = default;
@@ -76,11 +90,19 @@ public:
 		}
 		#endif
 
+		// rows are packed, unlike r210 magewell does not pad each line to a 256-byte boundary
+		const int srcStride = width * 4;
+
 		#ifndef NO_QUILL
 		const quill::StopWatchTsc swt;
 		#endif
 
-		this->convert(sourceData, reinterpret_cast<uint16_t*>(outData), width, height, this->mPixelsToPad);
+		const int dstStride = (width + this->mPixelsToPad) * 3;
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvert(srcLines, srcStride,
+			         reinterpret_cast<uint16_t*>(outData) + firstLine * dstStride, width, lineCount, this->mPixelsToPad);
+		});
 
 		#ifndef NO_QUILL
 		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
@@ -95,80 +117,108 @@ public:
 
 private:
 	#ifdef RECORD_RAW
-	uint32_t mFrameCounter;
+	uint32_t mFrameCounter{0};
 	#endif
 
-	#ifdef __AVX2__
-	bool convert(const uint8_t* src, uint16_t* dst, size_t width, size_t height, int pixelsToPad)
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad);
+
+	// bgr10 is 10-bit RGB packed into a little-endian 32bit word as 2 bits of padding followed by B, G and R
+	static void convert_line_scalar(const uint32_t* srcLine, uint16_t* dstPix, int x, int width)
 	{
-		// Each row starts on 256-byte boundary
-		size_t srcStride = (width * 4 + 255) / 256 * 256;
-		const uint8_t* srcRow = src;
-		uint16_t* dstPix = dst;
-		size_t blocks = width / 4;
-		const int dstPadding = pixelsToPad * 3;
-
-		for (size_t y = 0; y < height; ++y)
+		for (; x < width; ++x)
 		{
-			const uint32_t* srcPixel = reinterpret_cast<const uint32_t*>(srcRow);
+			const uint32_t srcPixel = srcLine[x];
 
-			for (size_t x = 0; x < blocks; ++x)
-			{
-				// xmm is physically the lower lane of ymm so we can treat this as a ymm register going forward
-				__m128i pixelBlockLE = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPixel));
-				const uint32_t* p = reinterpret_cast<const uint32_t*>(&pixelBlockLE);
-
-				dstPix[0] = (p[0] & 0x3FF) << 6;
-				dstPix[1] = (p[0] & 0xFFC00) >> 4;
-				dstPix[2] = (p[0] & 0x3FF00000) >> 14;
-				dstPix[3] = (p[1] & 0x3FF) << 6;
-				dstPix[4] = (p[1] & 0xFFC00) >> 4;
-				dstPix[5] = (p[1] & 0x3FF00000) >> 14;
-				dstPix[6] = (p[2] & 0x3FF) << 6;
-				dstPix[7] = (p[2] & 0xFFC00) >> 4;
-				dstPix[8] = (p[2] & 0x3FF00000) >> 14;
-				dstPix[9] = (p[3] & 0x3FF) << 6;
-				dstPix[10] = (p[3] & 0xFFC00) >> 4;
-				dstPix[11] = (p[3] & 0x3FF00000) >> 14;
-				dstPix += 12;
-				srcPixel += 4;
-			}
-			dstPix += dstPadding;
-			srcRow += srcStride;
+			dstPix[0] = static_cast<uint16_t>(srcPixel << 6 & 0xFFC0); // R
+			dstPix[1] = static_cast<uint16_t>(srcPixel >> 4 & 0xFFC0); // G
+			dstPix[2] = static_cast<uint16_t>(srcPixel >> 14 & 0xFFC0); // B
+			dstPix += 3;
+		}
+	}
+
+	// compact 2 pixels held as R G B 0 R G B 0 into the lower 12 bytes
+	static constexpr packed_rgb10::avx2_tables avx2Tables = packed_rgb10::make_avx2_tables(packed_rgb10::bgr10);
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLine = dst + y * dstStride;
+			const int simdWidth = packed_rgb10::convert_line_avx2(avx2Tables, srcLine, dstLine, width);
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
 		}
 		return true;
 	}
-	#else
-	bool convert(const uint8_t* src, uint16_t* dst, size_t width, size_t height, int pixelsToPad)
+
+	EZ_TARGET_SSSE3
+	static __m128i pack_2(__m128i rgbx)
 	{
-		// Each row starts on 256-byte boundary
-		size_t srcStride = (width * 4 + 255) / 256 * 256;
-		const uint8_t* srcRow = src;
-		uint16_t* dstPix = dst;
-		const int dstPadding = pixelsToPad * 3;
+		const __m128i compact = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+		return _mm_shuffle_epi8(rgbx, compact);
+	}
+
+	// converts 4 pixels to 16bit R, G & B, returned as 2 vectors of R G B 0 R G B 0
+	EZ_TARGET_SSSE3
+	static void unpack_4(const uint32_t* srcPixel, __m128i* rgbx01, __m128i* rgbx23)
+	{
+		const __m128i mask = _mm_set1_epi32(0xFFC0);
+		const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPixel));
+		const __m128i r = _mm_and_si128(_mm_slli_epi32(px, 6), mask);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(px, 4), mask);
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(px, 14), mask);
+		const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+		*rgbx01 = _mm_unpacklo_epi32(rg, b);
+		*rgbx23 = _mm_unpackhi_epi32(rg, b);
+	}
 
-		for (size_t y = 0; y < height; ++y)
+	EZ_TARGET_SSSE3
+	static bool convert_ssse3(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int simdWidth = width & ~7;
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
 		{
-			const uint32_t* srcPixelLE = reinterpret_cast<const uint32_t*>(srcRow);
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLine = dst + y * dstStride;
 
-			for (size_t x = 0; x < width; ++x)
+			// 8 pixels in, 48 bytes out
+			for (int x = 0; x < simdWidth; x += 8)
 			{
-				const auto srcPixel = _byteswap_ulong(srcPixelLE[x]);
+				__m128i p01, p23, p45, p67;
+				unpack_4(srcLine + x, &p01, &p23);
+				unpack_4(srcLine + x + 4, &p45, &p67);
+				const __m128i k0 = pack_2(p01);
+				const __m128i k1 = pack_2(p23);
+				const __m128i k2 = pack_2(p45);
+				const __m128i k3 = pack_2(p67);
+
+				__m128i* out = reinterpret_cast<__m128i*>(dstLine + x * 3);
+				_mm_storeu_si128(out, _mm_or_si128(k0, _mm_slli_si128(k1, 12)));
+				_mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(k1, 4), _mm_slli_si128(k2, 8)));
+				_mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(k2, 8), _mm_slli_si128(k3, 4)));
+			}
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
+		}
+		return true;
+	}
 
-				const uint16_t red_16 = (srcPixel & 0x3FF) << 6;
-				const uint16_t green_16 = (srcPixel & 0xFFC00) >> 4;
-				const uint16_t blue_16 = (srcPixel & 0x3FF00000) >> 14;
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
 
-				dstPix[0] = red_16;
-				dstPix[1] = green_16;
-				dstPix[2] = blue_16;
-				dstPix += 3;
-			}
-			srcRow += srcStride;
-			dstPix += dstPadding;
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			convert_line_scalar(srcLine, dst + y * dstStride, 0, width);
 		}
 		return true;
 	}
-	#endif
+
+	convert_fn mConvert{convert_scalar};
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,200 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CADENCE_HEADER
+#define CADENCE_HEADER
+
+#include <array>
+#include <cstdint>
+
+enum cadence : uint8_t
+{
+	CADENCE_NONE,
+	// 30p (or 25p) sent at 60 (or 50) Hz, each frame twice
+	CADENCE_2_2,
+	// 24p sent at 60 Hz, frames alternately 3 & 2 times
+	CADENCE_3_2
+};
+
+inline const char* to_string(cadence c)
+{
+	switch (c)
+	{
+	case CADENCE_2_2:
+		return "2:2";
+	case CADENCE_3_2:
+		return "3:2";
+	default:
+		return "none";
+	}
+}
+
+namespace cadence_detail
+{
+	struct pattern
+	{
+		cadence type;
+		// source frames in one repeat of the pattern
+		int period;
+		// 1 for each frame in the pattern which is a new picture, earliest first
+		std::array<bool, 5> isNew;
+		// consecutive periods seen before locking
+		int periodsToLock;
+	};
+
+	inline constexpr std::array<pattern, 2> patterns{
+		{
+			{CADENCE_3_2, 5, {true, false, false, true, false}, 2},
+			{CADENCE_2_2, 2, {true, false}, 4}
+		}
+	};
+}
+
+/**
+ * Locks onto the pattern of new & repeated frames produced by pulldown so only the new frames need be delivered. A
+ * frame expected to be new which turns out to be a repeat does not break the lock (the picture may just be static)
+ * but a frame expected to be a repeat which differs from the last unlocks immediately.
+ */
+class cadence_detector
+{
+public:
+	/**
+	 * Feeds the next frame, returns true if it is a repeat predicted by the locked cadence and so can be dropped.
+	 */
+	bool Push(bool repeat)
+	{
+		mHistory = mHistory << 1 | (repeat ? 0u : 1u);
+		if (mFrames < historyFrames)
+		{
+			++mFrames;
+		}
+		if (mLocked)
+		{
+			mPhase = (mPhase + 1) % mLocked->period;
+			if (mLocked->isNew[mPhase])
+			{
+				return false;
+			}
+			if (repeat)
+			{
+				return true;
+			}
+			// the cadence is broken, start again from this frame
+			mLocked = nullptr;
+			mHistory = 1;
+			mFrames = 1;
+			++mBreaks;
+			return false;
+		}
+		for (const auto& p : cadence_detail::patterns)
+		{
+			if (const auto phase = FindPhase(p); phase >= 0)
+			{
+				mLocked = &p;
+				mPhase = phase;
+				break;
+			}
+		}
+		return false;
+	}
+
+	void Reset()
+	{
+		mLocked = nullptr;
+		mHistory = 0;
+		mFrames = 0;
+		mPhase = 0;
+	}
+
+	cadence GetCadence() const
+	{
+		return mLocked ? mLocked->type : CADENCE_NONE;
+	}
+
+	// the number of times a locked cadence has been broken
+	uint64_t GetBreakCount() const
+	{
+		return mBreaks;
+	}
+
+	/**
+	 * A delivered frame is shown for this many half source frame intervals, i.e. 5 for 3:2 and 4 for 2:2, so frames
+	 * are evenly spaced at the rate of the original content.
+	 */
+	int GetDurationHalfFrames() const
+	{
+		if (!mLocked)
+		{
+			return 2;
+		}
+		auto newFrames = 0;
+		for (int i = 0; i < mLocked->period; ++i)
+		{
+			newFrames += mLocked->isNew[i];
+		}
+		return 2 * mLocked->period / newFrames;
+	}
+
+	/**
+	 * The start of the frame last pushed is moved on by this many half source frame intervals, the longer runs of
+	 * 3:2 are delayed by half a frame so the evenly spaced start times never precede the arrival of the frame.
+	 */
+	int GetDelayHalfFrames() const
+	{
+		if (!mLocked || !mLocked->isNew[mPhase])
+		{
+			return 0;
+		}
+		auto run = 1;
+		while (run < mLocked->period && !mLocked->isNew[(mPhase + run) % mLocked->period])
+		{
+			++run;
+		}
+		return run - GetDurationHalfFrames() / 2;
+	}
+
+private:
+	static constexpr int historyFrames = 32;
+
+	// the phase of the pattern the most recent frame is at, -1 if the history does not follow the pattern
+	int FindPhase(const cadence_detail::pattern& p) const
+	{
+		const auto frames = p.period * p.periodsToLock;
+		if (mFrames < frames)
+		{
+			return -1;
+		}
+		for (int phase = 0; phase < p.period; ++phase)
+		{
+			auto matched = true;
+			for (int i = 0; i < frames && matched; ++i)
+			{
+				const bool isNew = mHistory >> i & 1u;
+				matched = isNew == p.isNew[((phase - i) % p.period + p.period) % p.period];
+			}
+			if (matched)
+			{
+				return phase;
+			}
+		}
+		return -1;
+	}
+
+	uint32_t mHistory{0};
+	int mFrames{0};
+	const cadence_detail::pattern* mLocked{nullptr};
+	int mPhase{0};
+	uint64_t mBreaks{0};
+};
+#endif
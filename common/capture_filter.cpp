@@ -125,15 +125,60 @@ capture_filter::capture_filter(LPCTSTR pName, LPUNKNOWN punk, HRESULT* phr, CLSI
 		{
 			mHighThreadPriorityEnabled = res.GetValue() == 1;
 		}
+		if (auto res = key.TryGetDwordValue(ditherTo8BitEnabledRegKey))
+		{
+			mDitherTo8BitEnabled = res.GetValue() == 1;
+		}
 		if (auto res = key.TryGetDwordValue(audioCaptureEnabledRegKey))
 		{
 			mAudioCaptureEnabled = res.GetValue() == 1;
 		}
+		if (auto res = key.TryGetDwordValue(conversionStripesRegKey))
+		{
+			mConversionStripes = static_cast<uint8_t>(std::clamp<DWORD>(res.GetValue(), 1, maxConversionStripes));
+		}
+		if (auto res = key.TryGetDwordValue(conversionTileLinesRegKey))
+		{
+			mConversionTileLines = static_cast<int>(std::min<DWORD>(res.GetValue(), maxConversionTileLines));
+		}
+		if (auto res = key.TryGetDwordValue(streamingLoadSourcesRegKey))
+		{
+			mStreamingLoadSources = res.GetValue();
+		}
+		if (auto res = key.TryGetDwordValue(kernelCalibrationEnabledRegKey))
+		{
+			mKernelCalibrationEnabled = res.GetValue() == 1;
+		}
+		if (auto res = key.TryGetDwordValue(skipRepeatedFramesRegKey))
+		{
+			mSkipRepeatedFramesEnabled = res.GetValue() == 1;
+		}
+		if (auto res = key.TryGetDwordValue(inverseTelecineRegKey))
+		{
+			mInverseTelecineEnabled = res.GetValue() == 1;
+		}
+		if (auto res = key.TryGetDwordValue(detectActiveAreaRegKey))
+		{
+			mActiveAreaDetectionEnabled = res.GetValue() == 1;
+		}
+		if (auto res = key.TryGetDwordValue(previewScaleRegKey))
+		{
+			const auto scale = res.GetValue();
+			mPreviewScale = scale == 4 || scale == 8 ? static_cast<int>(scale) : 0;
+		}
+		if (auto res = key.TryGetDwordValue(deinterlaceRegKey))
+		{
+			const auto mode = res.GetValue();
+			mDeinterlaceMode = mode <= DEINTERLACE_MOTION_ADAPTIVE ? static_cast<deinterlace_mode>(mode) : DEINTERLACE_OFF;
+		}
 		#ifndef NO_QUILL
 		LOG_INFO(mLogData.logger,
-		         "[{}] Loaded properties from registry [hdrProfile:{}, sdrProfile: {}, profileSwitch: {}, rateSwitch: {}, highPriority: {}, audio: {}]",
+		         "[{}] Loaded properties from registry [hdrProfile:{}, sdrProfile: {}, profileSwitch: {}, rateSwitch: {}, highPriority: {}, dither: {}, audio: {}, stripes: {}, tileLines: {}, streamingLoads: {:#x}, calibration: {}, skipRepeats: {}, inverseTelecine: {}, activeArea: {}, previewScale: {}, deinterlace: {}]",
 		         mLogData.prefix, mHdrProfile, mSdrProfile, mHdrProfileSwitchEnabled, mRefreshRateSwitchEnabled,
-		         mHighThreadPriorityEnabled, mAudioCaptureEnabled);
+		         mHighThreadPriorityEnabled, mDitherTo8BitEnabled, mAudioCaptureEnabled, mConversionStripes,
+		         mConversionTileLines, mStreamingLoadSources, mKernelCalibrationEnabled, mSkipRepeatedFramesEnabled,
+		         mInverseTelecineEnabled, mActiveAreaDetectionEnabled, mPreviewScale,
+		         to_string(mDeinterlaceMode));
 		#endif
 
 		if (mAudioCaptureEnabled)
@@ -189,6 +234,10 @@ STDMETHODIMP capture_filter::NonDelegatingQueryInterface(REFIID riid, void** ppv
 	{
 		return GetInterface(static_cast<ISignalInfo*>(this), ppv);
 	}
+	if (riid == IID_ISignalInfo2)
+	{
+		return GetInterface(static_cast<ISignalInfo2*>(this), ppv);
+	}
 	return CSource::NonDelegatingQueryInterface(riid, ppv);
 }
 
@@ -407,6 +456,50 @@ HRESULT capture_filter::SetAudioCaptureEnabled(bool enabled)
 	return E_FAIL;
 }
 
+// choices are keyed by cpu model & resolution and packed into a single value as isa | striped << 8 | ps per pixel << 16
+static std::wstring GetKernelCalibrationKey(const std::wstring& regKeyBase, int cx, int cy)
+{
+	const auto& brand = GetCpuFeatures().brand;
+	return std::format(L"{}\\{}\\{}\\{}x{}", regKeyBase, kernelCalibrationRegKey,
+	                   std::wstring(brand.begin(), brand.end()), cx, cy);
+}
+
+bool capture_filter::LoadKernelChoice(const char* conversion, int cx, int cy, kernel_choice* choice) const
+{
+	winreg::RegKey key;
+	if (key.TryOpen(HKEY_CURRENT_USER, GetKernelCalibrationKey(mRegKeyBase, cx, cy), KEY_READ))
+	{
+		const std::string name{conversion};
+		if (auto res = key.TryGetDwordValue(std::wstring(name.begin(), name.end())))
+		{
+			const auto value = res.GetValue();
+			const auto isa = static_cast<cpu_isa>(value & 0xFF);
+			if (isa <= ISA_AVX512 && GetCpuFeatures().Supports(isa))
+			{
+				*choice = {isa, (value >> 8 & 1) == 1, static_cast<double>(value >> 16) / 1000.0};
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void capture_filter::SaveKernelChoice(const char* conversion, int cx, int cy, const kernel_choice& choice) const
+{
+	if (winreg::RegKey key{HKEY_CURRENT_USER, GetKernelCalibrationKey(mRegKeyBase, cx, cy)})
+	{
+		const std::string name{conversion};
+		const auto psPerPixel = std::clamp<DWORD>(static_cast<DWORD>(choice.nsPerPixel * 1000.0), 1, 0xFFFF);
+		if (!key.TrySetDwordValue(std::wstring(name.begin(), name.end()),
+		                          choice.isa | (choice.striped ? 1 : 0) << 8 | psPerPixel << 16))
+		{
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger, "[{}] Unable to save calibration of {}", mLogData.prefix, conversion);
+			#endif
+		}
+	}
+}
+
 STDMETHODIMP capture_filter::GetPages(CAUUID* pPages)
 {
 	CheckPointer(pPages, E_POINTER)
@@ -595,6 +688,21 @@ void capture_filter::OnHdrUpdated(MediaSideDataHDR* hdr, MediaSideDataHDRContent
 	}
 }
 
+void capture_filter::OnActiveAreaUpdated(const active_area& area)
+{
+	CAutoLock lock(&mActiveAreaLock);
+	if (area == mActiveArea)
+	{
+		return;
+	}
+	mActiveArea = area;
+
+	#ifndef NO_QUILL
+	LOG_INFO(mLogData.logger, "[{}] Active area of {}x{} is rows {}-{} columns {}-{}", mLogData.prefix, area.width,
+	         area.height, area.top, area.bottom, area.left, area.right);
+	#endif
+}
+
 void capture_filter::OnAudioFormatLoaded(audio_format* af)
 {
 	mAudioOutputStatus.audioOutChannelLayout = af->channelLayout;
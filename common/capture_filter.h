@@ -25,6 +25,9 @@
 #include "metric.h"
 #include "signalinfo.h"
 #include "modeswitcher.h"
+#include "conversion_pool.h"
+#include "cpu_features.h"
+#include "deinterlace.h"
 
 #include <streams.h>
 #include "ISpecifyPropertyPages2.h"
@@ -42,14 +45,35 @@ inline constexpr auto sdrProfileRegKey = L"sdrProfile";
 inline constexpr auto hdrProfileSwitchEnabledRegKey = L"hdrProfileSwitchEnabled";
 inline constexpr auto refreshRateSwitchEnabledRegKey = L"refreshRateSwitchEnabled";
 inline constexpr auto highThreadPriorityEnabledRegKey = L"highThreadPriorityEnabled";
+// prefer dithered 8-bit outputs over 10-bit ones for 10-bit sources
+inline constexpr auto ditherTo8BitEnabledRegKey = L"ditherTo8BitEnabled";
 inline constexpr auto audioCaptureEnabledRegKey = L"audioCaptureEnabled";
+inline constexpr auto conversionStripesRegKey = L"conversionStripes";
+// lines per tile when staging planar outputs in cache, 0 writes each line straight to the sample
+inline constexpr auto conversionTileLinesRegKey = L"conversionTileLines";
+// bitmask of device_type whose frames are read via streaming loads
+inline constexpr auto streamingLoadSourcesRegKey = L"streamingLoadSources";
+// time each conversion kernel variant the first time a resolution is signalled and use the fastest
+inline constexpr auto kernelCalibrationEnabledRegKey = L"kernelCalibrationEnabled";
+// subkey (of the filter key) holding the calibrated kernel choices per cpu model & resolution
+inline constexpr auto kernelCalibrationRegKey = L"calibration";
+// drop frames identical to the one before, e.g. the repeats in 3:2 pulldown, rather than converting & delivering them
+inline constexpr auto skipRepeatedFramesRegKey = L"skipRepeatedFrames";
+// once a 3:2 or 2:2 cadence is locked, deliver only the unique frames at the film rate
+inline constexpr auto inverseTelecineRegKey = L"inverseTelecine";
+// find the letterbox or pillarbox bars in each frame as it is converted
+inline constexpr auto detectActiveAreaRegKey = L"detectActiveArea";
+// 4 or 8 to add a pin alongside the full size preview pin carrying the capture pin scaled down by that much
+inline constexpr auto previewScaleRegKey = L"previewScale";
+// 1 (bob) or 2 (motion adaptive) to deliver each field of an interlaced signal as a progressive frame
+inline constexpr auto deinterlaceRegKey = L"deinterlace";
 
 // Non template parts of the filter impl
 class capture_filter :
 	public IReferenceClock,
 	public IAMFilterMiscFlags,
 	public ISpecifyPropertyPages2,
-	public ISignalInfo,
+	public ISignalInfo2,
 	public CSource
 {
 public:
@@ -171,11 +195,81 @@ public:
 
 	STDMETHODIMP SetAudioCaptureEnabled(bool enabled) override;
 
+	//////////////////////////////////////////////////////////////////////////
+	//  ISignalInfo2
+	//////////////////////////////////////////////////////////////////////////
+	STDMETHODIMP GetActiveArea(active_area* area) override
+	{
+		if (!area) return E_POINTER;
+		CAutoLock lock(&mActiveAreaLock);
+		*area = mActiveArea;
+		return mActiveArea.exists() ? S_OK : S_FALSE;
+	}
+
 	DWORD GetMCProfileId(bool hdr)
 	{
 		return hdr ? mHdrProfile : mSdrProfile;
 	}
 
+	// number of stripes each frame is split into for conversion, 1 converts the whole frame on the streaming thread
+	uint8_t GetConversionStripes() const
+	{
+		return mConversionStripes;
+	}
+
+	// lines per output staging tile, 0 disables tiling
+	int GetConversionTileLines() const
+	{
+		return mConversionTileLines;
+	}
+
+	// true if 10-bit sources should be offered to the renderer as dithered 8-bit formats ahead of the 10-bit ones
+	bool IsDitherTo8BitEnabled() const
+	{
+		return mDitherTo8BitEnabled;
+	}
+
+	// true if frames from this type of device should be treated as write combined memory
+	bool IsStreamingLoadEnabled(device_type type) const
+	{
+		return mStreamingLoadSources & 1 << type;
+	}
+
+	bool IsKernelCalibrationEnabled() const
+	{
+		return mKernelCalibrationEnabled;
+	}
+
+	bool IsSkipRepeatedFramesEnabled() const
+	{
+		return mSkipRepeatedFramesEnabled;
+	}
+
+	bool IsInverseTelecineEnabled() const
+	{
+		return mInverseTelecineEnabled;
+	}
+
+	bool IsActiveAreaDetectionEnabled() const
+	{
+		return mActiveAreaDetectionEnabled;
+	}
+
+	// the factor the scaled preview pin shrinks the capture pin by, 0 if there is no scaled preview pin
+	int GetPreviewScale() const
+	{
+		return mPreviewScale;
+	}
+
+	deinterlace_mode GetDeinterlaceMode() const
+	{
+		return mDeinterlaceMode;
+	}
+
+	// the kernel choice previously calibrated for the conversion at this resolution on this cpu model, if any
+	bool LoadKernelChoice(const char* conversion, int cx, int cy, kernel_choice* choice) const;
+	void SaveKernelChoice(const char* conversion, int cx, int cy, const kernel_choice& choice) const;
+
 	//////////////////////////////////////////////////////////////////////////
 	//  ISpecifyPropertyPages2
 	//////////////////////////////////////////////////////////////////////////
@@ -186,6 +280,7 @@ public:
 	void OnVideoFormatLoaded(video_format* vf);
 	void OnAudioFormatLoaded(audio_format* af);
 	void OnHdrUpdated(MediaSideDataHDR* hdr, MediaSideDataHDRContentLightLevel* light);
+	void OnActiveAreaUpdated(const active_area& area);
 
 	void RecordVideoFrameLatency(const frame_metrics& metrics)
 	{
@@ -209,6 +304,8 @@ public:
 			CaptureLatency(metrics.m3, mVideoLatencyStats3, metrics.name3, src);
 		}
 
+		CaptureStripeLatency(metrics.stripes, mVideoLatencyStats2, src);
+
 		if (mInfoCallback != nullptr)
 		{
 			mInfoCallback->ReloadV1(&mVideoLatencyStats1);
@@ -268,7 +365,20 @@ protected:
 	bool mHdrProfileSwitchEnabled{false};
 	bool mRefreshRateSwitchEnabled{true};
 	bool mHighThreadPriorityEnabled{true};
+	bool mDitherTo8BitEnabled{false};
 	bool mAudioCaptureEnabled{true};
+	uint8_t mConversionStripes{1};
+	int mConversionTileLines{0};
+	DWORD mStreamingLoadSources{0};
+	bool mKernelCalibrationEnabled{true};
+	bool mSkipRepeatedFramesEnabled{false};
+	bool mInverseTelecineEnabled{false};
+	bool mActiveAreaDetectionEnabled{false};
+	int mPreviewScale{0};
+	deinterlace_mode mDeinterlaceMode{DEINTERLACE_OFF};
+	// written by the video pin thread, read by ISignalInfo2 callers
+	CCritSec mActiveAreaLock;
+	active_area mActiveArea{};
 
 private:
 	void CaptureLatency(const metric& metric, latency_stats& lat, const std::string& desc, const std::string& src)
@@ -284,6 +394,28 @@ private:
 		             static_cast<double>(lat.max) / 10000.0);
 		#endif
 	}
+
+	// published alongside the conversion as a whole so scaling across cores can be seen
+	void CaptureStripeLatency(const std::vector<metric>& stripes, latency_stats& lat, const std::string& src)
+	{
+		lat.stripes.clear();
+		if (stripes.size() < 2)
+		{
+			return;
+		}
+		for (size_t i = 0; i < stripes.size(); ++i)
+		{
+			const auto& stripe = lat.stripes.emplace_back(stripe_latency{
+				.min = stripes[i].min(), .mean = stripes[i].mean(), .max = stripes[i].max()
+			});
+
+			#ifndef NO_QUILL
+			LOG_TRACE_L2(mLogData.logger, "[{}] {} stripe {} {} latency stats {:.3f},{:.3f},{:.3f}", mLogData.prefix,
+			             lat.name, i, src, static_cast<double>(stripe.min) / 10000.0, stripe.mean / 10000.0,
+			             static_cast<double>(stripe.max) / 10000.0);
+			#endif
+		}
+	}
 };
 
 template <typename D_INF, typename V_SIG, typename A_SIG>
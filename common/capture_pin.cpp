@@ -155,6 +155,10 @@ HRESULT capture_pin::DoBufferProcessingLoop(void)
 				#endif
 				pSample->Release();
 			}
+			else if (hr == S_REPEATED_FRAME)
+			{
+				pSample->Release();
+			}
 			else
 			{
 				#ifndef NO_QUILL
@@ -31,6 +31,9 @@
 #include <dvdmedia.h>
 #include <optional>
 
+// FillBuffer found the frame to be a repeat of the last one so the sample is not delivered
+#define S_REPEATED_FRAME    ((HRESULT)201L)
+
 inline bool diff(double x, double y)
 {
 	return fabs(x - y) > 0.000001;
@@ -0,0 +1,255 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CONVERSION_POOL_HEADER
+#define CONVERSION_POOL_HEADER
+
+#define NOMINMAX // quill does not compile without this
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#include "logging.h"
+
+inline constexpr uint8_t maxConversionStripes = 8;
+// upper bound on the lines per output staging tile, far beyond the point where a tile of a UHD frame stops fitting in L2
+inline constexpr int maxConversionTileLines = 256;
+
+namespace conversion_pool_detail
+{
+	// shared by every pool in the process so the pools of the capture & preview pins (or of several filters) prefer
+	// different cores rather than all crowding onto the lowest ones
+	inline std::atomic<unsigned> nextCore{0};
+
+	// the next core a worker should prefer, never core 0 (which services most interrupts) nor avoid
+	inline unsigned NextCore(unsigned cpuCount, unsigned avoid)
+	{
+		while (true)
+		{
+			const auto core = 1 + nextCore.fetch_add(1) % (cpuCount - 1);
+			if (core != avoid || cpuCount < 3)
+			{
+				return core;
+			}
+		}
+	}
+}
+
+/**
+ * A fixed set of worker threads which convert a frame in horizontal stripes. The calling (streaming) thread converts
+ * the first stripe itself and waits for the workers to complete the rest so a frame is always fully written when Run
+ * returns. Workers live as long as the pool so there is no thread creation on the streaming path.
+ */
+class conversion_pool
+{
+public:
+	// converts lineCount lines starting at firstLine
+	using stripe_fn = std::function<void(int firstLine, int lineCount)>;
+
+	conversion_pool(log_data pLogData, uint8_t pStripes, [[maybe_unused]] bool pHighPriority) :
+		mLogData(std::move(pLogData)),
+		mStripes(std::clamp<uint8_t>(pStripes, 1, maxConversionStripes)),
+		mStripeTimes(mStripes, 0)
+	{
+		// ideal processors are numbered within a processor group of at most 64
+		mCpuCount = std::min(std::max(std::thread::hardware_concurrency(), 1U), 64U);
+		for (uint8_t i = 1; i < mStripes; ++i)
+		{
+			mWorkers.emplace_back(&conversion_pool::Work, this, i);
+			#ifdef _WIN32
+			// each worker prefers its own core but the OS may still move it to an idle one, hard affinity would leave
+			// time critical workers of different pools (and the unpinned streaming thread) starving each other
+			auto handle = mWorkers.back().native_handle();
+			if (mCpuCount > 1)
+			{
+				mWorkerCores.push_back(conversion_pool_detail::NextCore(mCpuCount, 0));
+				SetThreadIdealProcessor(handle, mWorkerCores.back());
+			}
+			if (pHighPriority)
+			{
+				SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL);
+			}
+			#endif
+		}
+
+		#ifndef NO_QUILL
+		LOG_INFO(mLogData.logger, "[{}] Converting frames in {} stripes on {} cpus", mLogData.prefix, mStripes,
+		         mCpuCount);
+		#endif
+	}
+
+	~conversion_pool()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mStopping = true;
+		}
+		mWorkAvailable.notify_all();
+		for (auto& w : mWorkers)
+		{
+			w.join();
+		}
+	}
+
+	conversion_pool(const conversion_pool&) = delete;
+	conversion_pool& operator=(const conversion_pool&) = delete;
+
+	uint8_t GetStripeCount() const
+	{
+		return mStripes;
+	}
+
+	/**
+	 * Splits height into stripes of whole groups of groupLines (an even number, so 4:2:0 outputs never share a chroma
+	 * line across stripes) and blocks until all of them have been converted.
+	 */
+	void Run(int height, const stripe_fn& fn, int groupLines = 2)
+	{
+		AvoidStreamingCore();
+
+		int linesPerStripe = (height + mStripes - 1) / mStripes;
+		linesPerStripe = (linesPerStripe + groupLines - 1) / groupLines * groupLines;
+		{
+			std::lock_guard lock(mMutex);
+			mTask = &fn;
+			mHeight = height;
+			mLinesPerStripe = linesPerStripe;
+			mPending = mStripes - 1;
+			++mGeneration;
+		}
+		mWorkAvailable.notify_all();
+
+		ConvertStripe(0);
+
+		std::unique_lock lock(mMutex);
+		mWorkDone.wait(lock, [this] { return mPending == 0; });
+		mTask = nullptr;
+		mTimingsAvailable = true;
+	}
+
+	/**
+	 * Copies the time (in 100ns units) taken by each stripe of the last frame into times, returns false if there is no new
+	 * frame since the last call.
+	 */
+	bool ConsumeStripeTimes(std::vector<uint64_t>& times)
+	{
+		std::lock_guard lock(mMutex);
+		if (!mTimingsAvailable)
+		{
+			return false;
+		}
+		times.assign(mStripeTimes.begin(), mStripeTimes.end());
+		mTimingsAvailable = false;
+		return true;
+	}
+
+private:
+	using dshow_ticks = std::chrono::duration<uint64_t, std::ratio<1, 10000000>>;
+
+	// moves any worker preferring the core the streaming thread is running on to another one, only when the streaming
+	// thread has moved so this is a single comparison per frame
+	void AvoidStreamingCore()
+	{
+		#ifdef _WIN32
+		const auto core = GetCurrentProcessorNumber();
+		if (core == mStreamingCore)
+		{
+			return;
+		}
+		mStreamingCore = core;
+		for (size_t i = 0; i < mWorkerCores.size(); ++i)
+		{
+			if (mWorkerCores[i] == core)
+			{
+				mWorkerCores[i] = conversion_pool_detail::NextCore(mCpuCount, core);
+				SetThreadIdealProcessor(mWorkers[i].native_handle(), mWorkerCores[i]);
+			}
+		}
+		#endif
+	}
+
+	void ConvertStripe(uint8_t idx)
+	{
+		const auto firstLine = std::min(idx * mLinesPerStripe, mHeight);
+		const auto lineCount = std::min(mLinesPerStripe, mHeight - firstLine);
+		const auto start = std::chrono::steady_clock::now();
+		if (lineCount > 0)
+		{
+			(*mTask)(firstLine, lineCount);
+		}
+		mStripeTimes[idx] = std::chrono::duration_cast<dshow_ticks>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Work(uint8_t idx)
+	{
+		uint64_t seen = 0;
+		while (true)
+		{
+			{
+				std::unique_lock lock(mMutex);
+				mWorkAvailable.wait(lock, [this, seen] { return mStopping || mGeneration != seen; });
+				if (mStopping)
+				{
+					return;
+				}
+				seen = mGeneration;
+			}
+
+			ConvertStripe(idx);
+
+			bool last;
+			{
+				std::lock_guard lock(mMutex);
+				last = --mPending == 0;
+			}
+			if (last)
+			{
+				mWorkDone.notify_one();
+			}
+		}
+	}
+
+	log_data mLogData;
+	uint8_t mStripes;
+	std::vector<std::thread> mWorkers{};
+	unsigned mCpuCount{1};
+	// the core each worker prefers, empty on a single core machine
+	std::vector<unsigned> mWorkerCores{};
+	unsigned mStreamingCore{~0U};
+	std::mutex mMutex{};
+	std::condition_variable mWorkAvailable{};
+	std::condition_variable mWorkDone{};
+	const stripe_fn* mTask{nullptr};
+	int mHeight{0};
+	int mLinesPerStripe{0};
+	int mPending{0};
+	uint64_t mGeneration{0};
+	bool mStopping{false};
+	bool mTimingsAvailable{false};
+	std::vector<uint64_t> mStripeTimes;
+};
+#endif
@@ -0,0 +1,193 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CONVERSION_REGISTRY_HEADER
+#define CONVERSION_REGISTRY_HEADER
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "argb_bgra.h"
+#include "ay10_p210.h"
+#include "bgr10_rgb48.h"
+#include "p210_nv16.h"
+#include "packed422_nv12.h"
+#include "r10_rgb48.h"
+#include "r12_rgb48.h"
+#include "r210_rgb48.h"
+#include "uyvy_yv16.h"
+#include "v210_p010.h"
+#include "v210_p210.h"
+#include "v210_yuv8.h"
+#include "y210_p210.h"
+#include "y210_yv16.h"
+#include "yuv2_yv16.h"
+#include "yuy2_yv16.h"
+
+/**
+ * A writer which converts source to target along with its cost in ns per pixel.
+ */
+template <typename VF>
+struct frame_conversion
+{
+	using factory = std::unique_ptr<IVideoFrameWriter<VF>>(*)(const log_data& pLogData, int pX, int pY,
+	                                                          cpu_isa pMaxIsa);
+
+	frame_writer_strategy strategy;
+	pixel_format source;
+	pixel_format target;
+	double nsPerPixel;
+	// null when the writer comes from the capture sdk so can only be created by that card's pin
+	factory create;
+
+	// 10 to 8-bit conversions lose precision so are only offered when dithering is enabled
+	bool IsDithered() const
+	{
+		return target.bitDepth < source.bitDepth;
+	}
+
+	bool IsChromaSubsampled() const
+	{
+		return ChromaRank(target.subsampling) > ChromaRank(source.subsampling);
+	}
+
+	// sdk conversions are slow & opaque so are only used when nothing else can handle the source
+	bool IsLastResort() const
+	{
+		return create == nullptr;
+	}
+
+	// fallbacks are ordered by tier first and then cost
+	int Tier() const
+	{
+		return IsLastResort() ? 3 : IsDithered() ? 0 : IsChromaSubsampled() ? 2 : 1;
+	}
+
+private:
+	static int ChromaRank(pixel_encoding e)
+	{
+		return e == YUV_420 ? 2 : e == YUV_422 ? 1 : 0;
+	}
+};
+
+template <template <typename> class W, typename VF>
+std::unique_ptr<IVideoFrameWriter<VF>> make_writer(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa)
+{
+	return std::make_unique<W<VF>>(pLogData, pX, pY, pMaxIsa);
+}
+
+/**
+ * Every conversion the pins can use keyed by (source, target) format, fallbacks for each source format are generated
+ * from it in order of fidelity first (so 4:2:2 content is not squashed to 4:2:0 just because it is cheaper) and then
+ * cost. Default costs are single threaded AVX2 timings of a 1080p frame, each pin reorders its own fallbacks once the
+ * kernels have been calibrated at the negotiated resolution.
+ */
+template <typename VF>
+class conversion_registry
+{
+public:
+	static conversion_registry& Instance()
+	{
+		static conversion_registry instance;
+		return instance;
+	}
+
+	conversion_registry(const conversion_registry&) = delete;
+	conversion_registry& operator=(const conversion_registry&) = delete;
+
+	std::optional<frame_conversion<VF>> Find(frame_writer_strategy strategy) const
+	{
+		std::lock_guard lock(mMutex);
+		auto c = std::ranges::find(mConversions, strategy, &frame_conversion<VF>::strategy);
+		return c == mConversions.end() ? std::nullopt : std::optional{*c};
+	}
+
+	// a copy of every conversion
+	std::vector<frame_conversion<VF>> Conversions() const
+	{
+		std::lock_guard lock(mMutex);
+		return mConversions;
+	}
+
+	/**
+	 * Fallbacks for each of the given source formats, dithered conversions to 8-bit are only included (and then
+	 * preferred) when allow8Bit is set. Last resort conversions are always included after everything else.
+	 */
+	pixel_format_fallbacks Fallbacks(const std::vector<pixel_format>& sources, bool allow8Bit) const
+	{
+		std::vector<frame_conversion<VF>> candidates;
+		{
+			std::lock_guard lock(mMutex);
+			for (const auto& c : mConversions)
+			{
+				if (std::ranges::find(sources, c.source) != sources.end()
+					&& (allow8Bit || c.IsLastResort() || !c.IsDithered()))
+				{
+					candidates.push_back(c);
+				}
+			}
+		}
+		std::ranges::stable_sort(candidates, [](const frame_conversion<VF>& a, const frame_conversion<VF>& b)
+		{
+			const auto ta = a.Tier();
+			const auto tb = b.Tier();
+			return ta == tb ? a.nsPerPixel < b.nsPerPixel : ta < tb;
+		});
+
+		pixel_format_fallbacks fallbacks;
+		for (const auto& c : candidates)
+		{
+			fallbacks[c.source].emplace_back(c.target, c.strategy);
+		}
+		return fallbacks;
+	}
+
+private:
+	conversion_registry() = default;
+
+	mutable std::mutex mMutex;
+	std::vector<frame_conversion<VF>> mConversions{
+		{YUV2_YV16, YUV2, YV16, 0.25, make_writer<yuv2_yv16, VF>},
+		{YUV2_NV12, YUV2, NV12, 0.19, make_writer<yuv2_nv12, VF>},
+		{YUY2_YV16, YUY2, YV16, 0.25, make_writer<yuy2_yv16, VF>},
+		{YUY2_NV12, YUY2, NV12, 0.20, make_writer<yuy2_nv12, VF>},
+		{UYVY_YV16, UYVY, YV16, 0.25, make_writer<uyvy_yv16, VF>},
+		{UYVY_NV12, UYVY, NV12, 0.19, make_writer<uyvy_nv12, VF>},
+		{V210_P210, V210, P210, 0.42, make_writer<v210_p210, VF>},
+		{V210_P010, V210, P010, 0.39, make_writer<v210_p010, VF>},
+		{V210_YV16, V210, YV16, 0.40, make_writer<v210_yv16, VF>},
+		{V210_NV16, V210, NV16, 0.36, make_writer<v210_nv16, VF>},
+		{Y210_P210, Y210, P210, 0.46, make_writer<y210_p210, VF>},
+		{Y210_YV16, Y210, YV16, 0.31, make_writer<y210_yv16, VF>},
+		{P210_NV16, P210, NV16, 0.30, make_writer<p210_nv16, VF>},
+		{AY10_P210, AY10, P210, 0.48, make_writer<ay10_p210, VF>}, // alpha is dropped
+		{R210_BGR48, R210, RGB48, 0.92, make_writer<r210_rgb48, VF>},
+		{BGR10_BGR48, BGR10, RGB48, 0.90, make_writer<bgr10_rgb48, VF>},
+		{R10B_BGR48, R10B, RGB48, 0.86, make_writer<r10b_rgb48, VF>},
+		{R10L_BGR48, R10L, RGB48, 0.93, make_writer<r10l_rgb48, VF>},
+		{R12B_BGR48, R12B, RGB48, 0.84, make_writer<r12b_rgb48, VF>},
+		{R12L_BGR48, R12L, RGB48, 0.92, make_writer<r12l_rgb48, VF>},
+		{ARGB_BGRA, ARGB, BGRA, 0.12, make_writer<argb_bgra, VF>},
+		// unlikely to be seen in the wild so just fallback to RGB using the decklink sdk
+		{ANY_RGB, AY10, RGBA, 4.0, nullptr},
+		{ANY_RGB, R12B, RGBA, 4.0, nullptr},
+		{ANY_RGB, R12L, RGBA, 4.0, nullptr},
+		{ANY_RGB, R10B, RGBA, 4.0, nullptr},
+		{ANY_RGB, R10L, RGBA, 4.0, nullptr},
+	};
+};
+#endif
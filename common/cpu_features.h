@@ -0,0 +1,223 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CPU_FEATURES_HEADER
+#define CPU_FEATURES_HEADER
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// MSVC allows any intrinsic to be used regardless of /arch so kernels need no annotation, gcc & clang need to be told
+// which instructions a function may use
+#if defined(_MSC_VER) && !defined(__clang__)
+#define EZ_TARGET_SSSE3
+#define EZ_TARGET_SSE42
+#define EZ_TARGET_AVX2
+#define EZ_TARGET_AVX512
+#else
+#define EZ_TARGET_SSSE3 __attribute__((target("ssse3,sse4.1")))
+#define EZ_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define EZ_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,fma")))
+#define EZ_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi,avx2,bmi,bmi2,fma")))
+#endif
+
+/**
+ * The instruction sets a conversion kernel may be written against, ordered from slowest to fastest.
+ */
+enum cpu_isa : uint8_t
+{
+	ISA_SCALAR,
+	ISA_SSE2,
+	ISA_SSSE3,
+	ISA_AVX2,
+	ISA_AVX512
+};
+
+inline const char* to_string(cpu_isa e)
+{
+	switch (e)
+	{
+	case ISA_SCALAR: return "SCALAR";
+	case ISA_SSE2: return "SSE2";
+	case ISA_SSSE3: return "SSSE3";
+	case ISA_AVX2: return "AVX2";
+	case ISA_AVX512: return "AVX512";
+	default: return "unknown";
+	}
+}
+
+struct cpu_features
+{
+	bool sse2{false};
+	bool ssse3{false};
+	bool sse41{false};
+	bool sse42{false};
+	bool avx2{false};
+	bool bmi1{false};
+	bool bmi2{false};
+	bool fma{false};
+	bool avx512f{false};
+	bool avx512bw{false};
+	bool avx512vl{false};
+	bool avx512vbmi{false};
+	std::string brand{};
+
+	// AVX2 kernels are compiled with bmi, bmi2 & fma too (EZ_TARGET_AVX2) so the compiler may emit any of them, every
+	// Intel & AMD cpu with AVX2 has them but some hypervisors mask them out
+	bool HasAvx2() const
+	{
+		return avx2 && bmi1 && bmi2 && fma;
+	}
+
+	// AVX-512 kernels are only used when the byte/word, vector length and vbmi (vpermb, vpmultishiftqb) extensions
+	// are all present, i.e. Ice Lake onwards & Zen 4
+	bool HasAvx512() const
+	{
+		return HasAvx2() && avx512f && avx512bw && avx512vl && avx512vbmi;
+	}
+
+	bool Supports(cpu_isa isa) const
+	{
+		switch (isa)
+		{
+		case ISA_SCALAR: return true;
+		case ISA_SSE2: return sse2;
+		case ISA_SSSE3: return ssse3 && sse41;
+		case ISA_AVX2: return HasAvx2();
+		case ISA_AVX512: return HasAvx512();
+		default: return false;
+		}
+	}
+
+	cpu_isa Best() const
+	{
+		if (HasAvx512()) return ISA_AVX512;
+		if (HasAvx2()) return ISA_AVX2;
+		if (ssse3 && sse41) return ISA_SSSE3;
+		if (sse2) return ISA_SSE2;
+		return ISA_SCALAR;
+	}
+};
+
+namespace cpu_detail
+{
+	inline void cpuid(int leaf, int subLeaf, int regs[4])
+	{
+		#if defined(_MSC_VER)
+		__cpuidex(regs, leaf, subLeaf);
+		#else
+		unsigned int a, b, c, d;
+		__cpuid_count(leaf, subLeaf, a, b, c, d);
+		regs[0] = static_cast<int>(a);
+		regs[1] = static_cast<int>(b);
+		regs[2] = static_cast<int>(c);
+		regs[3] = static_cast<int>(d);
+		#endif
+	}
+
+	inline uint64_t xgetbv0()
+	{
+		#if defined(_MSC_VER)
+		return _xgetbv(0);
+		#else
+		uint32_t eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return static_cast<uint64_t>(edx) << 32 | eax;
+		#endif
+	}
+
+	inline cpu_features detect()
+	{
+		cpu_features f{};
+		int regs[4];
+
+		cpuid(0, 0, regs);
+		const int maxLeaf = regs[0];
+
+		cpuid(0x80000000, 0, regs);
+		if (static_cast<unsigned int>(regs[0]) >= 0x80000004)
+		{
+			char brand[49]{};
+			for (int i = 0; i < 3; ++i)
+			{
+				cpuid(0x80000002 + i, 0, regs);
+				memcpy(brand + i * 16, regs, 16);
+			}
+			f.brand = brand;
+			auto first = f.brand.find_first_not_of(' ');
+			f.brand = first == std::string::npos ? "" : f.brand.substr(first);
+		}
+
+		if (maxLeaf < 1)
+		{
+			return f;
+		}
+
+		cpuid(1, 0, regs);
+		f.sse2 = regs[3] & 1 << 26;
+		f.ssse3 = regs[2] & 1 << 9;
+		f.sse41 = regs[2] & 1 << 19;
+		f.sse42 = regs[2] & 1 << 20;
+		const bool osxsave = regs[2] & 1 << 27;
+		const bool avx = regs[2] & 1 << 28;
+		f.fma = avx && regs[2] & 1 << 12;
+
+		// the OS must save the upper halves of the ymm (and zmm) registers on a context switch
+		const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+		const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+		const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+		if (maxLeaf >= 7)
+		{
+			cpuid(7, 0, regs);
+			f.avx2 = avx && ymmEnabled && regs[1] & 1 << 5;
+			f.bmi1 = regs[1] & 1 << 3;
+			f.bmi2 = regs[1] & 1 << 8;
+			f.avx512f = zmmEnabled && regs[1] & 1 << 16;
+			f.avx512bw = f.avx512f && regs[1] & 1 << 30;
+			f.avx512vl = f.avx512f && regs[1] & 1U << 31;
+			f.avx512vbmi = f.avx512f && regs[2] & 1 << 1;
+		}
+		return f;
+	}
+}
+
+/**
+ * The features of the CPU we are running on, detected once when first used (i.e. when the filter loads).
+ */
+inline const cpu_features& GetCpuFeatures()
+{
+	static const cpu_features features = cpu_detail::detect();
+	return features;
+}
+
+/**
+ * The fastest variant of a conversion on this machine, the instruction set its kernel may use and whether it is run in
+ * stripes on the conversion pool.
+ */
+struct kernel_choice
+{
+	cpu_isa isa{GetCpuFeatures().Best()};
+	bool striped{true};
+	double nsPerPixel{0.0};
+};
+#endif
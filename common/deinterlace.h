@@ -0,0 +1,450 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DEINTERLACE_HEADER
+#define DEINTERLACE_HEADER
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "cpu_features.h"
+#include "domain.h"
+#include "frame_copy.h"
+
+enum deinterlace_mode : uint8_t
+{
+	DEINTERLACE_OFF,
+	// the missing lines of each field are interpolated from the lines above & below
+	DEINTERLACE_BOB,
+	// as bob where the picture is moving, elsewhere the missing lines are woven from the other field
+	DEINTERLACE_MOTION_ADAPTIVE
+};
+
+inline const char* to_string(deinterlace_mode e)
+{
+	switch (e)
+	{
+	case DEINTERLACE_BOB: return "bob";
+	case DEINTERLACE_MOTION_ADAPTIVE: return "motion adaptive";
+	default: return "off";
+	}
+}
+
+enum field_order : uint8_t
+{
+	FIELD_ORDER_PROGRESSIVE,
+	// the field made of the even lines of the frame is the earlier one
+	FIELD_ORDER_TOP_FIRST,
+	FIELD_ORDER_BOTTOM_FIRST
+};
+
+inline const char* to_string(field_order e)
+{
+	switch (e)
+	{
+	case FIELD_ORDER_TOP_FIRST: return "top field first";
+	case FIELD_ORDER_BOTTOM_FIRST: return "bottom field first";
+	default: return "progressive";
+	}
+}
+
+// a component which differs by more than this many 8-bit codes from the previous frame is moving
+inline constexpr int deinterlaceMotionThreshold = 12;
+
+// true if frames of this format & field order are deinterlaced, and so delivered at twice the frame rate, in this mode
+inline bool IsDeinterlaced(deinterlace_mode mode, field_order order, const pixel_format& format)
+{
+	return mode != DEINTERLACE_OFF && order != FIELD_ORDER_PROGRESSIVE && (format == V210 || format == YUV2);
+}
+
+/**
+ * Line kernels for packed 4:2:2 frames, either 8-bit (UYVY) or v210. Both are handled a 32-bit word at a time, i.e. 2
+ * pixels of UYVY or 3 10-bit components of v210, so neither is ever unpacked.
+ */
+namespace deinterlace_detail
+{
+	// each 10-bit component of a v210 word less its least significant bit
+	inline constexpr uint32_t v210HighBits = 0x1FF7FDFF;
+	inline constexpr int v210Threshold = deinterlaceMotionThreshold << 2;
+
+	using average_fn = void(*)(const uint8_t* a, const uint8_t* b, uint8_t* out, int bytes);
+	using adaptive_fn = void(*)(const uint8_t* above, const uint8_t* below, const uint8_t* cur, const uint8_t* prev,
+	                            uint8_t* out, int bytes);
+
+	// the mean of each component, rounded up
+	template <bool V210>
+	uint32_t average_word(uint32_t a, uint32_t b)
+	{
+		if constexpr (V210)
+		{
+			// no component can borrow from its neighbour as (a | b) is never less than (a ^ b) >> 1
+			return (a | b) - ((a ^ b) >> 1 & v210HighBits);
+		}
+		else
+		{
+			return (a | b) - ((a ^ b) >> 1 & 0x7F7F7F7F);
+		}
+	}
+
+	template <bool V210>
+	bool moved_word(uint32_t cur, uint32_t prev)
+	{
+		constexpr int bits = V210 ? 10 : 8;
+		constexpr int components = V210 ? 3 : 4;
+		constexpr uint32_t mask = (1u << bits) - 1;
+		constexpr int threshold = V210 ? v210Threshold : deinterlaceMotionThreshold;
+		for (int c = 0; c < components; ++c)
+		{
+			const auto d = static_cast<int>(cur >> c * bits & mask) - static_cast<int>(prev >> c * bits & mask);
+			if (d > threshold || d < -threshold)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <bool V210>
+	void average_line_scalar(const uint8_t* a, const uint8_t* b, uint8_t* out, int bytes)
+	{
+		for (int i = 0; i < bytes; i += 4)
+		{
+			uint32_t x, y;
+			memcpy(&x, a + i, 4);
+			memcpy(&y, b + i, 4);
+			const auto mean = average_word<V210>(x, y);
+			memcpy(out + i, &mean, 4);
+		}
+	}
+
+	template <bool V210>
+	void adaptive_line_scalar(const uint8_t* above, const uint8_t* below, const uint8_t* cur, const uint8_t* prev,
+	                          uint8_t* out, int bytes)
+	{
+		for (int i = 0; i < bytes; i += 4)
+		{
+			uint32_t c, p;
+			memcpy(&c, cur + i, 4);
+			memcpy(&p, prev + i, 4);
+			if (moved_word<V210>(c, p))
+			{
+				uint32_t x, y;
+				memcpy(&x, above + i, 4);
+				memcpy(&y, below + i, 4);
+				c = average_word<V210>(x, y);
+			}
+			memcpy(out + i, &c, 4);
+		}
+	}
+
+	template <bool V210>
+	__m128i average_sse2(__m128i a, __m128i b)
+	{
+		if constexpr (V210)
+		{
+			const __m128i high = _mm_set1_epi32(static_cast<int>(v210HighBits));
+			return _mm_sub_epi32(_mm_or_si128(a, b), _mm_and_si128(_mm_srli_epi32(_mm_xor_si128(a, b), 1), high));
+		}
+		else
+		{
+			return _mm_avg_epu8(a, b);
+		}
+	}
+
+	template <int Shift>
+	__m128i v210_difference_sse2(__m128i cur, __m128i prev)
+	{
+		const __m128i mask = _mm_set1_epi32(0x3FF);
+		return _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(cur, Shift), mask),
+		                     _mm_and_si128(_mm_srli_epi32(prev, Shift), mask));
+	}
+
+	// all ones in each 32-bit word where no component has moved
+	template <bool V210>
+	__m128i static_sse2(__m128i cur, __m128i prev)
+	{
+		if constexpr (V210)
+		{
+			const __m128i threshold = _mm_set1_epi32(v210Threshold);
+			const __m128i negThreshold = _mm_set1_epi32(-v210Threshold);
+			auto moved = [&](__m128i d)
+			{
+				return _mm_or_si128(_mm_cmpgt_epi32(d, threshold), _mm_cmplt_epi32(d, negThreshold));
+			};
+			const __m128i any = _mm_or_si128(_mm_or_si128(moved(v210_difference_sse2<0>(cur, prev)),
+			                                              moved(v210_difference_sse2<10>(cur, prev))),
+			                                 moved(v210_difference_sse2<20>(cur, prev)));
+			return _mm_cmpeq_epi32(any, _mm_setzero_si128());
+		}
+		else
+		{
+			const __m128i d = _mm_or_si128(_mm_subs_epu8(cur, prev), _mm_subs_epu8(prev, cur));
+			const __m128i moved = _mm_subs_epu8(d, _mm_set1_epi8(static_cast<char>(deinterlaceMotionThreshold)));
+			return _mm_cmpeq_epi32(moved, _mm_setzero_si128());
+		}
+	}
+
+	template <bool V210>
+	void average_line_sse2(const uint8_t* a, const uint8_t* b, uint8_t* out, int bytes)
+	{
+		int i = 0;
+		for (; i + 16 <= bytes; i += 16)
+		{
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+			const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), average_sse2<V210>(x, y));
+		}
+		average_line_scalar<V210>(a + i, b + i, out + i, bytes - i);
+	}
+
+	template <bool V210>
+	void adaptive_line_sse2(const uint8_t* above, const uint8_t* below, const uint8_t* cur, const uint8_t* prev,
+	                        uint8_t* out, int bytes)
+	{
+		int i = 0;
+		for (; i + 16 <= bytes; i += 16)
+		{
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+			const __m128i mean = average_sse2<V210>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + i)),
+			                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + i)));
+			const __m128i weave = static_sse2<V210>(c, p);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+			                 _mm_or_si128(_mm_and_si128(weave, c), _mm_andnot_si128(weave, mean)));
+		}
+		adaptive_line_scalar<V210>(above + i, below + i, cur + i, prev + i, out + i, bytes - i);
+	}
+
+	template <bool V210>
+	EZ_TARGET_AVX2
+	__m256i average_avx2(__m256i a, __m256i b)
+	{
+		if constexpr (V210)
+		{
+			const __m256i high = _mm256_set1_epi32(static_cast<int>(v210HighBits));
+			return _mm256_sub_epi32(_mm256_or_si256(a, b),
+			                        _mm256_and_si256(_mm256_srli_epi32(_mm256_xor_si256(a, b), 1), high));
+		}
+		else
+		{
+			return _mm256_avg_epu8(a, b);
+		}
+	}
+
+	template <int Shift>
+	EZ_TARGET_AVX2
+	__m256i v210_difference_avx2(__m256i cur, __m256i prev)
+	{
+		const __m256i mask = _mm256_set1_epi32(0x3FF);
+		return _mm256_abs_epi32(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(cur, Shift), mask),
+		                                         _mm256_and_si256(_mm256_srli_epi32(prev, Shift), mask)));
+	}
+
+	template <bool V210>
+	EZ_TARGET_AVX2
+	__m256i static_avx2(__m256i cur, __m256i prev)
+	{
+		if constexpr (V210)
+		{
+			const __m256i d = _mm256_max_epi32(_mm256_max_epi32(v210_difference_avx2<0>(cur, prev),
+			                                                    v210_difference_avx2<10>(cur, prev)),
+			                                   v210_difference_avx2<20>(cur, prev));
+			return _mm256_cmpgt_epi32(_mm256_set1_epi32(v210Threshold + 1), d);
+		}
+		else
+		{
+			const __m256i d = _mm256_or_si256(_mm256_subs_epu8(cur, prev), _mm256_subs_epu8(prev, cur));
+			const __m256i moved = _mm256_subs_epu8(d, _mm256_set1_epi8(static_cast<char>(deinterlaceMotionThreshold)));
+			return _mm256_cmpeq_epi32(moved, _mm256_setzero_si256());
+		}
+	}
+
+	template <bool V210>
+	EZ_TARGET_AVX2
+	void average_line_avx2(const uint8_t* a, const uint8_t* b, uint8_t* out, int bytes)
+	{
+		int i = 0;
+		for (; i + 32 <= bytes; i += 32)
+		{
+			const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+			const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), average_avx2<V210>(x, y));
+		}
+		average_line_scalar<V210>(a + i, b + i, out + i, bytes - i);
+	}
+
+	template <bool V210>
+	EZ_TARGET_AVX2
+	void adaptive_line_avx2(const uint8_t* above, const uint8_t* below, const uint8_t* cur, const uint8_t* prev,
+	                        uint8_t* out, int bytes)
+	{
+		int i = 0;
+		for (; i + 32 <= bytes; i += 32)
+		{
+			const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + i));
+			const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + i));
+			const __m256i mean = average_avx2<V210>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(above + i)),
+			                                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(mean, c, static_avx2<V210>(c, p)));
+		}
+		adaptive_line_scalar<V210>(above + i, below + i, cur + i, prev + i, out + i, bytes - i);
+	}
+}
+
+/**
+ * Turns each frame of an interlaced signal, i.e. two fields woven together, into two progressive frames, one per field,
+ * so the renderer is sent progressive frames at the field rate. Each frame keeps the lines of its own field and fills
+ * in those of the other field by bob or, in the motion adaptive mode, by weaving the other field wherever it has not
+ * changed since the previous frame so static detail keeps its full vertical resolution.
+ *
+ * Frames are copied in before being deinterlaced as both fields, and the next frame's motion detection, read them
+ * again. Only packed 4:2:2 formats (v210 & UYVY) are supported.
+ */
+class deinterlacer
+{
+public:
+	explicit deinterlacer(cpu_isa pMaxIsa = ISA_AVX512) : mMaxIsa(pMaxIsa)
+	{
+	}
+
+	cpu_isa GetIsa() const
+	{
+		return mIsa;
+	}
+
+	/**
+	 * Copies in the next woven frame, each of its fields is then rendered by Render. Motion is only detected against
+	 * the previous frame if it was loaded immediately before this one (by index) in the same format.
+	 */
+	void Load(const uint8_t* frame, int rowBytes, int height, const pixel_format& format, field_order order,
+	          deinterlace_mode mode, uint64_t frameIndex, bool writeCombined)
+	{
+		const auto v210 = format == V210;
+		const auto frameBytes = static_cast<size_t>(rowBytes) * height;
+		const auto consecutive = mHasFrame && frameIndex == mFrameIndex + 1 && rowBytes == mRowBytes
+			&& height == mHeight && v210 == mV210;
+		if (v210 != mV210 || !mAverage)
+		{
+			SelectKernels(v210);
+		}
+		mRowBytes = rowBytes;
+		mHeight = height;
+		mOrder = order;
+		mMode = mode;
+		mFrameIndex = frameIndex;
+		mHasFrame = true;
+		mHasPrevious = consecutive;
+		mCurrent ^= 1;
+		mFrames[mCurrent].resize(frameBytes);
+		mOutput.resize(frameBytes);
+		if (writeCombined)
+		{
+			copy_streaming_load(mFrames[mCurrent].data(), frame, frameBytes);
+		}
+		else
+		{
+			memcpy(mFrames[mCurrent].data(), frame, frameBytes);
+		}
+	}
+
+	// forgets the previous frame so the next is bobbed throughout
+	void Reset()
+	{
+		mHasFrame = false;
+		mHasPrevious = false;
+	}
+
+	/**
+	 * Renders the progressive frame of the given field of the last frame loaded, 0 being the earlier field, into a
+	 * buffer which is overwritten by the next call.
+	 */
+	const uint8_t* Render(int field)
+	{
+		const auto parity = mOrder == FIELD_ORDER_BOTTOM_FIRST ? 1 - field : field;
+		const auto stride = static_cast<size_t>(mRowBytes);
+		const auto* cur = mFrames[mCurrent].data();
+		const auto* prev = mFrames[mCurrent ^ 1].data();
+		const auto adaptive = mMode == DEINTERLACE_MOTION_ADAPTIVE && mHasPrevious;
+		for (int y = 0; y < mHeight; ++y)
+		{
+			auto* out = mOutput.data() + y * stride;
+			if ((y & 1) == parity)
+			{
+				memcpy(out, cur + y * stride, stride);
+				continue;
+			}
+			// lines of this field either side, the first & last lines only have one
+			const auto above = y > 0 ? y - 1 : y + 1;
+			const auto below = y + 1 < mHeight ? y + 1 : y - 1;
+			if (above >= mHeight || below < 0)
+			{
+				memcpy(out, cur + y * stride, stride);
+			}
+			else if (adaptive)
+			{
+				mAdaptive(cur + above * stride, cur + below * stride, cur + y * stride, prev + y * stride, out,
+				          mRowBytes);
+			}
+			else
+			{
+				mAverage(cur + above * stride, cur + below * stride, out, mRowBytes);
+			}
+		}
+		return mOutput.data();
+	}
+
+private:
+	void SelectKernels(bool v210)
+	{
+		using namespace deinterlace_detail;
+		const auto& cpu = GetCpuFeatures();
+		mV210 = v210;
+		if (mMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mAverage = v210 ? average_line_avx2<true> : average_line_avx2<false>;
+			mAdaptive = v210 ? adaptive_line_avx2<true> : adaptive_line_avx2<false>;
+			mIsa = ISA_AVX2;
+		}
+		else if (mMaxIsa >= ISA_SSE2 && cpu.Supports(ISA_SSE2))
+		{
+			mAverage = v210 ? average_line_sse2<true> : average_line_sse2<false>;
+			mAdaptive = v210 ? adaptive_line_sse2<true> : adaptive_line_sse2<false>;
+			mIsa = ISA_SSE2;
+		}
+		else
+		{
+			mAverage = v210 ? average_line_scalar<true> : average_line_scalar<false>;
+			mAdaptive = v210 ? adaptive_line_scalar<true> : adaptive_line_scalar<false>;
+			mIsa = ISA_SCALAR;
+		}
+	}
+
+	cpu_isa mMaxIsa;
+	cpu_isa mIsa{ISA_SCALAR};
+	deinterlace_detail::average_fn mAverage{nullptr};
+	deinterlace_detail::adaptive_fn mAdaptive{nullptr};
+	bool mV210{false};
+	int mRowBytes{0};
+	int mHeight{0};
+	field_order mOrder{FIELD_ORDER_TOP_FIRST};
+	deinterlace_mode mMode{DEINTERLACE_BOB};
+	uint64_t mFrameIndex{0};
+	bool mHasFrame{false};
+	bool mHasPrevious{false};
+	// the last frame loaded & the one before it
+	std::vector<uint8_t> mFrames[2];
+	int mCurrent{0};
+	std::vector<uint8_t> mOutput;
+};
+#endif
@@ -0,0 +1,66 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DITHER_HEADER
+#define DITHER_HEADER
+
+#include <cstdint>
+#include "cpu_features.h"
+
+/**
+ * Ordered dither from 10-bit samples (held in bits 15-6 of a word) to 8-bit.
+ *
+ * Only 2 bits are dropped so a 2x2 Bayer matrix covers every remainder, each threshold is added before truncating to
+ * the top 8 bits which preserves the average level of a flat area exactly. Chroma is dithered per chroma column so a
+ * sample gets the same threshold whether it is written to a planar or an interleaved output.
+ */
+namespace dither
+{
+	inline constexpr uint16_t bayer[2][2]{{0, 128}, {192, 64}};
+
+	inline uint16_t threshold(int line, int column)
+	{
+		return bayer[line & 1][column & 1];
+	}
+
+	inline uint8_t to_8bit(uint16_t value, uint16_t threshold)
+	{
+		const uint32_t v = value + threshold;
+		return static_cast<uint8_t>((v > 0xFFFF ? 0xFFFF : v) >> 8);
+	}
+
+	// thresholds for consecutive luma samples starting on an even pixel
+	EZ_TARGET_AVX2
+	inline __m256i luma_thresholds_avx2(int line)
+	{
+		return _mm256_set1_epi32(threshold(line, 0) | threshold(line, 1) << 16);
+	}
+
+	// thresholds for interleaved UV samples starting on an even chroma column
+	EZ_TARGET_AVX2
+	inline __m256i chroma_thresholds_avx2(int line)
+	{
+		const uint64_t t0 = threshold(line, 0);
+		const uint64_t t1 = threshold(line, 1);
+		return _mm256_set1_epi64x(static_cast<long long>(t0 | t0 << 16 | t1 << 32 | t1 << 48));
+	}
+
+	// 16 samples to 8-bit, the results are left in the low byte of each word ready for packus
+	EZ_TARGET_AVX2
+	inline __m256i to_8bit_avx2(__m256i values, __m256i thresholds)
+	{
+		return _mm256_srli_epi16(_mm256_adds_epu16(values, thresholds), 8);
+	}
+}
+#endif
@@ -21,6 +21,7 @@
 #include <array>
 #include <map>
 #include <optional>
+#include <vector>
 #include <cmath>     // std::lround
 #include <chrono>
 #include "metric.h"
@@ -190,6 +191,9 @@ struct pixel_format
 			break;
 		case R12B:
 		case R12L:
+			// 8 pixels are packed into each 36 byte group, a partial group at the end of the line is still whole
+			cbLine = (cx + 7) / 8 * 36;
+			break;
 		default: // NOLINT(clang-diagnostic-covered-switch-default)
 			cbLine = cx * bitsPerPixel / 8;
 		}
@@ -299,7 +303,7 @@ enum protocol
 
 struct device_status
 {
-	protocol protocol{PCIE};
+	::protocol protocol{PCIE};
 	std::string deviceDesc{};
 	double temperature{0.0};
 	int16_t fanSpeed{-1};
@@ -326,6 +330,12 @@ struct hdr_meta
 	int transferFunction{4};
 
 	boolean exists() const
+	{
+		return masteringDisplayExists() && maxCLL != 0 && maxFALL != 0;
+	}
+
+	// everything but the content light level which many sources do not send
+	boolean masteringDisplayExists() const
 	{
 		return
 			r_primary_x != 0.0 &&
@@ -337,9 +347,13 @@ struct hdr_meta
 			whitepoint_x != 0.0 &&
 			whitepoint_y != 0.0 &&
 			minDML != 0.0 &&
-			maxDML != 0.0 &&
-			maxCLL != 0 &&
-			maxFALL != 0;
+			maxDML != 0.0;
+	}
+
+	// MaxCLL & MaxFALL are present and plausible
+	boolean lightLevelExists() const
+	{
+		return maxCLL > 0 && maxFALL > 0 && maxFALL <= maxCLL && maxCLL <= 10000;
 	}
 };
 
@@ -422,12 +436,22 @@ struct display_status
 	std::wstring status;
 };
 
+// one stripe of a conversion split across the conversion pool
+struct stripe_latency
+{
+	uint64_t min{0};
+	double mean{0.0};
+	uint64_t max{0};
+};
+
 struct latency_stats
 {
 	std::string name;
 	uint64_t min{0};
 	double mean{0.0};
 	uint64_t max{0};
+	// each stripe of a striped conversion, empty otherwise. Last so the fields above keep their layout
+	std::vector<stripe_latency> stripes{};
 };
 
 struct hdr_status
@@ -447,6 +471,25 @@ struct hdr_status
 	double hdrMaxFALL;
 };
 
+// the picture inside any letterbox or pillarbox bars as the first & last active rows & columns (inclusive) of a frame
+// of width x height
+struct active_area
+{
+	int top{-1};
+	int bottom{-1};
+	int left{-1};
+	int right{-1};
+	int width{0};
+	int height{0};
+
+	bool exists() const
+	{
+		return top >= 0 && bottom >= top && left >= 0 && right >= left;
+	}
+
+	bool operator==(const active_area&) const = default;
+};
+
 struct video_format
 {
 	colour_format colourFormat{REC709};
@@ -518,7 +561,7 @@ struct audio_format
 	std::string channelLayout;
 	int lfeChannelIndex{not_present};
 	double lfeLevelAdjustment{1.0};
-	codec codec{PCM};
+	::codec codec{PCM};
 	// encoded content only
 	uint16_t dataBurstSize{0};
 };
@@ -530,10 +573,24 @@ enum frame_writer_strategy :uint8_t
 	YUV2_YV16,
 	YUY2_YV16,
 	UYVY_YV16,
+	YUV2_NV12,
+	YUY2_NV12,
+	UYVY_NV12,
 	V210_P210,
+	V210_P010,
 	Y210_P210,
 	R210_BGR48,
 	BGR10_BGR48,
+	R10B_BGR48,
+	R10L_BGR48,
+	R12B_BGR48,
+	R12L_BGR48,
+	AY10_P210,
+	V210_YV16,
+	V210_NV16,
+	P210_NV16,
+	Y210_YV16,
+	ARGB_BGRA,
 	STRAIGHT_THROUGH
 };
 
@@ -545,17 +602,32 @@ inline const char* to_string(frame_writer_strategy e)
 	case YUV2_YV16: return "YUV2_YV16";
 	case YUY2_YV16: return "YUY2_YV16";
 	case UYVY_YV16: return "UYVY_YV16";
+	case YUV2_NV12: return "YUV2_NV12";
+	case YUY2_NV12: return "YUY2_NV12";
+	case UYVY_NV12: return "UYVY_NV12";
 	case V210_P210: return "V210_P210";
+	case V210_P010: return "V210_P010";
 	case Y210_P210: return "Y210_P210";
 	case R210_BGR48: return "R210_BGR48";
 	case BGR10_BGR48: return "BGR10_BGR48";
+	case R10B_BGR48: return "R10B_BGR48";
+	case R10L_BGR48: return "R10L_BGR48";
+	case R12B_BGR48: return "R12B_BGR48";
+	case R12L_BGR48: return "R12L_BGR48";
+	case AY10_P210: return "AY10_P210";
+	case V210_YV16: return "V210_YV16";
+	case V210_NV16: return "V210_NV16";
+	case P210_NV16: return "P210_NV16";
+	case Y210_YV16: return "Y210_YV16";
+	case ARGB_BGRA: return "ARGB_BGRA";
 	case STRAIGHT_THROUGH: return "STRAIGHT_THROUGH";
 	default: return "unknown";
 	}
 }
 
-// TODO support a list of fall back options
-typedef std::map<pixel_format, std::pair<pixel_format, frame_writer_strategy>> pixel_format_fallbacks;
+typedef std::pair<pixel_format, frame_writer_strategy> pixel_format_fallback;
+// formats (and the conversion which produces them) offered when the signalled format is not accepted, in order of preference
+typedef std::map<pixel_format, std::vector<pixel_format_fallback>> pixel_format_fallbacks;
 
 struct frame_metrics
 {
@@ -568,6 +640,8 @@ struct frame_metrics
 	std::string name2{"Conversion"};
 	metric m3;
 	std::string name3{};
+	// time taken by each stripe when conversion is split across the conversion pool
+	std::vector<metric> stripes{};
 
 	void start(int64_t ts)
 	{
@@ -590,6 +664,7 @@ struct frame_metrics
 			m1.resize(sz);
 			m2.resize(sz);
 			m3.resize(sz);
+			for (auto& s : stripes) s.resize(sz);
 		}
 		else
 		{
@@ -597,6 +672,20 @@ struct frame_metrics
 			m1.resize(sz);
 			m2.resize(sz);
 			m3.resize(sz);
+			for (auto& s : stripes) s.resize(sz);
+		}
+	}
+
+	void sampleStripes(const std::vector<uint64_t>& times)
+	{
+		if (stripes.size() != times.size())
+		{
+			stripes.assign(times.size(), metric{m2.capacity()});
+			name2 = times.size() > 1 ? "Conversion x" + std::to_string(times.size()) : "Conversion";
+		}
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			stripes[i].sample(times[i]);
 		}
 	}
 };
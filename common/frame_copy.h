@@ -0,0 +1,202 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FRAME_COPY_HEADER
+#define FRAME_COPY_HEADER
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "cpu_features.h"
+
+// small enough to stay resident in L1 alongside the conversion kernel's own working set
+inline constexpr size_t bounceTileSize = 16 * 1024;
+
+// below this a frame is likely to still be in cache when the renderer reads it so a regular copy is faster
+inline constexpr size_t streamingCopyThreshold = 1024 * 1024;
+
+namespace frame_copy_detail
+{
+	// bytes to copy before p reaches the given alignment
+	inline size_t head_bytes(const uint8_t* p, size_t alignment, size_t len)
+	{
+		const auto misalignment = reinterpret_cast<uintptr_t>(p) & (alignment - 1);
+		return std::min(misalignment == 0 ? 0 : alignment - misalignment, len);
+	}
+
+	EZ_TARGET_AVX2
+	inline void copy_streaming_avx2(uint8_t* dst, const uint8_t* src, size_t len)
+	{
+		const auto head = head_bytes(dst, 32, len);
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		len -= head;
+
+		const size_t blockLen = len & ~static_cast<size_t>(127);
+		for (size_t i = 0; i < blockLen; i += 128) // 4 x 256 bits per pass
+		{
+			_mm_prefetch(reinterpret_cast<const char*>(src + i + 1024), _MM_HINT_NTA);
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+			const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 64));
+			const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 96));
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), a);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 32), b);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 64), c);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i + 96), d);
+		}
+		// streaming stores are weakly ordered, make them visible before the sample is delivered
+		_mm_sfence();
+		memcpy(dst + blockLen, src + blockLen, len - blockLen);
+	}
+
+	inline void copy_streaming_sse2(uint8_t* dst, const uint8_t* src, size_t len)
+	{
+		const auto head = head_bytes(dst, 16, len);
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		len -= head;
+
+		const size_t blockLen = len & ~static_cast<size_t>(63);
+		for (size_t i = 0; i < blockLen; i += 64) // 4 x 128 bits per pass
+		{
+			_mm_prefetch(reinterpret_cast<const char*>(src + i + 1024), _MM_HINT_NTA);
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+		}
+		_mm_sfence();
+		memcpy(dst + blockLen, src + blockLen, len - blockLen);
+	}
+
+	EZ_TARGET_SSSE3
+	inline void copy_streaming_load_sse41(uint8_t* dst, const uint8_t* src, size_t len)
+	{
+		// movntdqa needs an aligned source
+		const auto head = head_bytes(src, 16, len);
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		len -= head;
+
+		// read a whole 64 byte line per pass so each fill of the streaming load buffer is consumed in one go
+		const size_t blockLen = len & ~static_cast<size_t>(63);
+		for (size_t i = 0; i < blockLen; i += 64)
+		{
+			auto in = reinterpret_cast<__m128i*>(const_cast<uint8_t*>(src + i));
+			const __m128i a = _mm_stream_load_si128(in);
+			const __m128i b = _mm_stream_load_si128(in + 1);
+			const __m128i c = _mm_stream_load_si128(in + 2);
+			const __m128i d = _mm_stream_load_si128(in + 3);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), a);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+		}
+		memcpy(dst + blockLen, src + blockLen, len - blockLen);
+	}
+}
+
+/**
+ * Copies len bytes using non temporal stores so that the destination (typically a media sample that is read later by
+ * the renderer on another core) does not evict everything else from the cache on the way through.
+ */
+inline void copy_streaming(void* dst, const void* src, size_t len)
+{
+	const auto& cpu = GetCpuFeatures();
+	if (cpu.Supports(ISA_AVX2))
+	{
+		frame_copy_detail::copy_streaming_avx2(static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), len);
+	}
+	else if (cpu.sse2)
+	{
+		frame_copy_detail::copy_streaming_sse2(static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), len);
+	}
+	else
+	{
+		memcpy(dst, src, len);
+	}
+}
+
+/**
+ * Copies a whole frame, large frames are streamed past the cache while small ones use a regular copy.
+ */
+inline void copy_frame(void* dst, const void* src, size_t len)
+{
+	if (len < streamingCopyThreshold)
+	{
+		memcpy(dst, src, len);
+	}
+	else
+	{
+		copy_streaming(dst, src, len);
+	}
+}
+
+/**
+ * Reads len bytes using streaming loads, this is much faster than regular loads when src is mapped write combined or
+ * uncached (as DMA targets can be) and no slower otherwise. dst should be a small, cache resident buffer.
+ */
+inline void copy_streaming_load(void* dst, const void* src, size_t len)
+{
+	if (GetCpuFeatures().sse41)
+	{
+		frame_copy_detail::copy_streaming_load_sse41(static_cast<uint8_t*>(dst), static_cast<const uint8_t*>(src), len);
+	}
+	else
+	{
+		memcpy(dst, src, len);
+	}
+}
+
+namespace frame_copy_detail
+{
+	inline uint8_t* aligned_tile(std::vector<uint8_t>& tile, size_t minSize)
+	{
+		if (tile.size() < minSize + 128)
+		{
+			tile.resize(minSize + 128);
+		}
+		auto aligned = (reinterpret_cast<uintptr_t>(tile.data()) + 63) & ~static_cast<uintptr_t>(63);
+		return reinterpret_cast<uint8_t*>(aligned);
+	}
+}
+
+/**
+ * A 64 byte aligned buffer of at least minSize bytes (plus slack for a kernel reading a vector beyond the last line),
+ * one per thread so stripes converted in parallel each get their own.
+ */
+inline uint8_t* GetBounceTile(size_t minSize)
+{
+	thread_local std::vector<uint8_t> tile;
+	return frame_copy_detail::aligned_tile(tile, minSize);
+}
+
+/**
+ * As per GetBounceTile but for the output of a conversion, a thread may hold a bounce tile & a staging tile at once.
+ */
+inline uint8_t* GetStagingTile(size_t minSize)
+{
+	thread_local std::vector<uint8_t> tile;
+	return frame_copy_detail::aligned_tile(tile, minSize);
+}
+#endif
@@ -0,0 +1,152 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FRAME_FINGERPRINT_HEADER
+#define FRAME_FINGERPRINT_HEADER
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include "cpu_features.h"
+
+// 1 in this many lines is hashed, any real change to the picture (even a cursor or a line of subtitles) spans more
+inline constexpr int fingerprintLineStep = 4;
+
+namespace frame_fingerprint_detail
+{
+	// reflected Castagnoli polynomial, i.e. that implemented by the SSE4.2 crc32 instruction
+	inline const std::array<uint32_t, 256>& crc32c_table()
+	{
+		static const auto table = []
+		{
+			std::array<uint32_t, 256> t{};
+			for (uint32_t i = 0; i < t.size(); ++i)
+			{
+				uint32_t crc = i;
+				for (int b = 0; b < 8; ++b)
+				{
+					crc = crc & 1 ? crc >> 1 ^ 0x82F63B78 : crc >> 1;
+				}
+				t[i] = crc;
+			}
+			return t;
+		}();
+		return table;
+	}
+
+	inline uint32_t crc32c_scalar(uint32_t crc, const uint8_t* p, size_t len)
+	{
+		const auto& table = crc32c_table();
+		for (size_t i = 0; i < len; ++i)
+		{
+			crc = table[(crc ^ p[i]) & 0xFF] ^ crc >> 8;
+		}
+		return crc;
+	}
+
+	// 3 independent streams over thirds of the line hide the latency of the crc32 instruction
+	EZ_TARGET_SSE42
+	inline uint32_t crc32c_sse42(uint32_t crc, const uint8_t* p, size_t len)
+	{
+		const size_t third = len / 24 * 8;
+		uint64_t a = crc;
+		uint64_t b = 0;
+		uint64_t c = 0;
+		for (size_t i = 0; i < third; i += 8)
+		{
+			uint64_t x, y, z;
+			memcpy(&x, p + i, 8);
+			memcpy(&y, p + third + i, 8);
+			memcpy(&z, p + 2 * third + i, 8);
+			a = _mm_crc32_u64(a, x);
+			b = _mm_crc32_u64(b, y);
+			c = _mm_crc32_u64(c, z);
+		}
+		// not a true crc of the line (which would need the streams shifting before they are combined) but as good a hash
+		auto result = static_cast<uint32_t>(_mm_crc32_u32(_mm_crc32_u32(static_cast<uint32_t>(a),
+		                                                                static_cast<uint32_t>(b)),
+		                                                  static_cast<uint32_t>(c)));
+		for (size_t i = 3 * third; i < len; ++i)
+		{
+			result = _mm_crc32_u8(result, p[i]);
+		}
+		return result;
+	}
+}
+
+/**
+ * A hash of 1 in every fingerprintLineStep lines of the frame (and always the last line), good enough to spot a frame
+ * the source has sent before for a fraction of the cost of reading the whole frame.
+ */
+inline uint32_t FingerprintFrame(const uint8_t* data, long length, int height)
+{
+	if (height <= 0 || length <= 0)
+	{
+		return 0;
+	}
+	const auto stride = static_cast<size_t>(length) / height;
+	const auto hash = GetCpuFeatures().sse42 ? frame_fingerprint_detail::crc32c_sse42
+		                  : frame_fingerprint_detail::crc32c_scalar;
+	// a frame of a different size never matches
+	auto crc = static_cast<uint32_t>(length) ^ static_cast<uint32_t>(height) << 16;
+	for (int line = 0; line < height; line += fingerprintLineStep)
+	{
+		crc = hash(crc, data + line * stride, stride);
+	}
+	return hash(crc, data + (height - 1) * stride, stride);
+}
+
+/**
+ * Spots frames which are identical to the previous one, e.g. the repeated fields of 3:2 pulldown or a static picture.
+ */
+class repeat_detector
+{
+public:
+	// true if the frame matches the last one
+	bool IsRepeat(const uint8_t* data, long length, int height)
+	{
+		const auto fingerprint = FingerprintFrame(data, length, height);
+		const auto repeat = mHasFrame && fingerprint == mFingerprint;
+		mFingerprint = fingerprint;
+		mHasFrame = true;
+		if (repeat)
+		{
+			++mConsecutiveRepeats;
+			++mRepeats;
+		}
+		else
+		{
+			mConsecutiveRepeats = 0;
+		}
+		return repeat;
+	}
+
+	// the number of frames in a row, up to and including the last, which were repeats
+	int GetConsecutiveRepeats() const
+	{
+		return mConsecutiveRepeats;
+	}
+
+	uint64_t GetRepeatCount() const
+	{
+		return mRepeats;
+	}
+
+private:
+	uint32_t mFingerprint{0};
+	bool mHasFrame{false};
+	int mConsecutiveRepeats{0};
+	uint64_t mRepeats{0};
+};
+#endif
@@ -0,0 +1,286 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef KERNEL_CALIBRATION_HEADER
+#define KERNEL_CALIBRATION_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <streams.h>
+#include "conversion_registry.h"
+#include "conversion_pool.h"
+
+// how long calibrating a conversion may take including generating its source frame, variants left when it runs out are
+// skipped
+inline constexpr auto calibrationBudget = std::chrono::milliseconds(24);
+// how long each variant is run for, long enough to get past the first touch of the buffers & any frequency change
+inline constexpr auto calibrationVariantBudget = std::chrono::milliseconds(4);
+// a variant whose best frame is this much slower than the fastest variant so far is abandoned
+inline constexpr double calibrationCutoff = 1.25;
+
+/**
+ * A synthetic source frame of the given format filled with noise so no kernel gets to take a shortcut.
+ */
+class calibration_frame
+{
+public:
+	calibration_frame(const pixel_format& pFormat, int pWidth, int pHeight) :
+		mWidth(pWidth),
+		mHeight(pHeight)
+	{
+		DWORD rowBytes;
+		DWORD imageBytes;
+		pFormat.GetImageDimensions(pWidth, pHeight, &rowBytes, &imageBytes);
+		mData.resize(imageBytes);
+		// a word of noise at a time as this is counted against the calibration budget
+		uint32_t seed = 0x9E3779B9;
+		for (size_t i = 0; i < mData.size(); ++i)
+		{
+			if ((i & 3) == 0)
+			{
+				seed = seed * 1664525 + 1013904223;
+			}
+			mData[i] = static_cast<uint8_t>(seed >> (i & 3) * 8);
+		}
+	}
+
+	int GetWidth() const
+	{
+		return mWidth;
+	}
+
+	int GetHeight() const
+	{
+		return mHeight;
+	}
+
+	uint64_t GetFrameIndex() const
+	{
+		return 0;
+	}
+
+	long GetLength() const
+	{
+		return static_cast<long>(mData.size());
+	}
+
+	void Start(void** data)
+	{
+		*data = mData.data();
+	}
+
+	void End()
+	{
+	}
+
+private:
+	int mWidth;
+	int mHeight;
+	std::vector<uint8_t> mData;
+};
+
+namespace calibration_detail
+{
+	using clock = std::chrono::steady_clock;
+
+	/**
+	 * Fastest frame time (in ns) of the writer until the variant budget or the deadline is reached, the first frame is
+	 * cold so it only counts if there is no time for another. Stops as soon as the writer is slower than cutoffNs.
+	 */
+	inline double time_writer(IVideoFrameWriter<calibration_frame>& writer, calibration_frame& src, IMediaSample* dst,
+	                          clock::time_point deadline, double cutoffNs)
+	{
+		auto start = clock::now();
+		writer.WriteTo(&src, dst);
+		auto now = clock::now();
+		auto best = std::chrono::duration<double, std::nano>(now - start).count();
+		const auto end = std::min(now + calibrationVariantBudget, deadline);
+		for (int i = 0; now < end && best <= cutoffNs; ++i)
+		{
+			start = clock::now();
+			writer.WriteTo(&src, dst);
+			now = clock::now();
+			const auto ns = std::chrono::duration<double, std::nano>(now - start).count();
+			best = i == 0 ? ns : std::min(best, ns);
+		}
+		return best;
+	}
+}
+
+/**
+ * Runs the kernel variants (instruction set & with or without stripes) of the conversion on a synthetic frame of the
+ * given size and returns the fastest. The widest instruction sets go first as they are the most likely to win so any
+ * variant still to run when calibrationBudget is spent, or which falls behind the fastest so far, is skipped.
+ */
+inline kernel_choice CalibrateConversion(const log_data& pLogData, const frame_conversion<calibration_frame>& conversion,
+                                         int cx, int cy, conversion_pool* pPool, int pTileLines)
+{
+	const auto deadline = calibration_detail::clock::now() + calibrationBudget;
+
+	calibration_frame src{conversion.source, cx, cy};
+	DWORD rowBytes;
+	DWORD imageBytes;
+	conversion.target.GetImageDimensions(cx, cy, &rowBytes, &imageBytes);
+	const auto dstData = std::make_unique_for_overwrite<uint8_t[]>(imageBytes + 64);
+	auto hr = S_OK;
+	CMediaSample dst(NAME("calibration"), nullptr, &hr, dstData.get(), static_cast<LONG>(imageBytes));
+	const auto pixels = static_cast<double>(cx) * cy;
+	kernel_choice fastest{};
+	bool found = false;
+	for (const auto isa : {ISA_AVX512, ISA_AVX2, ISA_SSSE3, ISA_SSE2, ISA_SCALAR})
+	{
+		if (!GetCpuFeatures().Supports(isa))
+		{
+			continue;
+		}
+		auto writer = conversion.create(pLogData, cx, cy, isa);
+		// kernels only exist for some instruction sets, anything else falls back to one that is timed separately
+		if (writer->GetIsa() != isa)
+		{
+			continue;
+		}
+		writer->SetTileLines(pTileLines);
+		for (const auto striped : {true, false})
+		{
+			if (striped && !pPool)
+			{
+				continue;
+			}
+			if (found && calibration_detail::clock::now() >= deadline)
+			{
+				#ifndef NO_QUILL
+				LOG_TRACE_L1(pLogData.logger, "[{}] Calibration budget spent, skipping {} {} {}", pLogData.prefix,
+				             to_string(conversion.strategy), to_string(isa), striped ? "striped" : "unstriped");
+				#endif
+				continue;
+			}
+			writer->SetConversionPool(striped ? pPool : nullptr);
+			const auto cutoffNs = found
+				                      ? fastest.nsPerPixel * pixels * calibrationCutoff
+				                      : std::numeric_limits<double>::max();
+			const auto nsPerPixel = calibration_detail::time_writer(*writer, src, &dst, deadline, cutoffNs) / pixels;
+
+			#ifndef NO_QUILL
+			LOG_TRACE_L1(pLogData.logger, "[{}] Calibrated {} {} {} at {:.3f} ns/px", pLogData.prefix,
+			             to_string(conversion.strategy), to_string(isa), striped ? "striped" : "unstriped", nsPerPixel);
+			#endif
+
+			if (!found || nsPerPixel < fastest.nsPerPixel)
+			{
+				fastest = {isa, striped, nsPerPixel};
+				found = true;
+			}
+		}
+	}
+	return fastest;
+}
+
+// the fastest variant of a conversion at a resolution
+struct calibrated_kernel
+{
+	frame_writer_strategy strategy;
+	int cx;
+	int cy;
+	kernel_choice choice;
+};
+
+/**
+ * Calibrates conversions on a thread of its own so the streaming thread is never held up by timing kernels, the pin
+ * collects the results once every conversion has been timed. Striped variants run on a pool of the same size as the
+ * pin's but at normal priority so calibration cannot preempt the conversion of live frames.
+ */
+class kernel_calibrator
+{
+public:
+	explicit kernel_calibrator(log_data pLogData) :
+		mLogData(std::move(pLogData))
+	{
+	}
+
+	kernel_calibrator(const kernel_calibrator&) = delete;
+	kernel_calibrator& operator=(const kernel_calibrator&) = delete;
+
+	~kernel_calibrator()
+	{
+		mStopping = true;
+		if (mThread.joinable())
+		{
+			mThread.join();
+		}
+	}
+
+	// true from Start until the results have been taken
+	bool IsBusy() const
+	{
+		return mThread.joinable();
+	}
+
+	void Start(std::vector<frame_conversion<calibration_frame>> pConversions, int cx, int cy, uint8_t pStripes,
+	           int pTileLines)
+	{
+		mDone = false;
+		mThread = std::thread([this, conversions = std::move(pConversions), cx, cy, pStripes, pTileLines]
+		{
+			std::unique_ptr<conversion_pool> pool;
+			if (pStripes > 1)
+			{
+				pool = std::make_unique<conversion_pool>(mLogData, pStripes, false);
+			}
+			std::vector<calibrated_kernel> results;
+			for (const auto& conversion : conversions)
+			{
+				if (mStopping)
+				{
+					break;
+				}
+				results.push_back({
+					conversion.strategy, cx, cy,
+					CalibrateConversion(mLogData, conversion, cx, cy, pool.get(), pTileLines)
+				});
+			}
+			std::lock_guard lock(mMutex);
+			mResults = std::move(results);
+			mDone = true;
+		});
+	}
+
+	// every result once the calibration has finished, nullopt while it is still running
+	std::optional<std::vector<calibrated_kernel>> TakeResults()
+	{
+		if (!mDone)
+		{
+			return std::nullopt;
+		}
+		mThread.join();
+		mDone = false;
+		std::lock_guard lock(mMutex);
+		return std::move(mResults);
+	}
+
+private:
+	log_data mLogData;
+	std::thread mThread;
+	std::mutex mMutex;
+	std::vector<calibrated_kernel> mResults{};
+	std::atomic<bool> mDone{false};
+	std::atomic<bool> mStopping{false};
+};
+#endif
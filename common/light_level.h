@@ -0,0 +1,218 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LIGHT_LEVEL_HEADER
+#define LIGHT_LEVEL_HEADER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <emmintrin.h>
+
+// the histogram (and so the frame average) is sampled from every other pixel of 1 in this many lines, the peak is
+// taken from every pixel
+inline constexpr int lightLevelSampledLines = 4;
+// 16 PQ codes per bin
+inline constexpr int lightLevelHistogramBins = 64;
+// measured values are the maximum over this many seconds of frames
+inline constexpr size_t lightLevelWindowSeconds = 30;
+
+struct measured_light_level
+{
+	int maxCLL{0};
+	int maxFALL{0};
+};
+
+namespace light_level_detail
+{
+	// SMPTE ST 2084 light level in nits of each 10-bit limited range code
+	inline const std::array<double, 1024>& NitsByCode()
+	{
+		static const auto nits = []
+		{
+			constexpr double m1 = 2610.0 / 16384.0;
+			constexpr double m2 = 2523.0 / 4096.0 * 128.0;
+			constexpr double c1 = 3424.0 / 4096.0;
+			constexpr double c2 = 2413.0 / 4096.0 * 32.0;
+			constexpr double c3 = 2392.0 / 4096.0 * 32.0;
+			std::array<double, 1024> n{};
+			for (size_t code = 0; code < n.size(); ++code)
+			{
+				const auto e = std::clamp((static_cast<double>(code) - 64.0) / 876.0, 0.0, 1.0);
+				const auto p = std::pow(e, 1.0 / m2);
+				n[code] = 10000.0 * std::pow(std::max(p - c1, 0.0) / (c2 - c3 * p), 1.0 / m1);
+			}
+			return n;
+		}();
+		return nits;
+	}
+
+	// mean light level of the codes in each histogram bin
+	inline const std::array<double, lightLevelHistogramBins>& NitsByBin()
+	{
+		static const auto nits = []
+		{
+			constexpr size_t codesPerBin = 1024 / lightLevelHistogramBins;
+			std::array<double, lightLevelHistogramBins> n{};
+			for (size_t code = 0; code < 1024; ++code)
+			{
+				n[code / codesPerBin] += NitsByCode()[code] / codesPerBin;
+			}
+			return n;
+		}();
+		return nits;
+	}
+}
+
+/**
+ * Light level of the lines measured by one stripe, merged into the frame once the stripe is done.
+ */
+struct light_level_lines
+{
+	uint16_t peak{0};
+
+	// 16-bit luma samples holding a 10-bit code in the most significant bits, i.e. the Y plane of P010 or P210
+	void Add(const uint8_t* luma, int stride, int width, int firstLine, int lineCount)
+	{
+		// sse2 only has a signed 16-bit max so flip the sign bit on the way in & out
+		const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+		__m128i vPeak = _mm_xor_si128(_mm_set1_epi16(static_cast<short>(peak)), bias);
+		const int simdWidth = width & ~7;
+		for (int line = 0; line < lineCount; ++line)
+		{
+			const auto* y = reinterpret_cast<const uint16_t*>(luma + static_cast<size_t>(line) * stride);
+			for (int x = 0; x < simdWidth; x += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+				vPeak = _mm_max_epi16(vPeak, _mm_xor_si128(v, bias));
+			}
+			for (int x = simdWidth; x < width; ++x)
+			{
+				peak = std::max(peak, y[x]);
+			}
+			if ((firstLine + line) % lightLevelSampledLines == 0)
+			{
+				// every other pixel into alternate histograms so consecutive increments never wait on each other
+				for (int x = 0; x + 3 < width; x += 4)
+				{
+					++counts[0][y[x] >> 10];
+					++counts[1][y[x + 2] >> 10];
+				}
+			}
+		}
+		alignas(16) uint16_t lanes[8];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_xor_si128(vPeak, bias));
+		peak = std::max(peak, *std::ranges::max_element(lanes));
+	}
+
+	uint32_t Count(size_t bin) const
+	{
+		return counts[0][bin] + counts[1][bin];
+	}
+
+private:
+	uint32_t counts[2][lightLevelHistogramBins]{};
+};
+
+/**
+ * Light level of a frame, stripes converted in parallel merge their lines into it as they complete.
+ */
+struct light_level_frame
+{
+	std::atomic<uint16_t> peak{0};
+	std::array<std::atomic<uint32_t>, lightLevelHistogramBins> histogram{};
+
+	void Merge(const light_level_lines& lines)
+	{
+		auto p = peak.load(std::memory_order_relaxed);
+		while (lines.peak > p && !peak.compare_exchange_weak(p, lines.peak, std::memory_order_relaxed))
+		{
+		}
+		for (size_t b = 0; b < histogram.size(); ++b)
+		{
+			if (const auto count = lines.Count(b))
+			{
+				histogram[b].fetch_add(count, std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+/**
+ * A rolling MaxCLL & MaxFALL measured from the frames converted by the writers, used in place of the values in the
+ * HDR infoframe when the source does not send any. Light level is measured from luma rather than max(R,G,B) so
+ * both values are a lower bound on the true content light level, most so for saturated highlights.
+ */
+class light_level_meter
+{
+public:
+	// writers only measure frames while the meter is enabled
+	void SetEnabled(bool pEnabled)
+	{
+		if (pEnabled != mEnabled.exchange(pEnabled, std::memory_order_relaxed) && !pEnabled)
+		{
+			std::lock_guard lock(mMutex);
+			mWindow.fill({});
+		}
+	}
+
+	bool IsEnabled() const
+	{
+		return mEnabled.load(std::memory_order_relaxed);
+	}
+
+	void AddFrame(const light_level_frame& frame)
+	{
+		uint64_t samples = 0;
+		double nits = 0.0;
+		for (size_t b = 0; b < frame.histogram.size(); ++b)
+		{
+			const auto count = frame.histogram[b].load(std::memory_order_relaxed);
+			samples += count;
+			nits += count * light_level_detail::NitsByBin()[b];
+		}
+		const auto cll = light_level_detail::NitsByCode()[frame.peak.load(std::memory_order_relaxed) >> 6];
+		const auto fall = samples ? nits / static_cast<double>(samples) : 0.0;
+
+		std::lock_guard lock(mMutex);
+		auto& current = mWindow[mCurrent];
+		current.maxCLL = std::max(current.maxCLL, static_cast<int>(std::lround(cll)));
+		current.maxFALL = std::max(current.maxFALL, static_cast<int>(std::lround(fall)));
+	}
+
+	// the maximum over the window, to be called once a second as it also moves the window on
+	measured_light_level Measure()
+	{
+		std::lock_guard lock(mMutex);
+		measured_light_level measured{};
+		for (const auto& s : mWindow)
+		{
+			measured.maxCLL = std::max(measured.maxCLL, s.maxCLL);
+			measured.maxFALL = std::max(measured.maxFALL, s.maxFALL);
+		}
+		mCurrent = (mCurrent + 1) % mWindow.size();
+		mWindow[mCurrent] = {};
+		return measured;
+	}
+
+private:
+	std::atomic<bool> mEnabled{false};
+	std::mutex mMutex;
+	std::array<measured_light_level, lightLevelWindowSeconds> mWindow{};
+	size_t mCurrent{0};
+};
+#endif
@@ -0,0 +1,561 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NO_SIGNAL_HEADER
+#define NO_SIGNAL_HEADER
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include "domain.h"
+#include "frame_copy.h"
+
+// a 4K P010 frame is ~12MB so only the formats used most recently are kept
+inline constexpr size_t noSignalFramesCached = 4;
+// the caption drawn in the middle of the frame
+inline constexpr char noSignalText[] = "NO SIGNAL";
+// brightness of the caption as 8-bit full range grey
+inline constexpr int noSignalGrey = 192;
+
+namespace no_signal_detail
+{
+	// repeats pattern across len bytes, a trailing partial pattern is truncated
+	inline void fill_pattern(uint8_t* dst, size_t len, const uint8_t* pattern, size_t patternLen)
+	{
+		if (len < patternLen)
+		{
+			memcpy(dst, pattern, len);
+			return;
+		}
+		memcpy(dst, pattern, patternLen);
+		// double the filled region each pass
+		auto filled = patternLen;
+		while (filled < len)
+		{
+			const auto n = std::min(filled, len - filled);
+			memcpy(dst + filled, dst, n);
+			filled += n;
+		}
+	}
+
+	inline void fill_le16(uint8_t* dst, size_t len, std::initializer_list<uint16_t> words)
+	{
+		uint8_t pattern[8];
+		size_t i = 0;
+		for (const auto w : words)
+		{
+			pattern[i++] = static_cast<uint8_t>(w & 0xFF);
+			pattern[i++] = static_cast<uint8_t>(w >> 8);
+		}
+		fill_pattern(dst, len, pattern, i);
+	}
+
+	inline void fill_le32(uint8_t* dst, size_t len, std::initializer_list<uint32_t> words)
+	{
+		uint8_t pattern[16];
+		size_t i = 0;
+		for (const auto w : words)
+		{
+			for (int b = 0; b < 32; b += 8)
+			{
+				pattern[i++] = static_cast<uint8_t>(w >> b);
+			}
+		}
+		fill_pattern(dst, len, pattern, i);
+	}
+
+	/**
+	 * Renders a black frame of the given format into dst which must be imageSize bytes long. Returns false if the
+	 * format is unknown. YUV is black at the signalled quantisation (limited unless known to be full), RGB is always
+	 * 0 which is black (or clipped to black) whatever the range.
+	 */
+	inline bool render_black(uint8_t* dst, const video_format& vf)
+	{
+		const auto fullRange = vf.quantisation == QUANTISATION_FULL;
+		const uint8_t y8 = fullRange ? 0 : 16;
+		const uint8_t c8 = 128;
+		const uint16_t y10 = fullRange ? 0 : 64;
+		const uint16_t c10 = 512;
+		const size_t size = vf.imageSize;
+		const size_t lumaPlane = static_cast<size_t>(vf.lineLength) * vf.cy;
+
+		switch (vf.pixelFormat.format)
+		{
+		case pixel_format::NV12:
+		case pixel_format::NV16:
+		case pixel_format::YV16:
+			memset(dst, y8, lumaPlane);
+			memset(dst + lumaPlane, c8, size - lumaPlane);
+			return true;
+		case pixel_format::P010:
+		case pixel_format::P210:
+			// msb aligned
+			fill_le16(dst, lumaPlane, {static_cast<uint16_t>(y10 << 6)});
+			fill_le16(dst + lumaPlane, size - lumaPlane, {static_cast<uint16_t>(c10 << 6)});
+			return true;
+		case pixel_format::YUY2:
+			{
+				const uint8_t pattern[4]{y8, c8, y8, c8};
+				fill_pattern(dst, size, pattern, sizeof(pattern));
+				return true;
+			}
+		case pixel_format::UYVY:
+		case pixel_format::YUV2:
+			{
+				const uint8_t pattern[4]{c8, y8, c8, y8};
+				fill_pattern(dst, size, pattern, sizeof(pattern));
+				return true;
+			}
+		case pixel_format::Y210:
+			fill_le16(dst, size, {
+				          static_cast<uint16_t>(y10 << 6), static_cast<uint16_t>(c10 << 6),
+				          static_cast<uint16_t>(y10 << 6), static_cast<uint16_t>(c10 << 6)
+			          });
+			return true;
+		case pixel_format::V210:
+			// 6 pixels in 4 words, Cb Y Cr | Y Cb Y | Cr Y Cb | Y Cr Y so the words alternate between 2 layouts
+			fill_le32(dst, size, {
+				          c10 | static_cast<uint32_t>(y10) << 10 | static_cast<uint32_t>(c10) << 20,
+				          y10 | static_cast<uint32_t>(c10) << 10 | static_cast<uint32_t>(y10) << 20
+			          });
+			return true;
+		case pixel_format::AYUV:
+			{
+				// V U Y A
+				const uint8_t pattern[4]{c8, c8, y8, 0xFF};
+				fill_pattern(dst, size, pattern, sizeof(pattern));
+				return true;
+			}
+		case pixel_format::AY10:
+			{
+				// big endian, 2 bits of padding then chroma, Y and opaque alpha
+				const uint32_t w = static_cast<uint32_t>(c10) << 20 | static_cast<uint32_t>(y10) << 10 | 0x3FF;
+				const uint8_t pattern[4]{
+					static_cast<uint8_t>(w >> 24), static_cast<uint8_t>(w >> 16), static_cast<uint8_t>(w >> 8),
+					static_cast<uint8_t>(w)
+				};
+				fill_pattern(dst, size, pattern, sizeof(pattern));
+				return true;
+			}
+		case pixel_format::ARGB:
+		case pixel_format::BGRA:
+		case pixel_format::RGBA:
+			{
+				// opaque, the alpha byte is wherever the name puts it
+				uint8_t pattern[4]{};
+				pattern[vf.pixelFormat.name[0] == 'A' ? 0 : 3] = 0xFF;
+				fill_pattern(dst, size, pattern, sizeof(pattern));
+				return true;
+			}
+		case pixel_format::BGR24:
+		case pixel_format::BGR10:
+		case pixel_format::RGB48:
+		case pixel_format::R210:
+		case pixel_format::R12B:
+		case pixel_format::R12L:
+		case pixel_format::R10B:
+		case pixel_format::R10L:
+			memset(dst, 0, size);
+			return true;
+		default: // NOLINT(clang-diagnostic-covered-switch-default)
+			return false;
+		}
+	}
+
+	// 5x7 glyphs for the letters of the caption, the msb of the 5 bits is the leftmost column
+	inline const std::array<uint8_t, 7>& glyph(char c)
+	{
+		static constexpr std::array<uint8_t, 7> space{};
+		static constexpr std::array<uint8_t, 7> a{0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11};
+		static constexpr std::array<uint8_t, 7> g{0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F};
+		static constexpr std::array<uint8_t, 7> i{0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x1F};
+		static constexpr std::array<uint8_t, 7> l{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F};
+		static constexpr std::array<uint8_t, 7> n{0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x11};
+		static constexpr std::array<uint8_t, 7> o{0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E};
+		static constexpr std::array<uint8_t, 7> s{0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E};
+		switch (c)
+		{
+		case 'A': return a;
+		case 'G': return g;
+		case 'I': return i;
+		case 'L': return l;
+		case 'N': return n;
+		case 'O': return o;
+		case 'S': return s;
+		default: return space;
+		}
+	}
+
+	inline uint32_t load_le32(const uint8_t* p)
+	{
+		return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+	}
+
+	inline void store_le32(uint8_t* p, uint32_t w)
+	{
+		for (int b = 0; b < 4; ++b)
+		{
+			p[b] = static_cast<uint8_t>(w >> b * 8);
+		}
+	}
+
+	inline uint32_t load_be32(const uint8_t* p)
+	{
+		return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+	}
+
+	inline void store_be32(uint8_t* p, uint32_t w)
+	{
+		for (int b = 0; b < 4; ++b)
+		{
+			p[b] = static_cast<uint8_t>(w >> (24 - b * 8));
+		}
+	}
+
+	inline void store_le16(uint8_t* p, uint16_t w)
+	{
+		p[0] = static_cast<uint8_t>(w & 0xFF);
+		p[1] = static_cast<uint8_t>(w >> 8);
+	}
+
+	// noSignalGrey at each depth, only luma is written for YUV so the chroma left by render_black keeps it grey
+	struct grey_levels
+	{
+		explicit grey_levels(bool fullRange) :
+			y8(static_cast<uint8_t>(fullRange ? noSignalGrey : 16 + noSignalGrey * 219 / 255)),
+			y10(static_cast<uint16_t>(fullRange ? noSignalGrey * 1023 / 255 : 64 + noSignalGrey * 876 / 255))
+		{
+		}
+
+		uint8_t y8;
+		uint16_t y10;
+		uint8_t rgb8{noSignalGrey};
+		uint32_t rgb10{noSignalGrey * 1023 / 255};
+		int rgb12{noSignalGrey * 4095 / 255};
+		uint16_t rgb16{noSignalGrey * 257};
+	};
+
+	/**
+	 * Sets the pixel at x, y of a frame rendered by render_black to grey, stride is the length of a line of the
+	 * (first plane of the) frame.
+	 */
+	inline void grey_pixel(uint8_t* dst, const video_format& vf, size_t stride, int x, int y, const grey_levels& g)
+	{
+		// RGB with a positive height is stored bottom up
+		const auto row = vf.pixelFormat.rgb && !vf.bottomUpDib ? vf.cy - 1 - y : y;
+		auto* line = dst + static_cast<size_t>(row) * stride;
+		switch (vf.pixelFormat.format)
+		{
+		case pixel_format::NV12:
+		case pixel_format::NV16:
+		case pixel_format::YV16:
+			line[x] = g.y8;
+			return;
+		case pixel_format::P010:
+		case pixel_format::P210:
+			store_le16(line + static_cast<size_t>(x) * 2, static_cast<uint16_t>(g.y10 << 6));
+			return;
+		case pixel_format::YUY2:
+			line[static_cast<size_t>(x) * 2] = g.y8;
+			return;
+		case pixel_format::UYVY:
+		case pixel_format::YUV2:
+			line[static_cast<size_t>(x) * 2 + 1] = g.y8;
+			return;
+		case pixel_format::Y210:
+			store_le16(line + static_cast<size_t>(x) * 4, static_cast<uint16_t>(g.y10 << 6));
+			return;
+		case pixel_format::V210:
+			{
+				// Y of the nth pixel of a group of 6 is the 2n+1th of the 12 samples packed 3 to a word
+				const auto sample = x % 6 * 2 + 1;
+				auto* word = line + static_cast<size_t>(x / 6) * 16 + sample / 3 * 4;
+				const auto shift = sample % 3 * 10;
+				store_le32(word, (load_le32(word) & ~(0x3FFu << shift)) | static_cast<uint32_t>(g.y10) << shift);
+				return;
+			}
+		case pixel_format::AYUV:
+			line[static_cast<size_t>(x) * 4 + 2] = g.y8;
+			return;
+		case pixel_format::AY10:
+			{
+				auto* word = line + static_cast<size_t>(x) * 4;
+				store_be32(word, (load_be32(word) & ~(0x3FFu << 10)) | static_cast<uint32_t>(g.y10) << 10);
+				return;
+			}
+		case pixel_format::ARGB:
+		case pixel_format::BGRA:
+		case pixel_format::RGBA:
+			{
+				auto* p = line + static_cast<size_t>(x) * 4;
+				const auto alpha = vf.pixelFormat.name[0] == 'A' ? 0 : 3;
+				for (int i = 0; i < 4; ++i)
+				{
+					if (i != alpha)
+					{
+						p[i] = g.rgb8;
+					}
+				}
+				return;
+			}
+		case pixel_format::BGR24:
+			memset(line + static_cast<size_t>(x) * 3, g.rgb8, 3);
+			return;
+		case pixel_format::BGR10:
+			{
+				auto* word = line + static_cast<size_t>(x) * 4;
+				store_le32(word, (load_le32(word) & 0xC0000000) | g.rgb10 | g.rgb10 << 10 | g.rgb10 << 20);
+				return;
+			}
+		case pixel_format::R210:
+			{
+				auto* word = line + static_cast<size_t>(x) * 4;
+				store_be32(word, (load_be32(word) & 0xC0000000) | g.rgb10 | g.rgb10 << 10 | g.rgb10 << 20);
+				return;
+			}
+		case pixel_format::R10B:
+		case pixel_format::R10L:
+			{
+				auto* word = line + static_cast<size_t>(x) * 4;
+				const auto bigEndian = vf.pixelFormat.format == pixel_format::R10B;
+				const auto w = (bigEndian ? load_be32(word) : load_le32(word)) & 0x3;
+				const auto grey = w | g.rgb10 << 2 | g.rgb10 << 12 | g.rgb10 << 22;
+				bigEndian ? store_be32(word, grey) : store_le32(word, grey);
+				return;
+			}
+		case pixel_format::RGB48:
+			for (int c = 0; c < 3; ++c)
+			{
+				store_le16(line + static_cast<size_t>(x) * 6 + c * 2, g.rgb16);
+			}
+			return;
+		case pixel_format::R12B:
+		case pixel_format::R12L:
+			{
+				// 8 pixels of 12-bit samples packed into 36 bytes, the big endian form reverses each 4 byte word
+				auto* group = line + static_cast<size_t>(x / 8) * 36;
+				const auto bigEndian = vf.pixelFormat.format == pixel_format::R12B;
+				const auto byte = [&](int b) -> uint8_t& { return group[bigEndian ? (b & ~3) | (3 - (b & 3)) : b]; };
+				for (int c = 0; c < 3; ++c)
+				{
+					const auto sample = x % 8 * 3 + c;
+					const auto b = sample / 2 * 3;
+					if (sample & 1)
+					{
+						byte(b + 1) = static_cast<uint8_t>((byte(b + 1) & 0x0F) | (g.rgb12 & 0xF) << 4);
+						byte(b + 2) = static_cast<uint8_t>(g.rgb12 >> 4);
+					}
+					else
+					{
+						byte(b) = static_cast<uint8_t>(g.rgb12 & 0xFF);
+						byte(b + 1) = static_cast<uint8_t>((byte(b + 1) & 0xF0) | g.rgb12 >> 8);
+					}
+				}
+				return;
+			}
+		default: // NOLINT(clang-diagnostic-covered-switch-default)
+			return;
+		}
+	}
+
+	/**
+	 * Renders a black frame of the given format with noSignalText in grey across the middle into dst which must be
+	 * imageSize bytes long. Returns false if the format is unknown.
+	 */
+	inline bool render_no_signal(uint8_t* dst, const video_format& vf)
+	{
+		if (!render_black(dst, vf))
+		{
+			return false;
+		}
+
+		// each glyph is 5 cells wide with a 1 cell gap, roughly 45% of the width of the frame
+		constexpr int glyphs = sizeof(noSignalText) - 1;
+		constexpr int columns = glyphs * 6 - 1;
+		const auto cell = std::min({std::max(vf.cx / 120, 1), vf.cx / columns, vf.cy / 7});
+		if (cell == 0)
+		{
+			return true;
+		}
+
+		// Y210 is sized as if it were planar, each line actually holds 4 bytes per pixel
+		const auto stride = static_cast<size_t>(vf.lineLength) * (vf.pixelFormat == Y210 ? 2 : 1);
+		const grey_levels levels{vf.quantisation == QUANTISATION_FULL};
+		const auto left = (vf.cx - columns * cell) / 2;
+		const auto top = (vf.cy - 7 * cell) / 2;
+		for (int i = 0; i < glyphs; ++i)
+		{
+			const auto& rows = glyph(noSignalText[i]);
+			for (int r = 0; r < 7; ++r)
+			{
+				for (int c = 0; c < 5; ++c)
+				{
+					if ((rows[r] >> (4 - c) & 1) == 0)
+					{
+						continue;
+					}
+					const auto x0 = left + (i * 6 + c) * cell;
+					const auto y0 = top + r * cell;
+					for (int y = y0; y < y0 + cell; ++y)
+					{
+						for (int x = x0; x < x0 + cell; ++x)
+						{
+							grey_pixel(dst, vf, stride, x, y, levels);
+						}
+					}
+				}
+			}
+		}
+		return true;
+	}
+}
+
+/**
+ * Frames shown while there is no signal, black with a grey "NO SIGNAL" caption, one per output format & resolution. A
+ * frame is rendered when that format is negotiated so a signal dropout only costs a single copy into each sample and
+ * the pin can keep the media type the renderer already has rather than switching mode to show a no signal image and
+ * then switching back again.
+ */
+class no_signal_frames
+{
+public:
+	/**
+	 * Renders the frame for this format if it is not already cached.
+	 */
+	void Prepare(const video_format& vf)
+	{
+		Get(vf);
+	}
+
+	/**
+	 * The frame for this format, imageSize bytes long, or nullptr if the format cannot be rendered.
+	 */
+	const uint8_t* Get(const video_format& vf)
+	{
+		const auto fullRange = vf.quantisation == QUANTISATION_FULL;
+		const auto match = std::ranges::find_if(mFrames, [&](const entry& e)
+		{
+			return e.format == vf.pixelFormat.format && e.cx == vf.cx && e.cy == vf.cy
+				&& e.fullRange == fullRange && e.bottomUp == vf.bottomUpDib && e.data.size() == vf.imageSize;
+		});
+		if (match != mFrames.end())
+		{
+			// most recently used first
+			std::rotate(mFrames.begin(), match, match + 1);
+			return mFrames.front().data.data();
+		}
+
+		entry e{
+			.format = vf.pixelFormat.format,
+			.cx = vf.cx,
+			.cy = vf.cy,
+			.fullRange = fullRange,
+			.bottomUp = vf.bottomUpDib,
+			.data = std::vector<uint8_t>(vf.imageSize)
+		};
+		if (vf.imageSize == 0 || !no_signal_detail::render_no_signal(e.data.data(), vf))
+		{
+			return nullptr;
+		}
+		if (mFrames.size() == noSignalFramesCached)
+		{
+			mFrames.pop_back();
+		}
+		mFrames.insert(mFrames.begin(), std::move(e));
+		return mFrames.front().data.data();
+	}
+
+	void Clear()
+	{
+		mFrames.clear();
+	}
+
+	/**
+	 * Copies a frame returned by Get into dst line by line where each line of each plane is padded to the width the
+	 * renderer asked for, dst must be at least PaddedImageSize bytes long.
+	 */
+	static void CopyTo(uint8_t* dst, const uint8_t* frame, const video_format& vf, int pixelsToPad)
+	{
+		if (pixelsToPad == 0)
+		{
+			copy_frame(dst, frame, vf.imageSize);
+			return;
+		}
+		DWORD paddedLineLength;
+		DWORD paddedImageSize;
+		vf.pixelFormat.GetImageDimensions(vf.cx + pixelsToPad, vf.cy, &paddedLineLength, &paddedImageSize);
+
+		const size_t srcStride = vf.lineLength;
+		const size_t dstStride = paddedLineLength;
+		const auto copyPlane = [&](size_t srcOffset, size_t dstOffset, size_t lineBytes, size_t srcPitch,
+		                           size_t dstPitch, int lines)
+		{
+			for (int y = 0; y < lines; ++y)
+			{
+				memcpy(dst + dstOffset + y * dstPitch, frame + srcOffset + y * srcPitch, lineBytes);
+			}
+		};
+		const auto srcLuma = srcStride * vf.cy;
+		const auto dstLuma = dstStride * vf.cy;
+		switch (vf.pixelFormat.format)
+		{
+		case pixel_format::NV12:
+		case pixel_format::P010:
+			copyPlane(0, 0, srcStride, srcStride, dstStride, vf.cy);
+			copyPlane(srcLuma, dstLuma, srcStride, srcStride, dstStride, vf.cy / 2);
+			break;
+		case pixel_format::NV16:
+		case pixel_format::P210:
+			copyPlane(0, 0, srcStride, srcStride, dstStride, vf.cy * 2);
+			break;
+		case pixel_format::YV16:
+			copyPlane(0, 0, srcStride, srcStride, dstStride, vf.cy);
+			copyPlane(srcLuma, dstLuma, srcStride / 2, srcStride / 2, dstStride / 2, vf.cy * 2);
+			break;
+		case pixel_format::Y210:
+			// sized as if it were planar, each line actually holds 4 bytes per pixel
+			copyPlane(0, 0, srcStride * 2, srcStride * 2, dstStride * 2, vf.cy);
+			break;
+		default:
+			copyPlane(0, 0, srcStride, srcStride, dstStride, vf.cy);
+		}
+	}
+
+	// the size of a frame whose lines are padded by pixelsToPad
+	static DWORD PaddedImageSize(const video_format& vf, int pixelsToPad)
+	{
+		DWORD paddedLineLength;
+		DWORD paddedImageSize;
+		vf.pixelFormat.GetImageDimensions(vf.cx + pixelsToPad, vf.cy, &paddedLineLength, &paddedImageSize);
+		return paddedImageSize;
+	}
+
+private:
+	struct entry
+	{
+		decltype(pixel_format::format) format;
+		int cx;
+		int cy;
+		bool fullRange;
+		bool bottomUp;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<entry> mFrames{};
+};
+
+#endif
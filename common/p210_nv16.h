@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef P210_NV16_HEADER
+#define P210_NV16_HEADER
+
+#include "VideoFrameWriter.h"
+#include "dither.h"
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * P210 and NV16 share a layout (a Y plane followed by a full height interleaved UV plane) so each plane is converted
+ * line by line from 16-bit to dithered 8-bit samples.
+ */
+template <typename VF>
+class p210_nv16 : public IVideoFrameWriter<VF>
+{
+public:
+	p210_nv16(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &NV16)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvertY = convert_avx2<false>;
+			mConvertUV = convert_avx2<true>;
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("P210 to NV16 (dithered)");
+	}
+
+	~p210_nv16() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		const auto actualWidth = width + this->mPixelsToPad;
+		const auto pixelCount = actualWidth * height;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		auto outSpan = std::span(outData, dstSize);
+		uint8_t* yPlane = outSpan.subspan(0, pixelCount).data();
+		uint8_t* uvPlane = outSpan.subspan(pixelCount, pixelCount).data();
+
+		const int srcStride = width * 2;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		// stripes start on an even line so the dither pattern lines up across them
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvertY(srcLines, srcStride, yPlane + firstLine * actualWidth, width, lineCount, this->mPixelsToPad);
+		});
+		this->ConvertStripes(sourceData + srcStride * height, srcStride, height,
+		                     [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		                     {
+			                     mConvertUV(srcLines, srcStride, uvPlane + firstLine * actualWidth, width, lineCount,
+			                                this->mPixelsToPad);
+		                     });
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to NV16 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height, int pixelsToPad);
+
+	// a U, V pair shares a threshold so the dither pattern repeats every 2 chroma columns
+	template <bool Chroma>
+	static void convert_line_scalar(const uint16_t* srcLine, uint8_t* dstLine, int lineNo, int x, int width)
+	{
+		for (; x < width; ++x)
+		{
+			dstLine[x] = dither::to_8bit(srcLine[x], dither::threshold(lineNo, Chroma ? x >> 1 : x));
+		}
+	}
+
+	template <bool Chroma>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = width + pixelsToPad;
+		const int simdWidth = width & ~31;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint16_t* srcLine = reinterpret_cast<const uint16_t*>(src + lineNo * srcStride);
+			uint8_t* dstLine = dst + lineNo * dstStride;
+			const __m256i thresholds = Chroma
+				                           ? dither::chroma_thresholds_avx2(lineNo)
+				                           : dither::luma_thresholds_avx2(lineNo);
+
+			for (int x = 0; x < simdWidth; x += 32) // 2 x 16 samples per pass
+			{
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x + 16));
+				const __m256i packed = _mm256_packus_epi16(dither::to_8bit_avx2(a, thresholds),
+				                                           dither::to_8bit_avx2(b, thresholds));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLine + x),
+				                    _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+			}
+			convert_line_scalar<Chroma>(srcLine, dstLine, lineNo, simdWidth, width);
+		}
+		return true;
+	}
+
+	template <bool Chroma>
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = width + pixelsToPad;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			convert_line_scalar<Chroma>(reinterpret_cast<const uint16_t*>(src + lineNo * srcStride),
+			                            dst + lineNo * dstStride, lineNo, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvertY{convert_scalar<false>};
+	convert_fn mConvertUV{convert_scalar<true>};
+};
+#endif
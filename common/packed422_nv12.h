@@ -0,0 +1,270 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PACKED422_NV12_HEADER
+#define PACKED422_NV12_HEADER
+
+#include "VideoFrameWriter.h"
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * Converts packed 8-bit 4:2:2 to NV12, the chroma of each pair of lines is averaged as it is deinterleaved so the 4:2:0
+ * output is written in a single pass over the source.
+ *
+ * UYVY (and 2vuy which has the same byte order) is u - y - v - y, YUY2 is y - u - y - v. Either way the chroma bytes of
+ * a line are already in the U, V order of an NV12 UV row.
+ */
+template <typename VF, bool LumaFirst>
+class packed422_nv12 : public IVideoFrameWriter<VF>
+{
+public:
+	packed422_nv12(const log_data& pLogData, int pX, int pY, const char* pSourceName,
+	               cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &NV12)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		const auto conversion = std::string(pSourceName) + " to NV12";
+		this->LogKernel(conversion.c_str());
+	}
+
+	~packed422_nv12() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		const auto actualWidth = width + this->mPixelsToPad;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// NV12 format: full res Y plane followed by a half height interleaved UV plane
+		auto ySize = actualWidth * height;
+		auto uvSize = actualWidth * (height / 2);
+
+		auto outSpan = std::span(outData, dstSize);
+		uint8_t* yPlane = outSpan.subspan(0, ySize).data();
+		uint8_t* uvPlane = outSpan.subspan(ySize, uvSize).data();
+
+		const int srcStride = width * 2;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		// stripes start on an even line so each one owns whole rows of the UV plane
+		const output_plane planes[]{{yPlane, actualWidth}, {uvPlane, actualWidth, 1}};
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(nullptr, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint8_t>(measures, dst[0], actualWidth, width, firstLine, lineCount,
+			                                        [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * actualWidth,
+				         dst[1] + (line >> 1) * actualWidth, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to NV12 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uvPlane, int width,
+	                           int height, int pixelsToPad);
+
+	static constexpr int lumaOffset = LumaFirst ? 0 : 1;
+	static constexpr int chromaOffset = LumaFirst ? 1 : 0;
+
+	// converts the pixels of a pair of lines from x (which must be even) to the end of the line
+	static void convert_pair_scalar(const uint8_t* src0, const uint8_t* src1, uint8_t* yOut0, uint8_t* yOut1,
+	                                uint8_t* uvOut, int x, int width)
+	{
+		for (; x < width; x += 2) // 2 pixels per pass
+		{
+			const int i = x * 2;
+			yOut0[x] = src0[i + lumaOffset];
+			yOut0[x + 1] = src0[i + lumaOffset + 2];
+			yOut1[x] = src1[i + lumaOffset];
+			yOut1[x + 1] = src1[i + lumaOffset + 2];
+			uvOut[x] = static_cast<uint8_t>((src0[i + chromaOffset] + src1[i + chromaOffset] + 1) >> 1);
+			uvOut[x + 1] = static_cast<uint8_t>((src0[i + chromaOffset + 2] + src1[i + chromaOffset + 2] + 1) >> 1);
+		}
+	}
+
+	// an odd line at the bottom of the frame has no chroma row of its own
+	static void convert_luma_scalar(const uint8_t* src, uint8_t* yOut, int width)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			yOut[x] = src[x * 2 + lumaOffset];
+		}
+	}
+
+	EZ_TARGET_AVX2
+	static __m256i extract_luma(__m256i a, __m256i b, __m256i lowBytes)
+	{
+		if constexpr (LumaFirst)
+		{
+			return _mm256_packus_epi16(_mm256_and_si256(a, lowBytes), _mm256_and_si256(b, lowBytes));
+		}
+		else
+		{
+			return _mm256_packus_epi16(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8));
+		}
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uvPlane, int width,
+	                         int height, int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, yPlane, uvPlane, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+		const int yWidth = width + pixelsToPad;
+		const int simdWidth = width & ~31;
+
+		int lineNo = 0;
+		for (; lineNo + 1 < height; lineNo += 2)
+		{
+			const uint8_t* src0 = src + lineNo * srcStride;
+			const uint8_t* src1 = src0 + srcStride;
+			uint8_t* yOut0 = yPlane + lineNo * yWidth;
+			uint8_t* yOut1 = yOut0 + yWidth;
+			uint8_t* uvOut = uvPlane + lineNo / 2 * yWidth;
+			for (int x = 0; x < simdWidth; x += 32) // 2 x 256 bits per line = 32 pixels per pass
+			{
+				const __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 2));
+				const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 2 + 32));
+				const __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 2));
+				const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 2 + 32));
+
+				// packus works per lane so the qwords come out in 0, 2, 1, 3 order
+				const __m256i y0 = _mm256_permute4x64_epi64(extract_luma(a0, b0, lowBytes), _MM_SHUFFLE(3, 1, 2, 0));
+				const __m256i y1 = _mm256_permute4x64_epi64(extract_luma(a1, b1, lowBytes), _MM_SHUFFLE(3, 1, 2, 0));
+
+				// average every byte of the 2 lines then keep only the chroma
+				const __m256i avgA = _mm256_avg_epu8(a0, a1);
+				const __m256i avgB = _mm256_avg_epu8(b0, b1);
+				__m256i uv;
+				if constexpr (LumaFirst)
+				{
+					uv = _mm256_packus_epi16(_mm256_srli_epi16(avgA, 8), _mm256_srli_epi16(avgB, 8));
+				}
+				else
+				{
+					uv = _mm256_packus_epi16(_mm256_and_si256(avgA, lowBytes), _mm256_and_si256(avgB, lowBytes));
+				}
+				uv = _mm256_permute4x64_epi64(uv, _MM_SHUFFLE(3, 1, 2, 0));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(yOut0 + x), y0);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(yOut1 + x), y1);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(uvOut + x), uv);
+			}
+			convert_pair_scalar(src0, src1, yOut0, yOut1, uvOut, simdWidth, width);
+		}
+		if (lineNo < height)
+		{
+			convert_luma_scalar(src + lineNo * srcStride, yPlane + lineNo * yWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uvPlane, int width,
+	                           int height, int pixelsToPad)
+	{
+		const int yWidth = width + pixelsToPad;
+
+		int lineNo = 0;
+		for (; lineNo + 1 < height; lineNo += 2)
+		{
+			convert_pair_scalar(src + lineNo * srcStride, src + (lineNo + 1) * srcStride, yPlane + lineNo * yWidth,
+			                    yPlane + (lineNo + 1) * yWidth, uvPlane + lineNo / 2 * yWidth, 0, width);
+		}
+		if (lineNo < height)
+		{
+			convert_luma_scalar(src + lineNo * srcStride, yPlane + lineNo * yWidth, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+
+template <typename VF>
+class uyvy_nv12 : public packed422_nv12<VF, false>
+{
+public:
+	uyvy_nv12(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		packed422_nv12<VF, false>(pLogData, pX, pY, "UYVY", pMaxIsa)
+	{
+	}
+};
+
+template <typename VF>
+class yuv2_nv12 : public packed422_nv12<VF, false>
+{
+public:
+	yuv2_nv12(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		packed422_nv12<VF, false>(pLogData, pX, pY, "YUV2", pMaxIsa)
+	{
+	}
+};
+
+template <typename VF>
+class yuy2_nv12 : public packed422_nv12<VF, true>
+{
+public:
+	yuy2_nv12(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		packed422_nv12<VF, true>(pLogData, pX, pY, "YUY2", pMaxIsa)
+	{
+	}
+};
+#endif
@@ -0,0 +1,121 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PACKED_RGB10_HEADER
+#define PACKED_RGB10_HEADER
+
+#include <cstdint>
+#include "cpu_features.h"
+
+/**
+ * Unpacks 10-bit RGB packed into 32 bits per pixel (r210, bgr10, R10b, R10l) to RGB48.
+ *
+ * Every 10-bit component lies within some pair of adjacent bytes of its pixel so each output word is formed by picking
+ * those 2 bytes (hi, lo), shifting left so the component occupies bits 15-6 and masking off the rest.
+ */
+namespace packed_rgb10
+{
+	struct layout
+	{
+		// byte offsets (within the pixel) of the high & low byte of the 16 bits holding R, G & B
+		uint8_t hiByte[3];
+		uint8_t loByte[3];
+		// left shift which moves the component to bits 15-6 of those 16 bits
+		uint8_t shift[3];
+	};
+
+	// big endian, 2 bits padding then R, G, B
+	inline constexpr layout r210{{0, 1, 2}, {1, 2, 3}, {2, 4, 6}};
+	// little endian, 2 bits padding then B, G, R
+	inline constexpr layout bgr10{{1, 2, 3}, {0, 1, 2}, {6, 4, 2}};
+	// big endian, R, G, B then 2 bits padding
+	inline constexpr layout r10b{{0, 1, 2}, {1, 2, 3}, {0, 2, 4}};
+	// little endian, R, G, B then 2 bits padding
+	inline constexpr layout r10l{{3, 2, 1}, {2, 1, 0}, {0, 2, 4}};
+
+	/*
+	 * 16 pixels per pass produce 48 words = 3 whole ymm. Each 128 bit output lane j holds words 8j..8j+7 which come
+	 * from at most 4 consecutive pixels starting at pixel 8j/3 so vpermd first moves those pixels into the lane then
+	 * vpshufb picks the 2 bytes for each word and vpmullw shifts each word by its own amount (AVX2 has no 16-bit
+	 * variable shift).
+	 */
+	struct avx2_tables
+	{
+		alignas(32) int32_t perm[3][8];
+		alignas(32) int8_t shuffle[3][32];
+		alignas(32) int16_t multiplier[3][16];
+	};
+
+	// pixel offset of each of the 3 source loads, all loads stay within the 16 pixels
+	inline constexpr int avx2LoadOffset[3] = {0, 5, 8};
+
+	constexpr avx2_tables make_avx2_tables(const layout& l)
+	{
+		avx2_tables t{};
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int half = 0; half < 2; ++half)
+			{
+				const int lane = k * 2 + half;
+				const int firstPixel = lane * 8 / 3;
+				for (int d = 0; d < 4; ++d)
+				{
+					const int idx = firstPixel - avx2LoadOffset[k] + d;
+					t.perm[k][half * 4 + d] = idx > 7 ? 7 : idx;
+				}
+				for (int i = 0; i < 8; ++i)
+				{
+					const int word = lane * 8 + i;
+					const int pixel = word / 3 - firstPixel;
+					const int component = word % 3;
+					t.shuffle[k][half * 16 + i * 2] = static_cast<int8_t>(pixel * 4 + l.loByte[component]);
+					t.shuffle[k][half * 16 + i * 2 + 1] = static_cast<int8_t>(pixel * 4 + l.hiByte[component]);
+					t.multiplier[k][half * 8 + i] = static_cast<int16_t>(1 << l.shift[component]);
+				}
+			}
+		}
+		return t;
+	}
+
+	/**
+	 * Converts the first width & ~15 pixels of a line, returns the number of pixels converted.
+	 */
+	EZ_TARGET_AVX2
+	inline int convert_line_avx2(const avx2_tables& t, const uint32_t* srcLine, uint16_t* dstLine, int width)
+	{
+		const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFFC0));
+		__m256i perm[3], shuffle[3], multiplier[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			perm[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(t.perm[k]));
+			shuffle[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(t.shuffle[k]));
+			multiplier[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(t.multiplier[k]));
+		}
+		const int simdWidth = width & ~15;
+		for (int x = 0; x < simdWidth; x += 16)
+		{
+			__m256i* out = reinterpret_cast<__m256i*>(dstLine + x * 3);
+			for (int k = 0; k < 3; ++k)
+			{
+				const __m256i px = _mm256_loadu_si256(
+					reinterpret_cast<const __m256i*>(srcLine + x + avx2LoadOffset[k]));
+				const __m256i lanes = _mm256_permutevar8x32_epi32(px, perm[k]);
+				const __m256i words = _mm256_shuffle_epi8(lanes, shuffle[k]);
+				_mm256_storeu_si256(out + k, _mm256_and_si256(_mm256_mullo_epi16(words, multiplier[k]), mask));
+			}
+		}
+		return simdWidth;
+	}
+}
+#endif
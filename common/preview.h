@@ -0,0 +1,749 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PREVIEW_HEADER
+#define PREVIEW_HEADER
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <emmintrin.h>
+#include "domain.h"
+
+// the preview is delivered at no more than this rate whatever the rate of the captured frames
+inline constexpr int previewFramesPerSecond = 10;
+// the preview is 1/4 or 1/8 of the size of the captured frame in each dimension
+inline constexpr int minPreviewScale = 4;
+inline constexpr int maxPreviewScale = 8;
+// lines of the captured frame box filtered into one line of preview chroma at the largest scale, stripes of a frame
+// being previewed are made of whole groups so every line of the preview is written by a single stripe
+inline constexpr int previewGroupLines = 2 * maxPreviewScale;
+
+/**
+ * The layout of the planar output a preview is box filtered from, a Y plane followed by either an interleaved UV plane
+ * or separate U & V planes.
+ */
+struct preview_source
+{
+	int width{0};
+	int height{0};
+	// 1 for 8-bit samples, 2 for 16-bit samples holding a 10-bit code in the most significant bits
+	int bytesPerSample{1};
+	// 2 for an interleaved UV plane, 3 for U & V planes
+	int planes{2};
+	// log2 of the vertical chroma subsampling, i.e. 1 for 4:2:0
+	int chromaVShift{0};
+};
+
+// an NV12 picture of a converted frame scaled down by scale in each dimension
+struct preview_frame
+{
+	video_format videoFormat{};
+	preview_source source{};
+	int scale{minPreviewScale};
+	std::vector<uint8_t> data{};
+};
+
+// the format of the preview of frames in the given format
+inline video_format ScaledVideoFormat(video_format format, int scale)
+{
+	format.cx = format.cx / scale & ~1;
+	format.cy = format.cy / scale & ~1;
+	format.pixelFormat = NV12;
+	format.fps = std::min(format.fps, static_cast<double>(previewFramesPerSecond));
+	format.frameInterval = static_cast<LONGLONG>(static_cast<double>(dshowTicksPerSecond) / format.fps);
+	format.CalculateDimensions();
+	return format;
+}
+
+namespace preview_detail
+{
+	// adds (or, for the first line of a box, stores) 8-bit samples of the line into the column sums in acc
+	template <typename T>
+	void AddLine(const uint8_t* line, int samples, uint16_t* acc, bool first)
+	{
+		const auto* src = reinterpret_cast<const T*>(line);
+		int x = 0;
+		for (; x + 8 <= samples; x += 8)
+		{
+			__m128i v;
+			if constexpr (sizeof(T) == 1)
+			{
+				v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x)), _mm_setzero_si128());
+			}
+			else
+			{
+				// 10-bit codes are held in the most significant bits
+				v = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)), 8);
+			}
+			auto* a = reinterpret_cast<__m128i*>(acc + x);
+			_mm_storeu_si128(a, first ? v : _mm_add_epi16(_mm_loadu_si128(a), v));
+		}
+		for (; x < samples; ++x)
+		{
+			const auto v = static_cast<uint16_t>(sizeof(T) == 1 ? src[x] : src[x] >> 8);
+			acc[x] = first ? v : static_cast<uint16_t>(acc[x] + v);
+		}
+	}
+
+	// 32-bit sums of each pair of neighbouring pixels of C interleaved channels held in 16-bit lanes
+	template <int C>
+	__m128i PairSums(__m128i v)
+	{
+		if constexpr (C == 2)
+		{
+			// U0 V0 U1 V1 to U0 U1 V0 V1
+			v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		}
+		return _mm_madd_epi16(v, _mm_set1_epi16(1));
+	}
+
+	/**
+	 * Sums each run of factor (4 or 8) pixels of the column sums in acc, for each of C interleaved channels, and
+	 * writes the sum >> shift of each. Sums never exceed 128 8-bit samples so fit a signed 16-bit lane throughout.
+	 */
+	template <int C>
+	void Reduce(const uint16_t* acc, int outSamples, int factor, int shift, uint8_t* out)
+	{
+		const __m128i round = _mm_set1_epi16(static_cast<short>(1 << (shift - 1)));
+		const __m128i count = _mm_cvtsi32_si128(shift);
+		int o = 0;
+		for (; o + 8 <= outSamples; o += 8)
+		{
+			// each pass halves the number of pixels until every lane holds the sum of a whole box
+			__m128i v[maxPreviewScale];
+			const auto* a = acc + static_cast<size_t>(o) * factor;
+			for (int i = 0; i < factor; ++i)
+			{
+				v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 8));
+			}
+			for (int n = factor; n > 1; n /= 2)
+			{
+				for (int i = 0; i < n / 2; ++i)
+				{
+					v[i] = _mm_packs_epi32(PairSums<C>(v[2 * i]), PairSums<C>(v[2 * i + 1]));
+				}
+			}
+			const __m128i mean = _mm_srl_epi16(_mm_add_epi16(v[0], round), count);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + o), _mm_packus_epi16(mean, mean));
+		}
+		for (; o < outSamples; ++o)
+		{
+			const int pixel = o / C;
+			const int channel = o % C;
+			uint32_t sum = 0;
+			for (int i = 0; i < factor; ++i)
+			{
+				sum += acc[(pixel * factor + i) * C + channel];
+			}
+			out[o] = static_cast<uint8_t>((sum + (1u << (shift - 1))) >> shift);
+		}
+	}
+}
+
+namespace preview_detail
+{
+	// 8-bit limited range YCbCr
+	struct yuv8
+	{
+		uint8_t y;
+		uint8_t u;
+		uint8_t v;
+	};
+
+	// 8-bit RGB to limited range BT.709, the preview is only for monitoring so the signalled matrix is not honoured
+	inline yuv8 FromRgb(int r, int g, int b)
+	{
+		return {
+			static_cast<uint8_t>(16 + ((47 * r + 157 * g + 16 * b + 128) >> 8)),
+			static_cast<uint8_t>(128 + ((-26 * r - 87 * g + 112 * b + 128) >> 8)),
+			static_cast<uint8_t>(128 + ((112 * r - 102 * g - 10 * b + 128) >> 8))
+		};
+	}
+
+	inline uint16_t Load16(const uint8_t* p, int i)
+	{
+		uint16_t v;
+		memcpy(&v, p + static_cast<size_t>(i) * 2, sizeof(v));
+		return v;
+	}
+
+	inline uint32_t Load32(const uint8_t* p, int i)
+	{
+		uint32_t v;
+		memcpy(&v, p + static_cast<size_t>(i) * 4, sizeof(v));
+		return v;
+	}
+
+	// writes read(x, y) of the pixel at the centre of each box into the NV12 preview, chroma from every other pixel
+	template <typename Read>
+	void PointSample(Read&& read, preview_frame& out)
+	{
+		const auto w = out.videoFormat.cx;
+		const auto h = out.videoFormat.cy;
+		const auto half = out.scale / 2;
+		uint8_t* outY = out.data.data();
+		uint8_t* outUV = outY + static_cast<size_t>(w) * h;
+		for (int oy = 0; oy < h; ++oy)
+		{
+			const int sy = oy * out.scale + half;
+			uint8_t* yLine = outY + static_cast<size_t>(oy) * w;
+			uint8_t* uvLine = outUV + static_cast<size_t>(oy / 2) * w;
+			for (int ox = 0; ox < w; ++ox)
+			{
+				const auto p = read(ox * out.scale + half, sy);
+				yLine[ox] = p.y;
+				if (((ox | oy) & 1) == 0)
+				{
+					uvLine[ox] = p.u;
+					uvLine[ox + 1] = p.v;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Point samples a frame in any output format into the NV12 preview, pixelsToPad is the padding the renderer asked
+	 * for. Returns false if the format is unknown.
+	 */
+	inline bool SampleFrame(const uint8_t* frame, const video_format& format, int pixelsToPad, preview_frame& out)
+	{
+		DWORD stride;
+		DWORD imageBytes;
+		format.pixelFormat.GetImageDimensions(format.cx + pixelsToPad, format.cy, &stride, &imageBytes);
+		if (format.pixelFormat == Y210)
+		{
+			// sized as if it were planar, each line actually holds 4 bytes per pixel
+			stride *= 2;
+		}
+		// RGB with a positive height is stored bottom up
+		const auto flip = format.pixelFormat.rgb && !format.bottomUpDib;
+		const auto line = [&](int y)
+		{
+			return frame + static_cast<size_t>(flip ? format.cy - 1 - y : y) * stride;
+		};
+		const uint8_t* chroma = frame + static_cast<size_t>(stride) * format.cy;
+
+		switch (format.pixelFormat.format)
+		{
+		case pixel_format::NV12:
+		case pixel_format::NV16:
+			{
+				const auto vShift = format.pixelFormat.format == pixel_format::NV12 ? 1 : 0;
+				PointSample([&](int x, int y)
+				{
+					const auto* uv = chroma + static_cast<size_t>(y >> vShift) * stride + (x & ~1);
+					return yuv8{line(y)[x], uv[0], uv[1]};
+				}, out);
+				return true;
+			}
+		case pixel_format::P010:
+		case pixel_format::P210:
+			{
+				const auto vShift = format.pixelFormat.format == pixel_format::P010 ? 1 : 0;
+				PointSample([&](int x, int y)
+				{
+					const auto* uv = chroma + static_cast<size_t>(y >> vShift) * stride;
+					return yuv8{
+						static_cast<uint8_t>(Load16(line(y), x) >> 8),
+						static_cast<uint8_t>(Load16(uv, x & ~1) >> 8),
+						static_cast<uint8_t>(Load16(uv, x | 1) >> 8)
+					};
+				}, out);
+				return true;
+			}
+		case pixel_format::YV16:
+			{
+				// Y then V then U
+				const auto chromaStride = stride / 2;
+				const uint8_t* v = chroma;
+				const uint8_t* u = v + static_cast<size_t>(chromaStride) * format.cy;
+				PointSample([&](int x, int y)
+				{
+					const auto offset = static_cast<size_t>(y) * chromaStride + x / 2;
+					return yuv8{line(y)[x], u[offset], v[offset]};
+				}, out);
+				return true;
+			}
+		case pixel_format::YUY2:
+			PointSample([&](int x, int y)
+			{
+				const auto* l = line(y);
+				return yuv8{l[x * 2], l[(x & ~1) * 2 + 1], l[(x & ~1) * 2 + 3]};
+			}, out);
+			return true;
+		case pixel_format::UYVY:
+		case pixel_format::YUV2:
+			PointSample([&](int x, int y)
+			{
+				const auto* l = line(y);
+				return yuv8{l[x * 2 + 1], l[(x & ~1) * 2], l[(x & ~1) * 2 + 2]};
+			}, out);
+			return true;
+		case pixel_format::Y210:
+			PointSample([&](int x, int y)
+			{
+				const auto* l = line(y);
+				return yuv8{
+					static_cast<uint8_t>(Load16(l, x * 2) >> 8),
+					static_cast<uint8_t>(Load16(l, (x & ~1) * 2 + 1) >> 8),
+					static_cast<uint8_t>(Load16(l, (x & ~1) * 2 + 3) >> 8)
+				};
+			}, out);
+			return true;
+		case pixel_format::V210:
+			PointSample([&](int x, int y)
+			{
+				// 6 pixels in 4 words holding Cb0 Y0 Cr0 Y1 Cb2 Y2 Cr2 Y3 Cb4 Y4 Cr4 Y5
+				const auto* group = line(y) + static_cast<size_t>(x / 6) * 16;
+				const auto sample = [group](int i)
+				{
+					return static_cast<uint8_t>((Load32(group, i / 3) >> (i % 3 * 10) & 0x3FF) >> 2);
+				};
+				const auto i = x % 6;
+				return yuv8{sample(2 * i + 1), sample(i / 2 * 4), sample(i / 2 * 4 + 2)};
+			}, out);
+			return true;
+		case pixel_format::AYUV:
+			PointSample([&](int x, int y)
+			{
+				// V U Y A
+				const auto* p = line(y) + static_cast<size_t>(x) * 4;
+				return yuv8{p[2], p[1], p[0]};
+			}, out);
+			return true;
+		case pixel_format::AY10:
+			PointSample([&](int x, int y)
+			{
+				// big endian words of 2 bits of padding, chroma (alternately Cb & Cr), Y & alpha
+				const auto* l = line(y);
+				return yuv8{
+					static_cast<uint8_t>((_byteswap_ulong(Load32(l, x)) >> 10 & 0x3FF) >> 2),
+					static_cast<uint8_t>((_byteswap_ulong(Load32(l, x & ~1)) >> 20 & 0x3FF) >> 2),
+					static_cast<uint8_t>((_byteswap_ulong(Load32(l, x | 1)) >> 20 & 0x3FF) >> 2)
+				};
+			}, out);
+			return true;
+		case pixel_format::BGR24:
+			PointSample([&](int x, int y)
+			{
+				const auto* p = line(y) + static_cast<size_t>(x) * 3;
+				return FromRgb(p[2], p[1], p[0]);
+			}, out);
+			return true;
+		case pixel_format::ARGB:
+		case pixel_format::BGRA:
+		case pixel_format::RGBA:
+			{
+				// bytes are in the order of the name
+				const auto& name = format.pixelFormat.name;
+				const auto r = name.find('R');
+				const auto g = name.find('G');
+				const auto b = name.find('B');
+				PointSample([&](int x, int y)
+				{
+					const auto* p = line(y) + static_cast<size_t>(x) * 4;
+					return FromRgb(p[r], p[g], p[b]);
+				}, out);
+				return true;
+			}
+		case pixel_format::RGB48:
+			PointSample([&](int x, int y)
+			{
+				const auto* l = line(y);
+				return FromRgb(Load16(l, x * 3) >> 8, Load16(l, x * 3 + 1) >> 8, Load16(l, x * 3 + 2) >> 8);
+			}, out);
+			return true;
+		case pixel_format::BGR10:
+			PointSample([&](int x, int y)
+			{
+				const auto p = Load32(line(y), x);
+				return FromRgb((p & 0x3FF) >> 2, (p >> 10 & 0x3FF) >> 2, (p >> 20 & 0x3FF) >> 2);
+			}, out);
+			return true;
+		case pixel_format::R210:
+			PointSample([&](int x, int y)
+			{
+				const auto p = _byteswap_ulong(Load32(line(y), x));
+				return FromRgb((p >> 20 & 0x3FF) >> 2, (p >> 10 & 0x3FF) >> 2, (p & 0x3FF) >> 2);
+			}, out);
+			return true;
+		case pixel_format::R10B:
+		case pixel_format::R10L:
+			{
+				const auto bigEndian = format.pixelFormat.format == pixel_format::R10B;
+				PointSample([&](int x, int y)
+				{
+					const auto w = Load32(line(y), x);
+					const auto p = bigEndian ? _byteswap_ulong(w) : w;
+					return FromRgb((p >> 22 & 0x3FF) >> 2, (p >> 12 & 0x3FF) >> 2, (p >> 2 & 0x3FF) >> 2);
+				}, out);
+				return true;
+			}
+		case pixel_format::R12B:
+		case pixel_format::R12L:
+			{
+				// 8 pixels of 12-bit samples packed into 36 bytes, the big endian form reverses each 4 byte word
+				const auto bigEndian = format.pixelFormat.format == pixel_format::R12B;
+				PointSample([&](int x, int y)
+				{
+					const auto* group = line(y) + static_cast<size_t>(x / 8) * 36;
+					const auto byte = [&](int b)
+					{
+						return group[bigEndian ? (b & ~3) | (3 - (b & 3)) : b];
+					};
+					int rgb[3];
+					for (int c = 0; c < 3; ++c)
+					{
+						const int sample = x % 8 * 3 + c;
+						const int b = sample / 2 * 3;
+						const int value = sample & 1
+							                  ? byte(b + 1) >> 4 | byte(b + 2) << 4
+							                  : byte(b) | (byte(b + 1) & 0xF) << 8;
+						rgb[c] = value >> 4;
+					}
+					return FromRgb(rgb[0], rgb[1], rgb[2]);
+				}, out);
+				return true;
+			}
+		default: // NOLINT(clang-diagnostic-covered-switch-default)
+			return false;
+		}
+	}
+
+	// converts the NV12 preview to top down RGB32 (B G R A) using limited range BT.709
+	inline void ToRgb32(const preview_frame& frame, uint8_t* out)
+	{
+		const auto w = frame.videoFormat.cx;
+		const auto h = frame.videoFormat.cy;
+		const uint8_t* inY = frame.data.data();
+		const uint8_t* inUV = inY + static_cast<size_t>(w) * h;
+		const auto clamp = [](int v)
+		{
+			return static_cast<uint8_t>(std::clamp(v >> 8, 0, 255));
+		};
+		for (int y = 0; y < h; ++y)
+		{
+			const uint8_t* yLine = inY + static_cast<size_t>(y) * w;
+			const uint8_t* uvLine = inUV + static_cast<size_t>(y / 2) * w;
+			uint8_t* o = out + static_cast<size_t>(y) * w * 4;
+			for (int x = 0; x < w; ++x)
+			{
+				const int c = 298 * (yLine[x] - 16) + 128;
+				const int d = uvLine[x & ~1] - 128;
+				const int e = uvLine[x | 1] - 128;
+				o[0] = clamp(c + 541 * d);
+				o[1] = clamp(c - 55 * d - 136 * e);
+				o[2] = clamp(c + 459 * e);
+				o[3] = 0xFF;
+				o += 4;
+			}
+		}
+	}
+}
+
+/**
+ * Box filters the lines converted by one stripe into the preview as they are written, i.e. while they are still in
+ * cache. Lines must be added in order and the stripe must start on a multiple of previewGroupLines.
+ */
+class preview_lines
+{
+public:
+	// a null frame adds nothing
+	explicit preview_lines(preview_frame* pFrame) : mFrame(pFrame)
+	{
+		if (!mFrame)
+		{
+			return;
+		}
+		const auto& source = mFrame->source;
+		const auto scale = mFrame->scale;
+		const auto outWidth = mFrame->videoFormat.cx;
+		mChromaGroup = 2 * scale >> source.chromaVShift;
+		mLumaShift = 2 * std::countr_zero(static_cast<unsigned>(scale));
+		mChromaShift = std::countr_zero(static_cast<unsigned>(mChromaGroup * scale));
+
+		thread_local std::vector<uint16_t> sums;
+		thread_local std::vector<uint8_t> rows;
+		const auto lumaSamples = static_cast<size_t>(outWidth) * scale;
+		sums.resize(lumaSamples * 2);
+		rows.resize(outWidth);
+		mLuma = sums.data();
+		mU = mLuma + lumaSamples;
+		mV = mU + lumaSamples / 2;
+		mRowU = rows.data();
+		mRowV = mRowU + outWidth / 2;
+	}
+
+	/**
+	 * Adds lines [firstLine, firstLine + lineCount) of the frame, lines holds the address of the first of these in each
+	 * plane & strides the bytes per line of each plane.
+	 */
+	void Add(const uint8_t* const* lines, const int* strides, int firstLine, int lineCount)
+	{
+		if (!mFrame || lineCount <= 0)
+		{
+			return;
+		}
+		const auto& source = mFrame->source;
+		const auto scale = mFrame->scale;
+		const auto outWidth = mFrame->videoFormat.cx;
+		const auto outHeight = mFrame->videoFormat.cy;
+		uint8_t* outY = mFrame->data.data();
+		uint8_t* outUV = outY + static_cast<size_t>(outWidth) * outHeight;
+		const auto addLine = source.bytesPerSample == 1
+			                     ? preview_detail::AddLine<uint8_t>
+			                     : preview_detail::AddLine<uint16_t>;
+
+		// lines beyond the last whole box are not part of the preview
+		const auto lastLine = std::min(firstLine + lineCount, outHeight * scale);
+		for (int y = firstLine; y < lastLine; ++y)
+		{
+			addLine(lines[0] + static_cast<size_t>(y - firstLine) * strides[0], outWidth * scale, mLuma,
+			        y % scale == 0);
+			if (y % scale == scale - 1)
+			{
+				preview_detail::Reduce<1>(mLuma, outWidth, scale, mLumaShift,
+				                          outY + static_cast<size_t>(y / scale) * outWidth);
+			}
+		}
+
+		const auto vShift = source.chromaVShift;
+		const auto firstChroma = firstLine >> vShift;
+		const auto lastChroma = std::min(((firstLine + lineCount - 1) >> vShift) + 1, outHeight / 2 * mChromaGroup);
+		for (int c = firstChroma; c < lastChroma; ++c)
+		{
+			const auto first = c % mChromaGroup == 0;
+			const auto offset = static_cast<size_t>(c - firstChroma);
+			if (source.planes == 2)
+			{
+				addLine(lines[1] + offset * strides[1], outWidth * scale, mU, first);
+			}
+			else
+			{
+				addLine(lines[1] + offset * strides[1], outWidth * scale / 2, mU, first);
+				addLine(lines[2] + offset * strides[2], outWidth * scale / 2, mV, first);
+			}
+			if (c % mChromaGroup != mChromaGroup - 1)
+			{
+				continue;
+			}
+			uint8_t* uv = outUV + static_cast<size_t>(c / mChromaGroup) * outWidth;
+			if (source.planes == 2)
+			{
+				preview_detail::Reduce<2>(mU, outWidth, scale, mChromaShift, uv);
+			}
+			else
+			{
+				preview_detail::Reduce<1>(mU, outWidth / 2, scale, mChromaShift, mRowU);
+				preview_detail::Reduce<1>(mV, outWidth / 2, scale, mChromaShift, mRowV);
+				for (int x = 0; x < outWidth / 2; ++x)
+				{
+					uv[2 * x] = mRowU[x];
+					uv[2 * x + 1] = mRowV[x];
+				}
+			}
+		}
+	}
+
+private:
+	preview_frame* mFrame;
+	// chroma lines box filtered into each line of preview chroma
+	int mChromaGroup{0};
+	int mLumaShift{0};
+	int mChromaShift{0};
+	// column sums of the lines of the box being filtered
+	uint16_t* mLuma{nullptr};
+	uint16_t* mU{nullptr};
+	uint16_t* mV{nullptr};
+	uint8_t* mRowU{nullptr};
+	uint8_t* mRowV{nullptr};
+};
+
+/**
+ * Hands previews from the writers to the preview pin through 3 frames, one being written, one ready & one being
+ * delivered. The writer only ever takes a free frame and a ready frame not yet taken by the pin is replaced by the next
+ * one so a slow preview pin drops frames rather than holding up the capture pin.
+ */
+class preview_sink
+{
+public:
+	explicit preview_sink(int pScale) : mScale(std::clamp(std::bit_floor(static_cast<unsigned>(pScale)),
+	                                                      static_cast<unsigned>(minPreviewScale),
+	                                                      static_cast<unsigned>(maxPreviewScale)))
+	{
+	}
+
+	int GetScale() const
+	{
+		return mScale;
+	}
+
+	// frames are only previewed while the preview pin is running
+	void SetActive(bool pActive)
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mActive = pActive;
+			mReady = -1;
+		}
+		mFrameReady.notify_all();
+	}
+
+	// the format of the frames being captured
+	void SetVideoFormat(const video_format& pVideoFormat)
+	{
+		std::lock_guard lock(mMutex);
+		mVideoFormat = pVideoFormat;
+	}
+
+	// the format of the preview of the frames being captured
+	video_format GetVideoFormat()
+	{
+		std::lock_guard lock(mMutex);
+		return ScaledVideoFormat(mVideoFormat, mScale);
+	}
+
+	uint64_t GetDroppedCount()
+	{
+		std::lock_guard lock(mMutex);
+		return mDropped;
+	}
+
+	/**
+	 * Called by a writer as it starts converting a frame, returns the frame to write the preview into if the preview
+	 * pin is due one or null if not.
+	 */
+	preview_frame* Begin(const preview_source& source)
+	{
+		std::lock_guard lock(mMutex);
+		const auto now = std::chrono::steady_clock::now();
+		if (!mActive || mWriting >= 0 || now < mNextFrameAt)
+		{
+			return nullptr;
+		}
+		auto format = mVideoFormat;
+		format.cx = source.width;
+		format.cy = source.height;
+		format = ScaledVideoFormat(format, mScale);
+		if (format.cx < 2 || format.cy < 2)
+		{
+			return nullptr;
+		}
+		// a little early so jitter in the arrival of frames never skips one more than necessary
+		mNextFrameAt = now + std::chrono::microseconds(900000 / previewFramesPerSecond);
+		for (int i = 0; i < static_cast<int>(mFrames.size()); ++i)
+		{
+			if (i != mReady && i != mReading)
+			{
+				mWriting = i;
+				break;
+			}
+		}
+		auto& frame = mFrames[mWriting];
+		frame.videoFormat = format;
+		frame.source = source;
+		frame.scale = mScale;
+		frame.data.resize(format.imageSize);
+		return &frame;
+	}
+
+	// called by the writer once the frame passed by Begin is complete
+	void End(const preview_frame* frame)
+	{
+		{
+			std::lock_guard lock(mMutex);
+			if (mWriting < 0 || &mFrames[mWriting] != frame)
+			{
+				return;
+			}
+			if (mReady >= 0)
+			{
+				++mDropped;
+			}
+			mReady = mActive ? mWriting : -1;
+			mWriting = -1;
+		}
+		mFrameReady.notify_one();
+	}
+
+	/**
+	 * Point samples a frame which has already been written in the given format if the preview pin is still due one,
+	 * i.e. the writer did not box filter it as it was converted. Only 1 in scale lines of the frame are read.
+	 */
+	void Sample(const uint8_t* frame, const video_format& format, int pixelsToPad)
+	{
+		auto* preview = Begin({.width = format.cx, .height = format.cy});
+		if (!preview)
+		{
+			return;
+		}
+		if (preview_detail::SampleFrame(frame, format, pixelsToPad, *preview))
+		{
+			if (format.pixelFormat.subsampling == RGB_444)
+			{
+				// converted by FromRgb
+				preview->videoFormat.colourFormat = REC709;
+				preview->videoFormat.colourFormatName = "REC709";
+				preview->videoFormat.quantisation = QUANTISATION_LIMITED;
+			}
+			End(preview);
+		}
+		else
+		{
+			std::lock_guard lock(mMutex);
+			mWriting = -1;
+		}
+	}
+
+	// waits up to timeout for a frame, which the preview pin owns until it calls Release
+	const preview_frame* Acquire(std::chrono::milliseconds timeout)
+	{
+		std::unique_lock lock(mMutex);
+		if (!mFrameReady.wait_for(lock, timeout, [this] { return mReady >= 0; }))
+		{
+			return nullptr;
+		}
+		mReading = mReady;
+		mReady = -1;
+		return &mFrames[mReading];
+	}
+
+	void Release()
+	{
+		std::lock_guard lock(mMutex);
+		mReading = -1;
+	}
+
+private:
+	const int mScale;
+	std::mutex mMutex;
+	std::condition_variable mFrameReady;
+	std::array<preview_frame, 3> mFrames{};
+	int mWriting{-1};
+	int mReady{-1};
+	int mReading{-1};
+	bool mActive{false};
+	video_format mVideoFormat{};
+	std::chrono::steady_clock::time_point mNextFrameAt{};
+	uint64_t mDropped{0};
+};
+#endif
@@ -0,0 +1,177 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "preview_video_pin.h"
+
+// long enough to idle between previews, short enough that the pin still responds promptly to a stop
+static constexpr auto previewWait = std::chrono::milliseconds(1000 / previewFramesPerSecond);
+
+// the preview in the given output format, RGB32 is delivered top down
+static video_format PreviewFormat(video_format format, const pixel_format& pixelFormat)
+{
+	format.pixelFormat = pixelFormat;
+	format.bottomUpDib = true;
+	format.CalculateDimensions();
+	return format;
+}
+
+preview_video_pin::preview_video_pin(HRESULT* phr, capture_filter* pParent, int pScale, device_type pType) :
+	video_capture_pin(phr, pParent, "VideoScaledPreview", L"Scaled Preview", "VideoScaledPreview", video_format{}, {},
+	                  pType),
+	mFilter(pParent),
+	mSink(pScale)
+{
+	mPreview = true;
+	mVideoFormat = ScaledVideoFormat(mVideoFormat, mSink.GetScale());
+
+	#ifndef NO_QUILL
+	LOG_INFO(mLogData.logger, "[{}] Previewing the capture pin at 1/{} scale", mLogData.prefix, mSink.GetScale());
+	#endif
+}
+
+HRESULT preview_video_pin::GetMediaType(int iPosition, CMediaType* pMediaType)
+{
+	CAutoLock lock(m_pFilter->pStateLock());
+	if (iPosition < 0)
+	{
+		return E_INVALIDARG;
+	}
+	if (iPosition > 1)
+	{
+		return VFW_S_NO_MORE_ITEMS;
+	}
+	// follows the capture pin until connected, any change after that is renegotiated when the next preview arrives
+	if (!IsConnected())
+	{
+		mVideoFormat = PreviewFormat(mSink.GetVideoFormat(), mVideoFormat.pixelFormat);
+	}
+	// the current format first then the other one
+	if (iPosition == 0)
+	{
+		VideoFormatToMediaType(pMediaType, &mVideoFormat);
+	}
+	else
+	{
+		auto other = PreviewFormat(mVideoFormat, mVideoFormat.pixelFormat == BGRA ? NV12 : BGRA);
+		VideoFormatToMediaType(pMediaType, &other);
+	}
+	return S_OK;
+}
+
+HRESULT preview_video_pin::SetMediaType(const CMediaType* pmt)
+{
+	const auto hr = video_capture_pin::SetMediaType(pmt);
+	if (SUCCEEDED(hr))
+	{
+		mVideoFormat = PreviewFormat(mVideoFormat, *pmt->Subtype() == MEDIASUBTYPE_RGB32 ? BGRA : NV12);
+	}
+	return hr;
+}
+
+bool preview_video_pin::ProposeBuffers(ALLOCATOR_PROPERTIES* pProperties)
+{
+	pProperties->cbBuffer = mVideoFormat.imageSize;
+	if (pProperties->cBuffers < 1)
+	{
+		// previews are delivered at a low rate & never queue up
+		pProperties->cBuffers = 2;
+		return false;
+	}
+	return true;
+}
+
+HRESULT preview_video_pin::OnThreadStartPlay()
+{
+	mSink.SetActive(true);
+	return video_capture_pin::OnThreadStartPlay();
+}
+
+void preview_video_pin::DoThreadDestroy()
+{
+	mSink.SetActive(false);
+
+	#ifndef NO_QUILL
+	LOG_INFO(mLogData.logger, "[{}] preview_video_pin::DoThreadDestroy ({} previews delivered, {} dropped)",
+	         mLogData.prefix, mFrameCounter, mSink.GetDroppedCount());
+	#endif
+}
+
+HRESULT preview_video_pin::FillBuffer(IMediaSample* pms)
+{
+	const auto* frame = mSink.Acquire(previewWait);
+	if (!frame)
+	{
+		// nothing new, the sample goes back to the allocator while the processing loop checks for commands
+		return S_REPEATED_FRAME;
+	}
+
+	// previews are always NV12, RGB32 is converted as it is delivered
+	auto newVideoFormat = PreviewFormat(frame->videoFormat, mVideoFormat.pixelFormat);
+	if (ShouldChangeMediaType(&newVideoFormat))
+	{
+		CMediaType proposedMediaType(m_mt);
+		VideoFormatToMediaType(&proposedMediaType, &newVideoFormat);
+		const auto hr = DoChangeMediaType(&proposedMediaType, &newVideoFormat);
+		if (FAILED(hr))
+		{
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger, "[{}] Unable to change preview to {}x{}, dropping preview [{:#08x}]",
+			            mLogData.prefix, newVideoFormat.cx, newVideoFormat.cy, static_cast<unsigned long>(hr));
+			#endif
+
+			mSink.Release();
+			return S_REPEATED_FRAME;
+		}
+	}
+
+	const auto size = static_cast<long>(newVideoFormat.imageSize);
+	if (pms->GetSize() < size)
+	{
+		// allocated before the media type changed, the next sample will be large enough
+		mSink.Release();
+		return S_REPEATED_FRAME;
+	}
+
+	BYTE* out;
+	pms->GetPointer(&out);
+	if (newVideoFormat.pixelFormat == BGRA)
+	{
+		preview_detail::ToRgb32(*frame, out);
+	}
+	else
+	{
+		memcpy(out, frame->data.data(), size);
+	}
+	pms->SetActualDataLength(size);
+	mSink.Release();
+
+	pms->SetTime(nullptr, nullptr);
+	pms->SetSyncPoint(TRUE);
+	if (mUpdatedMediaType)
+	{
+		CMediaType cmt(m_mt);
+		AM_MEDIA_TYPE* sendMediaType = CreateMediaType(&cmt);
+		pms->SetMediaType(sendMediaType);
+		DeleteMediaType(sendMediaType);
+		mUpdatedMediaType = false;
+	}
+	++mFrameCounter;
+
+	#ifndef NO_QUILL
+	LOG_TRACE_L2(mLogData.logger, "[{}] Delivering preview {} at {}x{}", mLogData.prefix, mFrameCounter,
+	             newVideoFormat.cx, newVideoFormat.cy);
+	#endif
+
+	return S_FALSE == HandleStreamStateChange(pms) ? S_FALSE : S_OK;
+}
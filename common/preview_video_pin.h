@@ -0,0 +1,82 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PREVIEW_VIDEO_PIN_HEADER
+#define PREVIEW_VIDEO_PIN_HEADER
+
+#define NOMINMAX // quill does not compile without this
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include "capture_filter.h"
+#include "video_capture_pin.h"
+#include "preview.h"
+
+/**
+ * A low rate NV12 or RGB32 preview of the capture pin scaled down to 1/4 or 1/8 size, e.g. for a monitoring UI.
+ * Previews are box filtered by the capture pin's writer as it converts a frame, or point sampled from the delivered
+ * sample when the writer does not produce one, and handed over via the sink as NV12. They are delivered without
+ * timestamps so are shown as soon as they arrive. The capture pin never waits for this pin, any preview this pin is not
+ * ready to deliver is dropped.
+ */
+class preview_video_pin final : public video_capture_pin
+{
+public:
+	preview_video_pin(HRESULT* phr, capture_filter* pParent, int pScale, device_type pType);
+
+	// the capture pin writes previews into this
+	preview_sink* GetSink()
+	{
+		return &mSink;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//  CSourceStream
+	//////////////////////////////////////////////////////////////////////////
+	HRESULT FillBuffer(IMediaSample* pms) override;
+	HRESULT OnThreadStartPlay() override;
+
+	void GetReferenceTime(REFERENCE_TIME* rt) const override
+	{
+		mFilter->GetReferenceTime(rt);
+	}
+
+	HRESULT SetMediaType(const CMediaType* pmt) override;
+
+protected:
+	HRESULT GetMediaType(int iPosition, __inout CMediaType* pMediaType) override;
+	bool ProposeBuffers(ALLOCATOR_PROPERTIES* pProperties) override;
+	void DoThreadDestroy() override;
+
+	// the preview follows whatever mode the capture pin is in so never switches the display itself
+	void OnChangeMediaType() override
+	{
+	}
+
+	void UpdateDisplayStatus() override
+	{
+	}
+
+	void DoSwitchMode() override
+	{
+	}
+
+private:
+	capture_filter* mFilter;
+	preview_sink mSink;
+};
+
+#endif
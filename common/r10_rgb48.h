@@ -0,0 +1,142 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef R10_RGB48_HEADER
+#define R10_RGB48_HEADER
+
+#include "VideoFrameWriter.h"
+#include "packed_rgb10.h"
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * R10b & R10l are 10-bit RGB packed into a 32bit word as R, G, B followed by 2 bits of padding, R10b is big endian and
+ * R10l little endian.
+ */
+template <typename VF, bool BigEndian>
+class r10_rgb48 : public IVideoFrameWriter<VF>
+{
+public:
+	r10_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel(BigEndian ? "R10b to RGB48" : "R10l to RGB48");
+	}
+
+	~r10_rgb48() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+
+		// Each row starts on 256-byte boundary
+		const int srcStride = (width * 4 + 255) / 256 * 256;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const int dstStride = (width + this->mPixelsToPad) * 3;
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvert(srcLines, srcStride,
+			         reinterpret_cast<uint16_t*>(outData) + firstLine * dstStride, width, lineCount, this->mPixelsToPad);
+		});
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to RGB48 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad);
+
+	static void convert_line_scalar(const uint32_t* srcLine, uint16_t* dstPix, int x, int width)
+	{
+		for (; x < width; ++x)
+		{
+			const uint32_t srcPixel = BigEndian ? _byteswap_ulong(srcLine[x]) : srcLine[x];
+
+			dstPix[0] = static_cast<uint16_t>(srcPixel >> 16 & 0xFFC0); // R
+			dstPix[1] = static_cast<uint16_t>(srcPixel >> 6 & 0xFFC0); // G
+			dstPix[2] = static_cast<uint16_t>(srcPixel << 4 & 0xFFC0); // B
+			dstPix += 3;
+		}
+	}
+
+	static constexpr packed_rgb10::avx2_tables avx2Tables = packed_rgb10::make_avx2_tables(
+		BigEndian ? packed_rgb10::r10b : packed_rgb10::r10l);
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLine = dst + y * dstStride;
+			const int simdWidth = packed_rgb10::convert_line_avx2(avx2Tables, srcLine, dstLine, width);
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			convert_line_scalar(srcLine, dst + y * dstStride, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+
+template <typename VF>
+using r10b_rgb48 = r10_rgb48<VF, true>;
+
+template <typename VF>
+using r10l_rgb48 = r10_rgb48<VF, false>;
+#endif
@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef R12_RGB48_HEADER
+#define R12_RGB48_HEADER
+
+#include "VideoFrameWriter.h"
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * R12B & R12L pack 8 pixels of 12-bit R, G, B into 9 32bit words (36 bytes) as a continuous stream of 12-bit samples
+ * starting from the least significant bit of the first word. R12L stores each word little endian, R12B big endian.
+ *
+ * Once the words are in little endian order, each pair of samples is 3 bytes so sample 2n is the low 12 bits of bytes
+ * (3n, 3n+1) and sample 2n+1 is the high 12 bits of bytes (3n+1, 3n+2).
+ */
+template <typename VF, bool BigEndian>
+class r12_rgb48 : public IVideoFrameWriter<VF>
+{
+public:
+	r12_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel(BigEndian ? "R12B to RGB48" : "R12L to RGB48");
+	}
+
+	~r12_rgb48() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+
+		// row alignment is not documented for the 12-bit formats so derive it from the frame
+		const int srcStride = static_cast<int>(srcFrame->GetLength() / height);
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const int dstStride = (width + this->mPixelsToPad) * 3;
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvert(srcLines, srcStride,
+			         reinterpret_cast<uint16_t*>(outData) + firstLine * dstStride, width, lineCount, this->mPixelsToPad);
+		});
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to RGB48 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad);
+
+	// memory offset of byte b of the (little endian) sample stream
+	static constexpr int stream_offset(int b)
+	{
+		return BigEndian ? (b & ~3) | (3 - (b & 3)) : b;
+	}
+
+	static void convert_line_scalar(const uint8_t* srcLine, uint16_t* dstPix, int x, int width)
+	{
+		for (; x < width; ++x)
+		{
+			const uint8_t* group = srcLine + x / 8 * 36;
+			for (int c = 0; c < 3; ++c)
+			{
+				const int sample = x % 8 * 3 + c;
+				const int b = sample / 2 * 3;
+				uint16_t value;
+				if (sample & 1)
+				{
+					value = static_cast<uint16_t>(group[stream_offset(b + 1)] >> 4 | group[stream_offset(b + 2)] << 4);
+				}
+				else
+				{
+					value = static_cast<uint16_t>(group[stream_offset(b)] | (group[stream_offset(b + 1)] & 0xF) << 8);
+				}
+				dstPix[c] = static_cast<uint16_t>(value << 4);
+			}
+			dstPix += 3;
+		}
+	}
+
+	/*
+	 * 16 pixels (72 bytes) per pass produce 48 words = 3 whole ymm, each output lane holds 8 samples which come from
+	 * 12 consecutive bytes. vpermd moves the 3 words holding those bytes into the lane, vpshufb picks the 2 bytes for
+	 * each sample (undoing the byte order for R12B) and vpmullw shifts the even samples up by 4 before masking.
+	 */
+	struct avx2_tables
+	{
+		alignas(32) int8_t shuffle[32];
+		alignas(32) int16_t multiplier[16];
+	};
+
+	static constexpr avx2_tables make_avx2_tables()
+	{
+		avx2_tables t{};
+		for (int half = 0; half < 2; ++half)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				const int lo = i / 2 * 3 + (i & 1);
+				t.shuffle[half * 16 + i * 2] = static_cast<int8_t>(stream_offset(lo));
+				t.shuffle[half * 16 + i * 2 + 1] = static_cast<int8_t>(stream_offset(lo + 1));
+				t.multiplier[half * 8 + i] = static_cast<int16_t>(i & 1 ? 1 : 16);
+			}
+		}
+		return t;
+	}
+
+	static constexpr avx2_tables avx2Tables = make_avx2_tables();
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+		const __m256i perm = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+		// only 24 bytes of each 32 byte load are needed, masking the rest avoids reading beyond the end of the line
+		const __m256i loadMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+		const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFFF0));
+		const __m256i shuffle = _mm256_load_si256(reinterpret_cast<const __m256i*>(avx2Tables.shuffle));
+		const __m256i multiplier = _mm256_load_si256(reinterpret_cast<const __m256i*>(avx2Tables.multiplier));
+		const int simdWidth = width & ~15;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* srcLine = src + y * srcStride;
+			uint16_t* dstLine = dst + y * dstStride;
+			for (int x = 0; x < simdWidth; x += 16)
+			{
+				const uint8_t* in = srcLine + x / 8 * 36;
+				__m256i* out = reinterpret_cast<__m256i*>(dstLine + x * 3);
+				for (int k = 0; k < 3; ++k)
+				{
+					const __m256i px = _mm256_maskload_epi32(reinterpret_cast<const int*>(in + k * 24), loadMask);
+					const __m256i words = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(px, perm), shuffle);
+					_mm256_storeu_si256(out + k, _mm256_and_si256(_mm256_mullo_epi16(words, multiplier), mask));
+				}
+			}
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			convert_line_scalar(src + y * srcStride, dst + y * dstStride, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+
+template <typename VF>
+using r12b_rgb48 = r12_rgb48<VF, true>;
+
+template <typename VF>
+using r12l_rgb48 = r12_rgb48<VF, false>;
+#endif
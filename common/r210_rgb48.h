@@ -16,6 +16,8 @@
 #define R210_RGB48_HEADER
 
 #include "VideoFrameWriter.h"
+#include "packed_rgb10.h"
+#include <algorithm>
 #include <span>
 
 #ifndef NO_QUILL
@@ -30,8 +32,26 @@ template <typename VF>
 class r210_rgb48 : public IVideoFrameWriter<VF>
 {
 public:
-	r210_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY) : IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
+	r210_rgb48(const log_data& pLogData, uint32_t pX, uint32_t pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &RGB48)
 	{
+		const auto& cpu = GetCpuFeatures();
+		if (pMaxIsa >= ISA_AVX512 && cpu.Supports(ISA_AVX512))
+		{
+			mConvert = convert_avx512;
+			this->mIsa = ISA_AVX512;
+		}
+		else if (pMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		else if (pMaxIsa >= ISA_SSSE3 && cpu.Supports(ISA_SSSE3))
+		{
+			mConvert = convert_ssse3;
+			this->mIsa = ISA_SSSE3;
+		}
+		this->LogKernel("r210 to RGB48");
 	}
 
 	~r210_rgb48() override = default;
@@ -76,11 +96,19 @@ public:
 		}
 		#endif
 
+		// Each row starts on 256-byte boundary
+		const int srcStride = (width * 4 + 255) / 256 * 256;
+
 		#ifndef NO_QUILL
 		const quill::StopWatchTsc swt;
 		#endif
 
-		this->convert(sourceData, reinterpret_cast<uint16_t*>(outData), width, height, this->mPixelsToPad);
+		const int dstStride = (width + this->mPixelsToPad) * 3;
+		this->ConvertStripes(sourceData, srcStride, height, [&](const uint8_t* srcLines, int firstLine, int lineCount)
+		{
+			mConvert(srcLines, srcStride,
+			         reinterpret_cast<uint16_t*>(outData) + firstLine * dstStride, width, lineCount, this->mPixelsToPad);
+		});
 
 		#ifndef NO_QUILL
 		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
@@ -97,81 +125,187 @@ private:
 	uint32_t mFrameCounter{0};
 	#endif
 
-	#ifdef __AVX2__
-	bool convert(const uint8_t* src, uint16_t* dst, size_t width, size_t height, int pixelsToPad)
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad);
+
+	// r210 is 10-bit RGB packed into a big-endian 32bit word as 2 bits of padding followed by R, G and B
+	static void convert_line_scalar(const uint32_t* srcLine, uint16_t* dstPix, int x, int width)
 	{
-		__m128i pixelEndianSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+		for (; x < width; ++x)
+		{
+			const uint32_t srcPixel = _byteswap_ulong(srcLine[x]);
 
-		// Each row starts on 256-byte boundary
-		size_t srcStride = (width * 4 + 255) / 256 * 256;
-		const uint8_t* srcRow = src;
-		uint16_t* dstPix = dst;
-		size_t blocks = width / 4;
-		const int dstPadding = pixelsToPad * 3;
+			dstPix[0] = static_cast<uint16_t>(srcPixel >> 14 & 0xFFC0); // R
+			dstPix[1] = static_cast<uint16_t>(srcPixel >> 4 & 0xFFC0); // G
+			dstPix[2] = static_cast<uint16_t>(srcPixel << 6 & 0xFFC0); // B
+			dstPix += 3;
+		}
+	}
 
-		for (size_t y = 0; y < height; ++y)
-		{
-			const uint32_t* srcPixelBE = reinterpret_cast<const uint32_t*>(srcRow);
+	// lookup tables for the AVX-512 kernel which converts 32 pixels (2 x 64 bytes of r210) per pass into 3 x 32 samples.
+	// vpermb copies the 2 bytes which contain each 10-bit component into the 16-bit output slot (which also swaps
+	// to little endian) then vpmultishiftqb shifts each component into the top 10 bits of the slot
+	struct avx512_tables
+	{
+		alignas(64) uint8_t perm[3][64];
+		alignas(64) uint8_t shift[3][64];
+	};
 
-			for (size_t x = 0; x < blocks; ++x)
+	static constexpr avx512_tables make_avx512_tables()
+	{
+		// index of the most significant byte (in memory order) holding each component & the offset of the component
+		// in the 16 bits read from there
+		constexpr int hiByte[3] = {0, 1, 2};
+		constexpr int bitOffset[3] = {4, 2, 0};
+		avx512_tables t{};
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int w = 0; w < 32; ++w)
 			{
-				// xmm is physically the lower lane of ymm so we can treat this as a ymm register going forward
-				__m128i pixelBlockBE = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPixelBE));
-				// swap to produce 10bit BGR
-				__m128i pixelBlockLE = _mm_shuffle_epi8(pixelBlockBE, pixelEndianSwap);
-				const uint32_t* p = reinterpret_cast<const uint32_t*>(&pixelBlockLE);
-
-				dstPix[0] = (p[0] & 0x3FF00000) >> 14;
-				dstPix[1] = (p[0] & 0xFFC00) >> 4;
-				dstPix[2] = (p[0] & 0x3FF) << 6;
-				dstPix[3] = (p[1] & 0x3FF00000) >> 14;
-				dstPix[4] = (p[1] & 0xFFC00) >> 4;
-				dstPix[5] = (p[1] & 0x3FF) << 6;
-				dstPix[6] = (p[2] & 0x3FF00000) >> 14;
-				dstPix[7] = (p[2] & 0xFFC00) >> 4;
-				dstPix[8] = (p[2] & 0x3FF) << 6;
-				dstPix[9] = (p[3] & 0x3FF00000) >> 14;
-				dstPix[10] = (p[3] & 0xFFC00) >> 4;
-				dstPix[11] = (p[3] & 0x3FF) << 6;
-				dstPix += 12;
-				srcPixelBE += 4;
+				const int sample = k * 32 + w;
+				const int pixelOffset = sample / 3 * 4;
+				const int component = sample % 3;
+				const int slot = w % 4 * 16;
+				t.perm[k][w * 2] = static_cast<uint8_t>(pixelOffset + hiByte[component] + 1);
+				t.perm[k][w * 2 + 1] = static_cast<uint8_t>(pixelOffset + hiByte[component]);
+				t.shift[k][w * 2] = static_cast<uint8_t>((slot + bitOffset[component] - 6) & 63);
+				t.shift[k][w * 2 + 1] = static_cast<uint8_t>((slot + bitOffset[component] + 2) & 63);
 			}
-			dstPix += dstPadding;
-			srcRow += srcStride;
+		}
+		return t;
+	}
+
+	static constexpr avx512_tables avx512Tables = make_avx512_tables();
+
+	static constexpr packed_rgb10::avx2_tables avx2Tables = packed_rgb10::make_avx2_tables(packed_rgb10::r210);
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLine = dst + y * dstStride;
+			const int simdWidth = packed_rgb10::convert_line_avx2(avx2Tables, srcLine, dstLine, width);
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
 		}
 		return true;
 	}
-	#else
-	bool convert(const uint8_t* src, uint16_t* dst, size_t width, size_t height, int pixelsToPad)
+
+	EZ_TARGET_AVX512
+	static bool convert_avx512(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
 	{
-		// Each row starts on 256-byte boundary
-		size_t srcStride = (width * 4 + 255) / 256 * 256;
-		const uint8_t* srcRow = src;
-		uint16_t* dstPix = dst;
-		const int dstPadding = pixelsToPad * 3;
+		const int dstStride = (width + pixelsToPad) * 3;
+		const __m512i sampleMask = _mm512_set1_epi16(static_cast<short>(0xFFC0));
 
-		for (size_t y = 0; y < height; ++y)
+		__m512i perm[3], shift[3];
+		for (int k = 0; k < 3; ++k)
 		{
-			const uint32_t* srcPixelBE = reinterpret_cast<const uint32_t*>(srcRow);
+			perm[k] = _mm512_load_si512(avx512Tables.perm[k]);
+			shift[k] = _mm512_load_si512(avx512Tables.shift[k]);
+		}
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* srcLine = src + y * srcStride;
+			uint16_t* dstLine = dst + y * dstStride;
 
-			for (size_t x = 0; x < width; ++x)
+			// lines are padded to 256 bytes so the loads cannot overrun the line but the stores for the last
+			// (partial) block must be masked
+			for (int x = 0; x < width; x += 32)
 			{
-				const auto srcPixel = _byteswap_ulong(srcPixelBE[x]);
+				const __m512i v0 = _mm512_loadu_si512(srcLine + x * 4);
+				const __m512i v1 = _mm512_loadu_si512(srcLine + x * 4 + 64);
+				const int samples = std::min(32, width - x) * 3;
+				for (int k = 0; k < 3; ++k)
+				{
+					const int remaining = std::clamp(samples - k * 32, 0, 32);
+					__m512i rgb = _mm512_permutex2var_epi8(v0, perm[k], v1);
+					// all ones maskz is the same instruction, gcc warns the unmasked intrinsic is uninitialised
+					rgb = _mm512_and_si512(_mm512_maskz_multishift_epi64_epi8(~0ULL, shift[k], rgb), sampleMask);
+					if (remaining == 32)
+					{
+						_mm512_storeu_si512(dstLine + x * 3 + k * 32, rgb);
+					}
+					else if (remaining > 0)
+					{
+						_mm512_mask_storeu_epi16(dstLine + x * 3 + k * 32, static_cast<__mmask32>((1ULL << remaining) - 1),
+						                         rgb);
+					}
+				}
+			}
+		}
+		return true;
+	}
 
-				const uint16_t red_16 = (srcPixel & 0x3FF00000) >> 14;
-				const uint16_t green_16 = (srcPixel & 0xFFC00) >> 4;
-				const uint16_t blue_16 = (srcPixel & 0x3FF) << 6;
+	// compact 2 pixels held as R G B 0 R G B 0 into the lower 12 bytes
+	EZ_TARGET_SSSE3
+	static __m128i pack_2(__m128i rgbx)
+	{
+		const __m128i compact = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+		return _mm_shuffle_epi8(rgbx, compact);
+	}
+
+	// converts 4 pixels to 16bit R, G & B, returned as 2 vectors of R G B 0 R G B 0
+	EZ_TARGET_SSSE3
+	static void unpack_4(const uint32_t* srcPixel, __m128i* rgbx01, __m128i* rgbx23)
+	{
+		const __m128i pixelEndianSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+		const __m128i mask = _mm_set1_epi32(0xFFC0);
+		const __m128i px = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcPixel)), pixelEndianSwap);
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(px, 14), mask);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(px, 4), mask);
+		const __m128i b = _mm_and_si128(_mm_slli_epi32(px, 6), mask);
+		const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+		*rgbx01 = _mm_unpacklo_epi32(rg, b);
+		*rgbx23 = _mm_unpackhi_epi32(rg, b);
+	}
+
+	EZ_TARGET_SSSE3
+	static bool convert_ssse3(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int simdWidth = width & ~7;
+		const int dstStride = (width + pixelsToPad) * 3;
 
-				dstPix[0] = red_16;
-				dstPix[1] = green_16;
-				dstPix[2] = blue_16;
-				dstPix += 3;
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLine = dst + y * dstStride;
+
+			// 8 pixels in, 48 bytes out
+			for (int x = 0; x < simdWidth; x += 8)
+			{
+				__m128i p01, p23, p45, p67;
+				unpack_4(srcLine + x, &p01, &p23);
+				unpack_4(srcLine + x + 4, &p45, &p67);
+				const __m128i k0 = pack_2(p01);
+				const __m128i k1 = pack_2(p23);
+				const __m128i k2 = pack_2(p45);
+				const __m128i k3 = pack_2(p67);
+
+				__m128i* out = reinterpret_cast<__m128i*>(dstLine + x * 3);
+				_mm_storeu_si128(out, _mm_or_si128(k0, _mm_slli_si128(k1, 12)));
+				_mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(k1, 4), _mm_slli_si128(k2, 8)));
+				_mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(k2, 8), _mm_slli_si128(k3, 4)));
 			}
-			srcRow += srcStride;
-			dstPix += dstPadding;
+			convert_line_scalar(srcLine, dstLine + simdWidth * 3, simdWidth, width);
 		}
 		return true;
 	}
-	#endif
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint16_t* dst, int width, int height, int pixelsToPad)
+	{
+		const int dstStride = (width + pixelsToPad) * 3;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			convert_line_scalar(srcLine, dst + y * dstStride, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
 };
 #endif
@@ -496,6 +496,17 @@ HRESULT CSignalInfoProp::ReloadV2(latency_stats* payload)
 	WCHAR buffer[256];
 	_snwprintf_s(buffer, _TRUNCATE, L"%.3f / %.3f / %.3f ms", static_cast<double>(payload->min) / to_millis_ratio,
 	             payload->mean / to_millis_ratio, static_cast<double>(payload->max) / to_millis_ratio);
+	// followed by the mean of each stripe when the conversion is striped
+	for (size_t i = 0; i < payload->stripes.size(); ++i)
+	{
+		WCHAR stripe[32];
+		_snwprintf_s(stripe, _TRUNCATE, i == 0 ? L" [%.2f" : L" %.2f", payload->stripes[i].mean / to_millis_ratio);
+		wcsncat_s(buffer, stripe, _TRUNCATE);
+	}
+	if (!payload->stripes.empty())
+	{
+		wcsncat_s(buffer, L"]", _TRUNCATE);
+	}
 	SendDlgItemMessage(m_Dlg, IDC_VIDEO_CONV_LAT, WM_SETTEXT, 0, reinterpret_cast<LPARAM>(buffer));
 
 	_snwprintf(buffer, _TRUNCATE, L"%hs", payload->name.c_str());
@@ -34,10 +34,33 @@ DEFINE_GUID(CLSID_SignalInfoProps,
 DEFINE_GUID(IID_ISignalInfo,
             0x6a505550, 0x28b2, 0x4668, 0xbc, 0x2c, 0x46, 0x1e, 0x75, 0xa6, 0x3b, 0xc4);
 
+// {5DE445A9-BF6E-4AE5-98E6-B56509C49EA1}
+DEFINE_GUID(IID_ISignalInfo2,
+            0x5de445a9, 0xbf6e, 0x4ae5, 0x98, 0xe6, 0xb5, 0x65, 0x09, 0xc4, 0x9e, 0xa1);
+
 // {4D6B8852-06A6-4997-BC07-3507BB77F748}
 DEFINE_GUID(IID_ISignalInfoCB,
             0x4d6b8852, 0x6a6, 0x4997, 0xbc, 0x7, 0x35, 0x7, 0xbb, 0x77, 0xf7, 0x48);
 
+// {AD7560EB-95F0-45BD-9F84-BCF2B0FE5D5D}
+DEFINE_GUID(IID_MediaSideDataActiveArea,
+            0xad7560eb, 0x95f0, 0x45bd, 0x9f, 0x84, 0xbc, 0xf2, 0xb0, 0xfe, 0x5d, 0x5d);
+
+// IMediaSideData attached to each video sample while active area detection is enabled, see active_area
+#pragma pack(push, 1)
+struct MediaSideDataActiveArea
+{
+	// first & last rows & columns (inclusive) which are not black bars
+	int top;
+	int bottom;
+	int left;
+	int right;
+	// of the frame
+	int width;
+	int height;
+};
+#pragma pack(pop)
+
 
 interface __declspec(uuid("4D6B8852-06A6-4997-BC07-3507BB77F748")) ISignalInfoCB
 {
@@ -76,6 +99,13 @@ interface __declspec(uuid("6A505550-28B2-4668-BC2C-461E75A63BC4")) ISignalInfo :
 	STDMETHOD(SetAudioCaptureEnabled)(bool enabled) = 0;
 };
 
+// ISignalInfo is published so it is left as is, later additions go here
+interface __declspec(uuid("5DE445A9-BF6E-4AE5-98E6-B56509C49EA1")) ISignalInfo2 : ISignalInfo
+{
+	// S_FALSE if detection is disabled or has not found an active area yet
+	STDMETHOD(GetActiveArea)(active_area* area) = 0;
+};
+
 class CSignalInfoProp :
 	public ISignalInfoCB,
 	public CBasePropertyPage
@@ -0,0 +1,73 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef V210_HEADER
+#define V210_HEADER
+
+#include <cstdint>
+#include "cpu_features.h"
+
+/**
+ * Unpacking of v210 (see v210_p210) shared by the writers which consume it.
+ */
+namespace v210
+{
+	// the 10-bit samples of one 6 pixel block as [Y0, Y1, Y2, Y3, Y4, Y5] & [U0, V0, U2, V2, U4, V4]
+	inline void unpack_block(const uint32_t* p, uint16_t* y, uint16_t* uv)
+	{
+		y[0] = static_cast<uint16_t>(p[0] >> 10 & 0x3FF);
+		y[1] = static_cast<uint16_t>(p[1] & 0x3FF);
+		y[2] = static_cast<uint16_t>(p[1] >> 20 & 0x3FF);
+		y[3] = static_cast<uint16_t>(p[2] >> 10 & 0x3FF);
+		y[4] = static_cast<uint16_t>(p[3] & 0x3FF);
+		y[5] = static_cast<uint16_t>(p[3] >> 20 & 0x3FF);
+		uv[0] = static_cast<uint16_t>(p[0] & 0x3FF);
+		uv[1] = static_cast<uint16_t>(p[0] >> 20 & 0x3FF);
+		uv[2] = static_cast<uint16_t>(p[1] >> 10 & 0x3FF);
+		uv[3] = static_cast<uint16_t>(p[2] & 0x3FF);
+		uv[4] = static_cast<uint16_t>(p[2] >> 20 & 0x3FF);
+		uv[5] = static_cast<uint16_t>(p[3] >> 10 & 0x3FF);
+	}
+
+	// unpacks 12 pixels (8 dwords) into the low 12 words of y & uv with each sample in bits 15-6
+	EZ_TARGET_AVX2
+	inline void unpack_group_avx2(const uint32_t* src, __m256i& y, __m256i& uv)
+	{
+		const __m256i mask_s0_s2 = _mm256_set1_epi32(0x3FF003FF);
+		const __m256i shift_s0_s2 = _mm256_set1_epi32(0x00040040);
+		const __m256i mask_s1 = _mm256_set1_epi32(0x000FFC00);
+		const __m256i y_shuffle_mask = _mm256_setr_epi8(
+			0, 1, 4, 5, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1,
+			0, 1, 4, 5, 6, 7, 8, 9, 12, 13, 14, 15, -1, -1, -1, -1
+		);
+		const __m256i uv_shuffle_mask = _mm256_setr_epi8(
+			0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1,
+			0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1
+		);
+		const __m256i lower_192_perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+		const __m256i dwords = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+
+		// extract & align 10-bit components across 2 vectors
+		const __m256i s0_s2 = _mm256_mullo_epi16(_mm256_and_si256(dwords, mask_s0_s2), shift_s0_s2);
+		const __m256i s1 = _mm256_srli_epi32(_mm256_and_si256(dwords, mask_s1), 4);
+
+		// blend & shuffle & permute to align samples in lower 192bits
+		y = _mm256_permutevar8x32_epi32(
+			_mm256_shuffle_epi8(_mm256_blend_epi32(s0_s2, s1, 0b01010101), y_shuffle_mask), lower_192_perm);
+		uv = _mm256_permutevar8x32_epi32(
+			_mm256_shuffle_epi8(_mm256_blend_epi32(s0_s2, s1, 0b10101010), uv_shuffle_mask), lower_192_perm);
+	}
+}
+#endif
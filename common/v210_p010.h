@@ -0,0 +1,244 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef V210_P010_HEADER
+#define V210_P010_HEADER
+
+#include "VideoFrameWriter.h"
+#include "v210.h"
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * Unpacks v210 (see v210_p210) into P010, the chroma of each pair of lines is averaged as it is unpacked so the 4:2:0
+ * output is written in a single pass over the source.
+ */
+template <typename VF>
+class v210_p010 : public IVideoFrameWriter<VF>
+{
+public:
+	v210_p010(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &P010)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("v210 to P010");
+	}
+
+	~v210_p010() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		auto actualWidth = width + this->mPixelsToPad;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// P010 format: 16-bit samples, full res Y plane followed by a half height interleaved UV plane
+		auto outSpan = std::span(outData, dstSize);
+		auto yPlaneSize = actualWidth * height * 2;
+		auto uvPlaneSize = actualWidth * (height / 2) * 2;
+
+		uint8_t* yPlane = outSpan.subspan(0, yPlaneSize).data();
+		uint8_t* uvPlane = outSpan.subspan(yPlaneSize, uvPlaneSize).data();
+
+		auto alignedWidth = (width + 47) / 48 * 48;
+		auto srcStride = alignedWidth * 8 / 3;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const auto dstStride = actualWidth * 2;
+		// stripes start on an even line so each one owns whole rows of the UV plane
+		const output_plane planes[]{{yPlane, dstStride}, {uvPlane, dstStride, 1}};
+		light_level_frame lightLevel;
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(&lightLevel, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint16_t>(measures, dst[0], dstStride, width, firstLine, lineCount,
+			                                         [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * dstStride,
+				         dst[1] + (line >> 1) * dstStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to P010 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad);
+
+	// converts the pixels of a pair of lines from x (which must be a multiple of 6) to the end of the line
+	static void convert_pair_scalar(const uint32_t* srcLine0, const uint32_t* srcLine1, uint16_t* dstLineY0,
+	                                uint16_t* dstLineY1, uint16_t* dstLineUV, int x, int width)
+	{
+		for (; x < width; x += 6)
+		{
+			uint16_t y0[6], uv0[6], y1[6], uv1[6];
+			v210::unpack_block(srcLine0 + x / 6 * 4, y0, uv0);
+			v210::unpack_block(srcLine1 + x / 6 * 4, y1, uv1);
+
+			// the last block on a line may be partially filled
+			const int pixels = std::min(6, width - x);
+			for (int i = 0; i < pixels; ++i)
+			{
+				dstLineY0[x + i] = static_cast<uint16_t>(y0[i] << 6);
+				dstLineY1[x + i] = static_cast<uint16_t>(y1[i] << 6);
+				dstLineUV[x + i] = static_cast<uint16_t>((uv0[i] + uv1[i] + 1) >> 1 << 6);
+			}
+		}
+	}
+
+	// an odd line at the bottom of the frame has no chroma row of its own
+	static void convert_luma_scalar(const uint32_t* srcLine, uint16_t* dstLineY, int width)
+	{
+		for (int x = 0; x < width; x += 6)
+		{
+			uint16_t y[6], uv[6];
+			v210::unpack_block(srcLine + x / 6 * 4, y, uv);
+			const int pixels = std::min(6, width - x);
+			for (int i = 0; i < pixels; ++i)
+			{
+				dstLineY[x + i] = static_cast<uint16_t>(y[i] << 6);
+			}
+		}
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                         int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, dstY, dstUV, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		const int groupsPerLine = width / 12;
+		const int effectiveWidth = width + pixelsToPad;
+		// avg_epu16 of 2 samples in bits 15-6 leaves the halved sum in bits 15-5, add half an lsb before masking to round
+		const __m256i round = _mm256_set1_epi16(0x20);
+		const __m256i sampleMask = _mm256_set1_epi16(static_cast<short>(0xFFC0));
+
+		int lineNo = 0;
+		for (; lineNo + 1 < height; lineNo += 2)
+		{
+			const uint32_t* srcLine0 = reinterpret_cast<const uint32_t*>(src + lineNo * srcStride);
+			const uint32_t* srcLine1 = reinterpret_cast<const uint32_t*>(src + (lineNo + 1) * srcStride);
+			uint16_t* dstLineY0 = reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2);
+			uint16_t* dstLineY1 = reinterpret_cast<uint16_t*>(dstY + (lineNo + 1) * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + lineNo / 2 * effectiveWidth * 2);
+
+			// each group writes 16 samples of which 12 are valid, the overflow is overwritten by the next group so only
+			// the last group on the line has to go via a temporary buffer
+			for (int g = 0; g < groupsPerLine; ++g)
+			{
+				__m256i y0, uv0, y1, uv1;
+				v210::unpack_group_avx2(srcLine0 + g * 8, y0, uv0);
+				v210::unpack_group_avx2(srcLine1 + g * 8, y1, uv1);
+				const __m256i uv = _mm256_and_si256(_mm256_add_epi16(_mm256_avg_epu16(uv0, uv1), round), sampleMask);
+
+				if (g == groupsPerLine - 1)
+				{
+					alignas(32) uint16_t tmp[3][16];
+					_mm256_store_si256(reinterpret_cast<__m256i*>(tmp[0]), y0);
+					_mm256_store_si256(reinterpret_cast<__m256i*>(tmp[1]), y1);
+					_mm256_store_si256(reinterpret_cast<__m256i*>(tmp[2]), uv);
+					std::memcpy(dstLineY0 + g * 12, tmp[0], 24);
+					std::memcpy(dstLineY1 + g * 12, tmp[1], 24);
+					std::memcpy(dstLineUV + g * 12, tmp[2], 24);
+				}
+				else
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineY0 + g * 12), y0);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineY1 + g * 12), y1);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineUV + g * 12), uv);
+				}
+			}
+
+			// any pixels which do not fill a complete group
+			convert_pair_scalar(srcLine0, srcLine1, dstLineY0, dstLineY1, dstLineUV, groupsPerLine * 12, width);
+		}
+		if (lineNo < height)
+		{
+			convert_luma_scalar(reinterpret_cast<const uint32_t*>(src + lineNo * srcStride),
+			                    reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2), width);
+		}
+
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad)
+	{
+		const int effectiveWidth = width + pixelsToPad;
+
+		int lineNo = 0;
+		for (; lineNo + 1 < height; lineNo += 2)
+		{
+			convert_pair_scalar(reinterpret_cast<const uint32_t*>(src + lineNo * srcStride),
+			                    reinterpret_cast<const uint32_t*>(src + (lineNo + 1) * srcStride),
+			                    reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2),
+			                    reinterpret_cast<uint16_t*>(dstY + (lineNo + 1) * effectiveWidth * 2),
+			                    reinterpret_cast<uint16_t*>(dstUV + lineNo / 2 * effectiveWidth * 2), 0, width);
+		}
+		if (lineNo < height)
+		{
+			convert_luma_scalar(reinterpret_cast<const uint32_t*>(src + lineNo * srcStride),
+			                    reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2), width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
@@ -0,0 +1,373 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef V210_P210_HEADER
+#define V210_P210_HEADER
+
+#include "VideoFrameWriter.h"
+#include "v210.h"
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+template<typename VF>
+class v210_p210 : public IVideoFrameWriter<VF>
+{
+public:
+	v210_p210(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &P210)
+	{
+		const auto& cpu = GetCpuFeatures();
+		if (pMaxIsa >= ISA_AVX512 && cpu.Supports(ISA_AVX512))
+		{
+			mConvert = convert_avx512<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx512<W>; });
+			this->mIsa = ISA_AVX512;
+		}
+		else if (pMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("v210 to P210");
+	}
+
+	~v210_p210() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		auto actualWidth = width + this->mPixelsToPad;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// P210 format: 16-bit samples, full res Y plane, half-width U and V planes
+		auto outSpan = std::span(outData, dstSize);
+		auto planeSize = actualWidth * height * 2;
+
+		uint8_t* yPlane = outSpan.subspan(0, planeSize).data();
+		uint8_t* uvPlane = outSpan.subspan(planeSize, planeSize).data();
+
+		auto alignedWidth = (width + 47) / 48 * 48;
+		auto srcStride = alignedWidth * 8 / 3;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const auto dstStride = actualWidth * 2;
+		const output_plane planes[]{{yPlane, dstStride}, {uvPlane, dstStride}};
+		light_level_frame lightLevel;
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(&lightLevel, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint16_t>(measures, dst[0], dstStride, width, firstLine, lineCount,
+			                                         [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * dstStride,
+				         dst[1] + line * dstStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to P210 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad);
+
+	// v210 format
+	// 12 10-bit unsigned components are packed into four 32-bit little-endian words hence
+	// each block specifies the following samples in decreasing address order
+	// V0 Y0 U0
+	// Y2 U2 Y1
+	// U4 Y3 V2
+	// Y5 V4 Y4
+	// which needs to get written out as
+	// y plane  : Y0 Y1 Y2 Y3 Y4 Y5
+	// uv plane : U0 V0 U2 V2 U4 V4
+	// each line of video is aligned on a 128 byte boundary & 6 pixels fit into 16 bytes so 48 pixels fit in 128 bytes
+
+	// converts the pixels from x (which must be a multiple of 6) to the end of the line
+	static void convert_line_scalar(const uint32_t* srcLine, uint16_t* dstLineY, uint16_t* dstLineUV, int x, int width)
+	{
+		srcLine += x / 6 * 4;
+		dstLineY += x;
+		dstLineUV += x;
+		for (; x < width; x += 6)
+		{
+			// reorder each 32bit block from
+			// V0 Y0 U0 
+			// Y2 U2 Y1
+			// U4 Y3 V2
+			// Y5 V4 Y4
+			// to
+			// [Y0, Y1, Y2, Y3, Y4, Y5] & [U0, V0, U2, V2, U4, V4]
+			const uint32_t* p = srcLine;
+			const uint16_t y[6] = {
+				static_cast<uint16_t>((p[0] >> 10 & 0x3FF) << 6), // Y0
+				static_cast<uint16_t>((p[1] & 0x3FF) << 6), // Y1
+				static_cast<uint16_t>((p[1] >> 20 & 0x3FF) << 6), // Y2
+				static_cast<uint16_t>((p[2] >> 10 & 0x3FF) << 6), // Y3
+				static_cast<uint16_t>((p[3] & 0x3FF) << 6), // Y4
+				static_cast<uint16_t>((p[3] >> 20 & 0x3FF) << 6) // Y5
+			};
+			const uint16_t uv[6] = {
+				static_cast<uint16_t>((p[0] & 0x3FF) << 6), // U0
+				static_cast<uint16_t>((p[0] >> 20 & 0x3FF) << 6), // V0
+				static_cast<uint16_t>((p[1] >> 10 & 0x3FF) << 6), // U2
+				static_cast<uint16_t>((p[2] & 0x3FF) << 6), // V2
+				static_cast<uint16_t>((p[2] >> 20 & 0x3FF) << 6), // U4
+				static_cast<uint16_t>((p[3] >> 10 & 0x3FF) << 6) // V4
+			};
+
+			// the last group on a line may be partially filled
+			const int pixels = std::min(6, width - x);
+			for (int i = 0; i < pixels; ++i)
+			{
+				dstLineY[i] = y[i];
+				dstLineUV[i] = uv[i];
+			}
+
+			// shift the pointer to the next group
+			dstLineY += 6;
+			dstLineUV += 6;
+			srcLine += 4;
+		}
+	}
+
+	// lookup tables for the AVX-512 kernel which converts 96 pixels (4 x 64 bytes of v210) per pass into 3 x 32 samples
+	// of Y and UV, output vector k is sourced from the 128 bytes starting at input vector k.
+	// vpermb copies the 2 bytes which contain each 10-bit sample into the 16-bit output slot then vpmultishiftqb
+	// shifts each sample into the top 10 bits of the slot
+	struct avx512_tables
+	{
+		alignas(64) uint8_t yPerm[3][64];
+		alignas(64) uint8_t yShift[3][64];
+		alignas(64) uint8_t uvPerm[3][64];
+		alignas(64) uint8_t uvShift[3][64];
+	};
+
+	static constexpr avx512_tables make_avx512_tables()
+	{
+		// bit offset of each sample within a 16 byte block
+		constexpr int yBits[6] = {10, 32, 52, 74, 96, 116};
+		constexpr int uvBits[6] = {0, 20, 42, 64, 84, 106};
+		avx512_tables t{};
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int w = 0; w < 32; ++w)
+			{
+				const int pixel = k * 32 + w;
+				const int blockOffset = pixel / 6 * 16 - k * 64;
+				const int slot = w % 4 * 16;
+
+				const int yBit = yBits[pixel % 6];
+				t.yPerm[k][w * 2] = static_cast<uint8_t>(blockOffset + yBit / 8);
+				t.yPerm[k][w * 2 + 1] = static_cast<uint8_t>(blockOffset + yBit / 8 + 1);
+				t.yShift[k][w * 2] = static_cast<uint8_t>((slot + yBit % 8 - 6) & 63);
+				t.yShift[k][w * 2 + 1] = static_cast<uint8_t>((slot + yBit % 8 + 2) & 63);
+
+				const int uvBit = uvBits[pixel % 6];
+				t.uvPerm[k][w * 2] = static_cast<uint8_t>(blockOffset + uvBit / 8);
+				t.uvPerm[k][w * 2 + 1] = static_cast<uint8_t>(blockOffset + uvBit / 8 + 1);
+				t.uvShift[k][w * 2] = static_cast<uint8_t>((slot + uvBit % 8 - 6) & 63);
+				t.uvShift[k][w * 2 + 1] = static_cast<uint8_t>((slot + uvBit % 8 + 2) & 63);
+			}
+		}
+		return t;
+	}
+
+	static constexpr avx512_tables avx512Tables = make_avx512_tables();
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX512
+	static bool convert_avx512(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx512<>(src, srcStride, dstY, dstUV, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		const int effectiveWidth = width + pixelsToPad;
+		const int simdWidth = width / 96 * 96;
+		const __m512i sampleMask = _mm512_set1_epi16(static_cast<short>(0xFFC0));
+
+		__m512i yPerm[3], yShift[3], uvPerm[3], uvShift[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			yPerm[k] = _mm512_load_si512(avx512Tables.yPerm[k]);
+			yShift[k] = _mm512_load_si512(avx512Tables.yShift[k]);
+			uvPerm[k] = _mm512_load_si512(avx512Tables.uvPerm[k]);
+			uvShift[k] = _mm512_load_si512(avx512Tables.uvShift[k]);
+		}
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint8_t* srcLine = src + lineNo * srcStride;
+			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + lineNo * effectiveWidth * 2);
+
+			int x = 0;
+			for (; x < simdWidth; x += 96)
+			{
+				const uint8_t* in = srcLine + x / 6 * 16;
+				__m512i v[4];
+				for (int i = 0; i < 4; ++i)
+				{
+					v[i] = _mm512_loadu_si512(in + i * 64);
+				}
+				// the all ones maskz forms are the same instructions but gcc warns the unmasked intrinsics are uninitialised
+				for (int k = 0; k < 3; ++k)
+				{
+					__m512i y = _mm512_permutex2var_epi8(v[k], yPerm[k], v[k + 1]);
+					y = _mm512_and_si512(_mm512_maskz_multishift_epi64_epi8(~0ULL, yShift[k], y), sampleMask);
+					_mm512_storeu_si512(dstLineY + x + k * 32, y);
+
+					__m512i uv = _mm512_permutex2var_epi8(v[k], uvPerm[k], v[k + 1]);
+					uv = _mm512_and_si512(_mm512_maskz_multishift_epi64_epi8(~0ULL, uvShift[k], uv), sampleMask);
+					_mm512_storeu_si512(dstLineUV + x + k * 32, uv);
+				}
+			}
+
+			if constexpr (FixedWidth % 96 == 0 && FixedWidth != 0)
+			{
+				continue;
+			}
+
+			// remaining pixels in blocks of 24 (i.e. 64 bytes of v210) using the first 24 samples of the first output
+			// vector, lines are padded to 128 bytes so the load cannot overrun the line but the store must be masked
+			for (; x < width; x += 24)
+			{
+				const int pixels = std::min(24, width - x);
+				const __mmask32 storeMask = static_cast<__mmask32>((1ULL << pixels) - 1);
+				const __m512i v = _mm512_loadu_si512(srcLine + x / 6 * 16);
+
+				__m512i y = _mm512_maskz_permutexvar_epi8(~0ULL, yPerm[0], v);
+				y = _mm512_and_si512(_mm512_maskz_multishift_epi64_epi8(~0ULL, yShift[0], y), sampleMask);
+				_mm512_mask_storeu_epi16(dstLineY + x, storeMask, y);
+
+				__m512i uv = _mm512_maskz_permutexvar_epi8(~0ULL, uvPerm[0], v);
+				uv = _mm512_and_si512(_mm512_maskz_multishift_epi64_epi8(~0ULL, uvShift[0], uv), sampleMask);
+				_mm512_mask_storeu_epi16(dstLineUV + x, storeMask, uv);
+			}
+		}
+		return true;
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                         int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, dstY, dstUV, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		const int groupsPerLine = width / 12;
+		const int effectiveWidth = width + pixelsToPad;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + lineNo * srcStride);
+			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + lineNo * effectiveWidth * 2);
+
+			// each group writes 16 samples of which 12 are valid, the overflow is overwritten by the next group
+			// (or line) except on the last line where the last group has to go via a temporary buffer
+			const bool lastLine = lineNo == height - 1;
+			const int directGroups = lastLine && groupsPerLine > 0 ? groupsPerLine - 1 : groupsPerLine;
+			__m256i y, uv;
+			for (int g = 0; g < directGroups; ++g)
+			{
+				v210::unpack_group_avx2(srcLine + g * 8, y, uv);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineY + g * 12), y);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dstLineUV + g * 12), uv);
+			}
+			if (directGroups < groupsPerLine)
+			{
+				const int g = directGroups;
+				alignas(32) uint16_t tmpY[16];
+				alignas(32) uint16_t tmpUV[16];
+				v210::unpack_group_avx2(srcLine + g * 8, y, uv);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(tmpY), y);
+				_mm256_store_si256(reinterpret_cast<__m256i*>(tmpUV), uv);
+				std::memcpy(dstLineY + g * 12, tmpY, 24);
+				std::memcpy(dstLineUV + g * 12, tmpUV, 24);
+			}
+
+			// any pixels which do not fill a complete group
+			if constexpr (FixedWidth % 12 != 0 || FixedWidth == 0)
+			{
+				convert_line_scalar(srcLine, dstLineY, dstLineUV, groupsPerLine * 12, width);
+			}
+		}
+
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad)
+	{
+		auto effectiveWidth = width + pixelsToPad;
+
+		for (int y = 0; y < height; y++)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + y * srcStride);
+			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + y * effectiveWidth * 2);
+			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + y * effectiveWidth * 2);
+			convert_line_scalar(srcLine, dstLineY, dstLineUV, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
@@ -0,0 +1,272 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef V210_YUV8_HEADER
+#define V210_YUV8_HEADER
+
+#include "VideoFrameWriter.h"
+#include "dither.h"
+#include "v210.h"
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * Unpacks v210 (see v210_p210) to 8-bit 4:2:2, either planar (YV16) or with interleaved chroma (NV16), for renderers
+ * which do not accept a 10-bit format. Each sample is dithered (see dither.h) as it is unpacked.
+ */
+template <typename VF, bool Interleaved>
+class v210_yuv8 : public IVideoFrameWriter<VF>
+{
+public:
+	v210_yuv8(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, Interleaved ? &NV16 : &YV16)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel(Interleaved ? "v210 to NV16 (dithered)" : "v210 to YV16 (dithered)");
+	}
+
+	~v210_yuv8() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		const auto actualWidth = width + this->mPixelsToPad;
+		const auto pixelCount = actualWidth * height;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// NV16 is a Y plane followed by a full height interleaved UV plane, YV16 is a Y plane followed by V then U planes
+		auto outSpan = std::span(outData, dstSize);
+		uint8_t* yPlane = outSpan.subspan(0, pixelCount).data();
+		uint8_t* uvPlane = outSpan.subspan(pixelCount, pixelCount).data();
+		uint8_t* vPlane = uvPlane;
+		uint8_t* uPlane = uvPlane + pixelCount / 2;
+
+		auto alignedWidth = (width + 47) / 48 * 48;
+		auto srcStride = alignedWidth * 8 / 3;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		// stripes start on an even line so the dither pattern lines up across them
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(nullptr, &activeArea);
+		if constexpr (Interleaved)
+		{
+			const output_plane planes[]{{yPlane, actualWidth}, {uvPlane, actualWidth}};
+			this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+			                                                               int lineCount, uint8_t* const* dst)
+			{
+				this->template ConvertMeasured<uint8_t>(measures, dst[0], actualWidth, width, firstLine, lineCount,
+				                                        [&](int line, int lines)
+				{
+					uint8_t* uv = dst[1] + line * actualWidth;
+					mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * actualWidth, uv, uv, uv, width,
+					         lines, this->mPixelsToPad);
+				});
+			});
+		}
+		else
+		{
+			const int uvStride = actualWidth / 2;
+			const output_plane planes[]{{yPlane, actualWidth}, {uPlane, uvStride}, {vPlane, uvStride}};
+			this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+			                                                               int lineCount, uint8_t* const* dst)
+			{
+				this->template ConvertMeasured<uint8_t>(measures, dst[0], actualWidth, width, firstLine, lineCount,
+				                                        [&](int line, int lines)
+				{
+					uint8_t* u = dst[1] + line * uvStride;
+					mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * actualWidth, u,
+					         dst[2] + line * uvStride, u, width, lines, this->mPixelsToPad);
+				});
+			});
+		}
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to {} in {:.3f} ms", this->mLogData.prefix,
+		             Interleaved ? "NV16" : "YV16", execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           uint8_t* uvPlane, int width, int height, int pixelsToPad);
+
+	// converts the pixels of a line from x (which must be a multiple of 6) to the end of the line
+	static void convert_line_scalar(const uint32_t* srcLine, uint8_t* yOut, uint8_t* uOut, uint8_t* vOut,
+	                                uint8_t* uvOut, int lineNo, int x, int width)
+	{
+		for (; x < width; x += 6)
+		{
+			uint16_t y[6], uv[6];
+			v210::unpack_block(srcLine + x / 6 * 4, y, uv);
+
+			// the last block on a line may be partially filled
+			const int pixels = std::min(6, width - x);
+			for (int i = 0; i < pixels; ++i)
+			{
+				yOut[x + i] = dither::to_8bit(static_cast<uint16_t>(y[i] << 6), dither::threshold(lineNo, x + i));
+			}
+			for (int i = 0; i < pixels; i += 2)
+			{
+				const int column = (x + i) / 2;
+				const auto t = dither::threshold(lineNo, column);
+				const auto u = dither::to_8bit(static_cast<uint16_t>(uv[i] << 6), t);
+				const auto v = dither::to_8bit(static_cast<uint16_t>(uv[i + 1] << 6), t);
+				if constexpr (Interleaved)
+				{
+					uvOut[column * 2] = u;
+					uvOut[column * 2 + 1] = v;
+				}
+				else
+				{
+					uOut[column] = u;
+					vOut[column] = v;
+				}
+			}
+		}
+	}
+
+	// packs the low 12 words of a and of b (each holding an 8-bit value) into the low 24 bytes
+	EZ_TARGET_AVX2
+	static __m256i pack24(__m256i a, __m256i b)
+	{
+		// packus leaves a0-7 b0-7 | a8-15 b8-15 so the wanted bytes are dwords 0, 1, 4 then 2, 3, 6
+		const __m256i perm = _mm256_setr_epi32(0, 1, 4, 2, 3, 6, 5, 7);
+		return _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, b), perm);
+	}
+
+	EZ_TARGET_AVX2
+	static void store24(uint8_t* dst, __m256i v)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(v));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), _mm256_extracti128_si256(v, 1));
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                         uint8_t* uvPlane, int width, int height, int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, yPlane, uPlane, vPlane, uvPlane, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		// U0 V0 U1 V1 ... to U0 U1 ... V0 V1 ..., the last 4 columns are in the upper lane
+		const __m128i deinterleave8 = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+		const __m128i deinterleave4 = _mm_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = Interleaved ? yWidth : yWidth / 2;
+		const int simdWidth = width / 24 * 24;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + lineNo * srcStride);
+			uint8_t* yOut = yPlane + lineNo * yWidth;
+			uint8_t* uOut = uPlane + lineNo * uvWidth;
+			uint8_t* vOut = vPlane + lineNo * uvWidth;
+			uint8_t* uvOut = uvPlane + lineNo * uvWidth;
+			const __m256i yThresholds = dither::luma_thresholds_avx2(lineNo);
+			const __m256i uvThresholds = dither::chroma_thresholds_avx2(lineNo);
+
+			for (int x = 0; x < simdWidth; x += 24) // 2 groups of 12 pixels per pass
+			{
+				__m256i y0, uv0, y1, uv1;
+				v210::unpack_group_avx2(srcLine + x / 12 * 8, y0, uv0);
+				v210::unpack_group_avx2(srcLine + x / 12 * 8 + 8, y1, uv1);
+
+				store24(yOut + x, pack24(dither::to_8bit_avx2(y0, yThresholds), dither::to_8bit_avx2(y1, yThresholds)));
+
+				const __m256i uv = pack24(dither::to_8bit_avx2(uv0, uvThresholds),
+				                          dither::to_8bit_avx2(uv1, uvThresholds));
+				if constexpr (Interleaved)
+				{
+					store24(uvOut + x, uv);
+				}
+				else
+				{
+					const __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(uv), deinterleave8);
+					const __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(uv, 1), deinterleave4);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(uOut + x / 2), lo);
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(vOut + x / 2), _mm_unpackhi_epi64(lo, lo));
+					const int u = _mm_cvtsi128_si32(hi);
+					const int v = _mm_extract_epi32(hi, 1);
+					std::memcpy(uOut + x / 2 + 8, &u, 4);
+					std::memcpy(vOut + x / 2 + 8, &v, 4);
+				}
+			}
+			convert_line_scalar(srcLine, yOut, uOut, vOut, uvOut, lineNo, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           uint8_t* uvPlane, int width, int height, int pixelsToPad)
+	{
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = Interleaved ? yWidth : yWidth / 2;
+
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			convert_line_scalar(reinterpret_cast<const uint32_t*>(src + lineNo * srcStride), yPlane + lineNo * yWidth,
+			                    uPlane + lineNo * uvWidth, vPlane + lineNo * uvWidth, uvPlane + lineNo * uvWidth,
+			                    lineNo, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+
+template <typename VF>
+using v210_yv16 = v210_yuv8<VF, false>;
+
+template <typename VF>
+using v210_nv16 = v210_yuv8<VF, true>;
+#endif
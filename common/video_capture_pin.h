@@ -23,16 +23,16 @@
 
 #define S_RECONNECTION_UNNECESSARY ((HRESULT)1024L)
 
+#include <tuple>
+
 #include "capture_pin.h"
 #include "modeswitcher.h"
 #include "lavfilters_side_data.h"
-#include "bgr10_rgb48.h"
-#include "r210_rgb48.h"
-#include "uyvy_yv16.h"
-#include "v210_p210.h"
-#include "y210_p210.h"
-#include "yuv2_yv16.h"
-#include "yuy2_yv16.h"
+#include "signalinfo.h"
+#include "kernel_calibration.h"
+#include "frame_fingerprint.h"
+#include "cadence.h"
+#include "preview.h"
 
 /**
  * A stream of video flowing from the capture device to an output pin.
@@ -69,19 +69,14 @@ public:
 		auto hr = E_FAIL;
 		auto idx = 0;
 		CMediaType mt;
-		if (S_OK == GetMediaType(idx++, &mt))
+		while (S_OK == GetMediaType(idx, &mt))
 		{
 			if (mt == *pmt)
 			{
 				hr = S_OK;
+				break;
 			}
-			else if (S_OK == GetMediaType(idx, &mt))
-			{
-				if (mt == *pmt)
-				{
-					hr = S_OK;
-				}
-			}
+			++idx;
 		}
 
 		#ifndef NO_QUILL
@@ -98,7 +93,8 @@ protected:
 		capture_pin(phr, pParent, pObjectName, pPinName, pLogPrefix, pType, true),
 		mVideoFormat(pVideoFormat),
 		mSignalledFormat(pVideoFormat.pixelFormat),
-		mFormatFallbacks(std::move(pFallbacks))
+		mFormatFallbacks(std::move(pFallbacks)),
+		mDeviceType(pType)
 	{
 	}
 
@@ -110,25 +106,14 @@ protected:
 		{
 			return E_INVALIDARG;
 		}
-		switch (iPosition)
+		const auto formats = OfferedFormats();
+		if (static_cast<size_t>(iPosition) >= formats.size())
 		{
-		case 0:
-			VideoFormatToMediaType(pMediaType, &mVideoFormat);
-			return S_OK;
-		case 1:
-			const auto s = mFormatFallbacks.find(mSignalledFormat);
-			if (s == mFormatFallbacks.end())
-			{
-				return VFW_S_NO_MORE_ITEMS;
-			}
-			auto fallbackPixelFormat = s->second.first;
-			auto fallbackVideoFormat = mVideoFormat;
-			fallbackVideoFormat.pixelFormat = std::move(fallbackPixelFormat);
-			fallbackVideoFormat.CalculateDimensions();
-			VideoFormatToMediaType(pMediaType, &fallbackVideoFormat);
-			return S_OK;
+			return VFW_S_NO_MORE_ITEMS;
 		}
-		return VFW_S_NO_MORE_ITEMS;
+		auto videoFormat = OutputVideoFormat(formats[iPosition].first);
+		VideoFormatToMediaType(pMediaType, &videoFormat);
+		return S_OK;
 	}
 
 	// IAMStreamConfig
@@ -137,6 +122,60 @@ protected:
 	// CapturePin
 	bool ProposeBuffers(ALLOCATOR_PROPERTIES* pProperties) override;
 
+	/**
+	 * Output formats for a signalled format in order of preference, each with the strategy which produces it. The
+	 * signalled format is passed straight through ahead of any conversion except dithered 8-bit output, fallbacks only
+	 * include that when dithering is enabled and it is then preferred even if the renderer accepts the 10-bit format.
+	 */
+	std::vector<pixel_format_fallback> OutputFormats(const pixel_format& signalledFormat) const
+	{
+		std::vector<pixel_format_fallback> formats;
+		if (const auto search = mFormatFallbacks.find(signalledFormat); search != mFormatFallbacks.end())
+		{
+			formats = search->second;
+		}
+		const auto straightThrough = std::ranges::find_if(formats, [&](const pixel_format_fallback& f)
+		{
+			return f.first.bitDepth >= signalledFormat.bitDepth;
+		});
+		// RGB32 is BGRA in memory so ARGB can only be delivered after its bytes are swapped
+		if (signalledFormat != ARGB)
+		{
+			formats.insert(straightThrough, {signalledFormat, STRAIGHT_THROUGH});
+		}
+		return formats;
+	}
+
+	// as offered to the renderer, a conversion which has already been negotiated comes first so it is kept
+	std::vector<pixel_format_fallback> OfferedFormats() const
+	{
+		auto formats = OutputFormats(mSignalledFormat);
+		if (mVideoFormat.pixelFormat != mSignalledFormat)
+		{
+			const auto current = std::ranges::find_if(formats, [&](const pixel_format_fallback& f)
+			{
+				return f.first == mVideoFormat.pixelFormat;
+			});
+			if (current == formats.end())
+			{
+				formats.insert(formats.begin(), {mVideoFormat.pixelFormat, STRAIGHT_THROUGH});
+			}
+			else
+			{
+				std::rotate(formats.begin(), current, current + 1);
+			}
+		}
+		return formats;
+	}
+
+	video_format OutputVideoFormat(const pixel_format& pixelFormat) const
+	{
+		auto videoFormat = mVideoFormat;
+		videoFormat.pixelFormat = pixelFormat;
+		videoFormat.CalculateDimensions();
+		return videoFormat;
+	}
+
 	void VideoFormatToMediaType(CMediaType* pmt, video_format* videoFormat) const;
 	bool ShouldChangeMediaType(video_format* newVideoFormat, bool pixelFallBackIsActive = false);
 	HRESULT DoChangeMediaType(const CMediaType* pNewMt, const video_format* newVideoFormat);
@@ -155,6 +194,7 @@ protected:
 	video_format mVideoFormat{};
 	pixel_format mSignalledFormat{NA};
 	pixel_format_fallbacks mFormatFallbacks{};
+	device_type mDeviceType;
 };
 
 template <class F, typename VF>
@@ -175,12 +215,70 @@ public:
 	void UpdateFrameWriterStrategy()
 	{
 		auto search = mFormatFallbacks.find(mVideoFormat.pixelFormat);
-		SetFrameWriterStrategy(search == mFormatFallbacks.end() ? STRAIGHT_THROUGH : search->second.second,
+		SetFrameWriterStrategy(search == mFormatFallbacks.end() ? STRAIGHT_THROUGH : search->second.front().second,
 		                       mVideoFormat.pixelFormat);
 	}
 
+	HRESULT SetMediaType(const CMediaType* pmt) override
+	{
+		auto hr = video_capture_pin::SetMediaType(pmt);
+		if (SUCCEEDED(hr))
+		{
+			// the renderer may have accepted any of the offered formats so convert to whichever one it picked
+			auto strategy = UNKNOWN;
+			for (const auto& [pixelFormat, candidate] : OfferedFormats())
+			{
+				CMediaType mt;
+				auto videoFormat = OutputVideoFormat(pixelFormat);
+				VideoFormatToMediaType(&mt, &videoFormat);
+				if (mt == *pmt)
+				{
+					strategy = candidate;
+					mVideoFormat = videoFormat;
+					break;
+				}
+			}
+			if (strategy != UNKNOWN && strategy != mFrameWriterStrategy)
+			{
+				SetFrameWriterStrategy(strategy, mSignalledFormat);
+			}
+		}
+		return hr;
+	}
+
+	/**
+	 * Feeds the preview pin with a box filtered copy of the frames this pin converts, the sink belongs to the preview pin
+	 * which is owned by the same filter.
+	 */
+	void SetPreviewSink(preview_sink* pSink)
+	{
+		mPreviewSink = pSink;
+		mPreviewSink->SetVideoFormat(mVideoFormat);
+		if (mFrameWriter)
+		{
+			mFrameWriter->SetPreviewSink(mPreviewSink);
+		}
+	}
+
+	/**
+	 * Point samples a delivered frame into the preview if the writer did not box filter one while converting it, i.e.
+	 * for straight through or packed outputs.
+	 */
+	void PreviewDelivered(IMediaSample* pms)
+	{
+		BYTE* out;
+		if (mPreviewSink && mFrameWriter && SUCCEEDED(pms->GetPointer(&out)))
+		{
+			mPreviewSink->Sample(out, mVideoFormat, mFrameWriter->GetPixelsToPad());
+		}
+	}
+
 	void RecordLatency()
 	{
+		if (mConversionPool && mConversionPool->ConsumeStripeTimes(mStripeTimes))
+		{
+			mFrameMetrics.sampleStripes(mStripeTimes);
+		}
 		if (mFrameTs.recordTo(mFrameMetrics))
 		{
 			mFilter->RecordVideoFrameLatency(mFrameMetrics);
@@ -189,41 +287,187 @@ public:
 
 protected:
 	F* mFilter;
+	// declared before the writer which holds a pointer to it
+	std::unique_ptr<conversion_pool> mConversionPool;
+	std::vector<uint64_t> mStripeTimes{};
+	light_level_meter mLightLevelMeter;
+	active_area_meter mActiveAreaMeter;
+	repeat_detector mRepeatDetector;
+	cadence_detector mCadence;
 	std::unique_ptr<IVideoFrameWriter<VF>> mFrameWriter;
 	frame_writer_strategy mFrameWriterStrategy{UNKNOWN};
 	AsyncModeSwitcher mRateSwitcher;
+	active_area mActiveArea{};
+	LONGLONG mLastMeasuredActiveAreaAt{0};
+	preview_sink* mPreviewSink{nullptr};
+	// fastest variant of each conversion at each resolution this pin has negotiated
+	std::map<std::tuple<frame_writer_strategy, int, int>, kernel_choice> mKernelChoices{};
+	kernel_calibrator mCalibrator{mLogData};
+	pixel_format mCalibratedFormat{NA};
+	int mCalibratedCx{0};
+	int mCalibratedCy{0};
+
+	/**
+	 * Picks the fastest variant of each conversion from the signalled format, saved choices are used as is while any
+	 * others are timed at the signalled resolution on the calibrator's thread. This only happens the first time a
+	 * resolution is seen on a given cpu model. Returns true if the choice for the current conversion changed.
+	 */
+	bool CalibrateConversions(const video_format& signal)
+	{
+		auto currentChanged = ApplyCalibratedKernels();
+		// one resolution is timed at a time, a change while it runs is picked up by a later frame
+		if (!mFilter->IsKernelCalibrationEnabled() || mCalibrator.IsBusy() || (signal.pixelFormat ==
+			mCalibratedFormat && signal.cx == mCalibratedCx && signal.cy == mCalibratedCy))
+		{
+			return currentChanged;
+		}
+		mCalibratedFormat = signal.pixelFormat;
+		mCalibratedCx = signal.cx;
+		mCalibratedCy = signal.cy;
+
+		auto fallbacks = mFormatFallbacks.find(signal.pixelFormat);
+		if (fallbacks == mFormatFallbacks.end())
+		{
+			return currentChanged;
+		}
+		std::vector<frame_conversion<calibration_frame>> uncalibrated;
+		for (const auto& [target, strategy] : fallbacks->second)
+		{
+			if (mKernelChoices.contains(std::make_tuple(strategy, signal.cx, signal.cy)))
+			{
+				continue;
+			}
+			kernel_choice choice;
+			if (mFilter->LoadKernelChoice(to_string(strategy), signal.cx, signal.cy, &choice))
+			{
+				currentChanged |= UseKernelChoice({strategy, signal.cx, signal.cy, choice});
+			}
+			else if (const auto conversion = conversion_registry<calibration_frame>::Instance().Find(strategy);
+				conversion && !conversion->IsLastResort())
+			{
+				uncalibrated.push_back(*conversion);
+			}
+		}
+		RankFallbacks(signal.pixelFormat, signal.cx, signal.cy);
+		if (!uncalibrated.empty())
+		{
+			mCalibrator.Start(std::move(uncalibrated), signal.cx, signal.cy, mFilter->GetConversionStripes(),
+			                  mFilter->GetConversionTileLines());
+		}
+		return currentChanged;
+	}
+
+	// saves & uses the kernels timed by the calibrator once they are all in, returns true if the current one changed
+	bool ApplyCalibratedKernels()
+	{
+		const auto results = mCalibrator.TakeResults();
+		if (!results || results->empty())
+		{
+			return false;
+		}
+		auto currentChanged = false;
+		for (const auto& kernel : *results)
+		{
+			mFilter->SaveKernelChoice(to_string(kernel.strategy), kernel.cx, kernel.cy, kernel.choice);
+			currentChanged |= UseKernelChoice(kernel);
+		}
+		RankFallbacks(mCalibratedFormat, results->front().cx, results->front().cy);
+		return currentChanged;
+	}
+
+	// returns true if this is the conversion currently in use at its resolution
+	bool UseKernelChoice(const calibrated_kernel& kernel)
+	{
+		#ifndef NO_QUILL
+		LOG_INFO(mLogData.logger, "[{}] Using {} {} {} at {}x{} ({:.3f} ns/px)", mLogData.prefix,
+		         to_string(kernel.strategy), to_string(kernel.choice.isa),
+		         kernel.choice.striped ? "striped" : "unstriped", kernel.cx, kernel.cy, kernel.choice.nsPerPixel);
+		#endif
+
+		mKernelChoices[std::make_tuple(kernel.strategy, kernel.cx, kernel.cy)] = kernel.choice;
+		return kernel.strategy == mFrameWriterStrategy && kernel.cx == mVideoFormat.cx && kernel.cy == mVideoFormat.cy;
+	}
+
+	// measured costs may reorder the fallbacks within a tier
+	void RankFallbacks(const pixel_format& signalledFormat, int cx, int cy)
+	{
+		auto fallbacks = mFormatFallbacks.find(signalledFormat);
+		if (fallbacks == mFormatFallbacks.end())
+		{
+			return;
+		}
+		const auto& registry = conversion_registry<VF>::Instance();
+		const auto rank = [&](const pixel_format_fallback& f)
+		{
+			const auto conversion = registry.Find(f.second);
+			const auto choice = mKernelChoices.find(std::make_tuple(f.second, cx, cy));
+			return std::make_pair(conversion ? conversion->Tier() : 0,
+			                      choice != mKernelChoices.end() && choice->second.nsPerPixel > 0.0
+				                      ? choice->second.nsPerPixel
+				                      : conversion ? conversion->nsPerPixel : 0.0);
+		};
+		std::ranges::stable_sort(fallbacks->second, {}, rank);
+	}
+
+	// the calibrated variant of the conversion at the current resolution, the widest instruction set if not calibrated
+	kernel_choice GetKernelChoice(frame_writer_strategy strategy) const
+	{
+		const auto choice = mKernelChoices.find(std::make_tuple(strategy, mVideoFormat.cx, mVideoFormat.cy));
+		return choice == mKernelChoices.end() ? kernel_choice{} : choice->second;
+	}
 
 	virtual void OnFrameWriterStrategyUpdated()
 	{
-		switch (mFrameWriterStrategy)
-		{
-		case YUV2_YV16:
-			mFrameWriter = std::make_unique<yuv2_yv16<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case V210_P210:
-			mFrameWriter = std::make_unique<v210_p210<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case R210_BGR48:
-			mFrameWriter = std::make_unique<r210_rgb48<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case BGR10_BGR48:
-			mFrameWriter = std::make_unique<bgr10_rgb48<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case Y210_P210:
-			mFrameWriter = std::make_unique<y210_p210<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case YUY2_YV16:
-			mFrameWriter = std::make_unique<yuy2_yv16<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		case UYVY_YV16:
-			mFrameWriter = std::make_unique<uyvy_yv16<VF>>(mLogData, mVideoFormat.cx, mVideoFormat.cy);
-			break;
-		default:
-			// ugly back to workaround inability of c++ to call pure virtual function
-			;
+		// only conversions from a format this pin can signal are reachable
+		const auto conversion = conversion_registry<VF>::Instance().Find(mFrameWriterStrategy);
+		if (conversion && !conversion->IsLastResort() && mFormatFallbacks.contains(conversion->source))
+		{
+			const auto choice = GetKernelChoice(mFrameWriterStrategy);
+			mFrameWriter = conversion->create(mLogData, mVideoFormat.cx, mVideoFormat.cy, choice.isa);
+			mFrameWriter->SetConversionPool(choice.striped ? GetConversionPool() : nullptr);
+		}
+		else
+		{
+			#ifndef NO_QUILL
+			LOG_ERROR(mLogData.logger, "[{}] Conversion strategy {} is not supported", mLogData.prefix,
+			          to_string(mFrameWriterStrategy));
+			#endif
+		}
+		ConfigureFrameWriter();
+	}
+
+	// applies the filter's options & the pin's meters to a newly created writer
+	void ConfigureFrameWriter()
+	{
+		if (mFrameWriter)
+		{
+			mFrameWriter->SetSourceMemory(mFilter->IsStreamingLoadEnabled(mDeviceType)
+				                              ? SOURCE_WRITE_COMBINED
+				                              : SOURCE_CACHED);
+			mFrameWriter->SetTileLines(mFilter->GetConversionTileLines());
+			mFrameWriter->SetLightLevelMeter(&mLightLevelMeter);
+			mFrameWriter->SetActiveAreaMeter(&mActiveAreaMeter);
+			mFrameWriter->SetPreviewSink(mPreviewSink);
 		}
 	}
 
+	// workers are created on first use and then live as long as the pin
+	conversion_pool* GetConversionPool()
+	{
+		const auto stripes = mFilter->GetConversionStripes();
+		if (stripes < 2)
+		{
+			return nullptr;
+		}
+		if (!mConversionPool)
+		{
+			bool highPriority;
+			mFilter->IsHighThreadPriorityEnabled(&highPriority);
+			mConversionPool = std::make_unique<conversion_pool>(mLogData, stripes, highPriority);
+		}
+		return mConversionPool.get();
+	}
+
 	void SetFrameWriterStrategy(const frame_writer_strategy newStrategy, const pixel_format& signalledFormat)
 	{
 		mSignalledFormat = signalledFormat;
@@ -244,12 +488,14 @@ protected:
 			auto search = mFormatFallbacks.find(newVideoFormat->pixelFormat);
 			if (search != mFormatFallbacks.end())
 			{
-				auto fallbackPixelFormat = search->second.first;
-				if (fallbackPixelFormat.format == mVideoFormat.pixelFormat.format)
+				for (const auto& fallback : search->second)
 				{
-					if (newVideoFormat->cx == mVideoFormat.cx && newVideoFormat->cy == mVideoFormat.cy)
+					if (fallback.first.format == mVideoFormat.pixelFormat.format)
 					{
-						return true;
+						if (newVideoFormat->cx == mVideoFormat.cx && newVideoFormat->cy == mVideoFormat.cy)
+						{
+							return true;
+						}
 					}
 				}
 			}
@@ -301,13 +547,123 @@ protected:
 		mFilter->GetReferenceTime(rt);
 	}
 
+	/**
+	 * True if this frame is the same as the last and need not be delivered, either because repeated frames are being
+	 * dropped or because the frame is a repeat predicted by the locked pulldown cadence.
+	 */
+	bool SkipRepeatedFrame(const uint8_t* data, long length)
+	{
+		const auto skipRepeats = mFilter->IsSkipRepeatedFramesEnabled();
+		const auto inverseTelecine = mFilter->IsInverseTelecineEnabled();
+		if (!skipRepeats && !inverseTelecine)
+		{
+			return false;
+		}
+		const auto repeat = mRepeatDetector.IsRepeat(data, length, mVideoFormat.cy);
+		auto skip = false;
+		if (inverseTelecine)
+		{
+			const auto previous = mCadence.GetCadence();
+			skip = mCadence.Push(repeat);
+			if (mCadence.GetCadence() != previous)
+			{
+				OnCadenceChanged(previous);
+			}
+		}
+		// a locked cadence delivers every new frame slot, static or not, so the output stays evenly spaced
+		if (!skip && skipRepeats && repeat && mCadence.GetCadence() == CADENCE_NONE)
+		{
+			// deliver at least 2 frames a second whatever the content
+			const auto maxRepeats = static_cast<int>(dshowTicksPerSecond / 2 / std::max<LONGLONG>(
+				mVideoFormat.frameInterval, 1));
+			skip = mRepeatDetector.GetConsecutiveRepeats() % (maxRepeats + 1) != 0;
+		}
+
+		#ifndef NO_QUILL
+		if (skip)
+		{
+			LOG_TRACE_L2(mLogData.logger, "[{}] Skipping repeat of frame {} ({} repeats seen, cadence {})",
+			             mLogData.prefix, mFrameCounter, mRepeatDetector.GetRepeatCount(),
+			             to_string(mCadence.GetCadence()));
+		}
+		#endif
+
+		return skip;
+	}
+
+	/**
+	 * The renderer is told the rate of the frames actually delivered by attaching a media type, with the new
+	 * AvgTimePerFrame, to the next sample. This is a format change the renderer has already accepted rather than a
+	 * reconnection so it neither reallocates buffers nor triggers a refresh rate switch.
+	 */
+	void OnCadenceChanged(cadence previous)
+	{
+		const auto fps = mVideoFormat.fps * 2 / mCadence.GetDurationHalfFrames();
+
+		#ifndef NO_QUILL
+		LOG_INFO(mLogData.logger, "[{}] Cadence changed from {} to {}, delivering {:.3f} fps ({} breaks)",
+		         mLogData.prefix, to_string(previous), to_string(mCadence.GetCadence()), fps,
+		         mCadence.GetBreakCount());
+		#endif
+
+		if (!m_Connected || m_mt.formattype != FORMAT_VIDEOINFO2)
+		{
+			return;
+		}
+		CMediaType mt(m_mt);
+		auto vih = reinterpret_cast<VIDEOINFOHEADER2*>(mt.pbFormat);
+		vih->AvgTimePerFrame = static_cast<REFERENCE_TIME>(static_cast<double>(dshowTicksPerSecond) / fps);
+		vih->dwBitRate = static_cast<DWORD>(mVideoFormat.imageSize * 8 * fps);
+		if (m_Connected->QueryAccept(&mt) == S_OK && SUCCEEDED(capture_pin::SetMediaType(&mt)))
+		{
+			mUpdatedMediaType = true;
+		}
+		else
+		{
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger, "[{}] Renderer did not accept AvgTimePerFrame {} for cadence {}",
+			            mLogData.prefix, vih->AvgTimePerFrame, to_string(mCadence.GetCadence()));
+			#endif
+		}
+	}
+
+	// frames delivered while a cadence is locked are evenly spaced at the rate of the original content
+	void ApplyCadence(REFERENCE_TIME* startTime, REFERENCE_TIME* endTime) const
+	{
+		if (mCadence.GetCadence() == CADENCE_NONE)
+		{
+			return;
+		}
+		const auto halfFrame = mVideoFormat.frameInterval / 2;
+		*startTime += halfFrame * mCadence.GetDelayHalfFrames();
+		*endTime = *startTime + halfFrame * mCadence.GetDurationHalfFrames();
+	}
+
 	void AppendHdrSideDataIfNecessary(IMediaSample* pms, long long endTime)
 	{
 		// Update once per second at most
 		if (endTime > mLastSentHdrMetaAt + dshowTicksPerSecond)
 		{
 			mLastSentHdrMetaAt = endTime;
-			if (mVideoFormat.hdrMeta.exists())
+
+			// many sources send no (or nonsense) content light level so fall back to that measured by the writer
+			auto hdrMeta = mVideoFormat.hdrMeta;
+			const auto measureLightLevel = hdrMeta.masteringDisplayExists() && !hdrMeta.lightLevelExists();
+			mLightLevelMeter.SetEnabled(measureLightLevel);
+			if (measureLightLevel)
+			{
+				const auto measured = mLightLevelMeter.Measure();
+				hdrMeta.maxCLL = measured.maxCLL;
+				hdrMeta.maxFALL = measured.maxFALL;
+
+				#ifndef NO_QUILL
+				LOG_TRACE_L1(mLogData.logger, "[{}] Measured MaxCLL/MaxFALL {} {} (signalled {} {})", mLogData.prefix,
+				             measured.maxCLL, measured.maxFALL, mVideoFormat.hdrMeta.maxCLL,
+				             mVideoFormat.hdrMeta.maxFALL);
+				#endif
+			}
+
+			if (hdrMeta.exists())
 			{
 				// This can fail if you have a filter behind this which does not understand side data
 				IMediaSideData* pMediaSideData = nullptr;
@@ -321,18 +677,18 @@ protected:
 					MediaSideDataHDR hdr;
 					ZeroMemory(&hdr, sizeof(hdr));
 
-					hdr.display_primaries_x[0] = mVideoFormat.hdrMeta.g_primary_x;
-					hdr.display_primaries_x[1] = mVideoFormat.hdrMeta.b_primary_x;
-					hdr.display_primaries_x[2] = mVideoFormat.hdrMeta.r_primary_x;
-					hdr.display_primaries_y[0] = mVideoFormat.hdrMeta.g_primary_y;
-					hdr.display_primaries_y[1] = mVideoFormat.hdrMeta.b_primary_y;
-					hdr.display_primaries_y[2] = mVideoFormat.hdrMeta.r_primary_y;
+					hdr.display_primaries_x[0] = hdrMeta.g_primary_x;
+					hdr.display_primaries_x[1] = hdrMeta.b_primary_x;
+					hdr.display_primaries_x[2] = hdrMeta.r_primary_x;
+					hdr.display_primaries_y[0] = hdrMeta.g_primary_y;
+					hdr.display_primaries_y[1] = hdrMeta.b_primary_y;
+					hdr.display_primaries_y[2] = hdrMeta.r_primary_y;
 
-					hdr.white_point_x = mVideoFormat.hdrMeta.whitepoint_x;
-					hdr.white_point_y = mVideoFormat.hdrMeta.whitepoint_y;
+					hdr.white_point_x = hdrMeta.whitepoint_x;
+					hdr.white_point_y = hdrMeta.whitepoint_y;
 
-					hdr.max_display_mastering_luminance = mVideoFormat.hdrMeta.maxDML;
-					hdr.min_display_mastering_luminance = mVideoFormat.hdrMeta.minDML;
+					hdr.max_display_mastering_luminance = hdrMeta.maxDML;
+					hdr.min_display_mastering_luminance = hdrMeta.minDML;
 
 					pMediaSideData->SetSideData(IID_MediaSideDataHDR, reinterpret_cast<const BYTE*>(&hdr),
 					                            sizeof(hdr));
@@ -340,8 +696,8 @@ protected:
 					MediaSideDataHDRContentLightLevel hdrLightLevel;
 					ZeroMemory(&hdrLightLevel, sizeof(hdrLightLevel));
 
-					hdrLightLevel.MaxCLL = mVideoFormat.hdrMeta.maxCLL;
-					hdrLightLevel.MaxFALL = mVideoFormat.hdrMeta.maxFALL;
+					hdrLightLevel.MaxCLL = hdrMeta.maxCLL;
+					hdrLightLevel.MaxFALL = hdrMeta.maxFALL;
 
 					pMediaSideData->SetSideData(IID_MediaSideDataHDRContentLightLevel,
 					                            reinterpret_cast<const BYTE*>(&hdrLightLevel),
@@ -381,6 +737,45 @@ protected:
 		}
 	}
 
+	/**
+	 * The active area measured by the writer is smoothed over a few seconds so it is only updated once a second, the
+	 * latest is attached to every sample so a downstream filter can crop any frame without measuring it itself.
+	 */
+	void AppendActiveAreaSideDataIfNecessary(IMediaSample* pms, long long endTime)
+	{
+		const auto enabled = mFilter->IsActiveAreaDetectionEnabled();
+		mActiveAreaMeter.SetEnabled(enabled);
+		if (!enabled)
+		{
+			return;
+		}
+		if (endTime > mLastMeasuredActiveAreaAt + dshowTicksPerSecond)
+		{
+			mLastMeasuredActiveAreaAt = endTime;
+			mActiveArea = mActiveAreaMeter.Measure();
+			mFilter->OnActiveAreaUpdated(mActiveArea);
+		}
+		if (!mActiveArea.exists())
+		{
+			return;
+		}
+		IMediaSideData* pMediaSideData = nullptr;
+		if (SUCCEEDED(pms->QueryInterface(&pMediaSideData)))
+		{
+			const MediaSideDataActiveArea area{
+				.top = mActiveArea.top,
+				.bottom = mActiveArea.bottom,
+				.left = mActiveArea.left,
+				.right = mActiveArea.right,
+				.width = mActiveArea.width,
+				.height = mActiveArea.height
+			};
+			pMediaSideData->SetSideData(IID_MediaSideDataActiveArea, reinterpret_cast<const BYTE*>(&area),
+			                            sizeof(area));
+			pMediaSideData->Release();
+		}
+	}
+
 	void LogHdrMetaIfPresent(const video_format* newVideoFormat) const
 	{
 		#ifndef NO_QUILL
@@ -396,83 +791,84 @@ protected:
 		LogHdrMetaIfPresent(&newVideoFormat);
 		#endif
 
+		// kernels are timed in the background the first time a resolution is signalled, the writer is recreated when
+		// the results change the variant of the current conversion
+		if (CalibrateConversions(newVideoFormat) && mFrameWriter)
+		{
+			OnFrameWriterStrategyUpdated();
+		}
+
 		if (ShouldChangeMediaType(&newVideoFormat, IsFallbackActive(&newVideoFormat)))
 		{
 			#ifndef NO_QUILL
 			LOG_WARNING(mLogData.logger, "[{}] VideoFormat changed! Attempting to reconnect", mLogData.prefix);
 			#endif
 
-			CMediaType proposedMediaType(m_mt);
-			VideoFormatToMediaType(&proposedMediaType, &newVideoFormat);
-
-			auto hr = DoChangeMediaType(&proposedMediaType, &newVideoFormat);
-			auto reconnected = SUCCEEDED(hr);
-			auto signalledFormat = newVideoFormat.pixelFormat;
-			if (reconnected)
+			const auto signalledFormat = newVideoFormat.pixelFormat;
+			auto hr = E_FAIL;
+			auto reconnected = false;
+			for (const auto& [pixelFormat, strategy] : OutputFormats(signalledFormat))
 			{
-				retVal = S_OK;
-				SetFrameWriterStrategy(STRAIGHT_THROUGH, signalledFormat);
-			}
-			else
-			{
-				auto search = mFormatFallbacks.find(newVideoFormat.pixelFormat);
-				if (search != mFormatFallbacks.end())
+				auto candidateVideoFormat = newVideoFormat;
+				if (strategy != STRAIGHT_THROUGH)
 				{
-					auto fallbackPixelFormat = search->second.first;
-
 					#ifndef NO_QUILL
-					LOG_WARNING(mLogData.logger,
-					            "[{}] VideoFormat changed but not able to reconnect! [Result: {:#08x}] Attempting fallback format {}",
-					            mLogData.prefix, static_cast<unsigned long>(hr), fallbackPixelFormat.name);
+					const auto conversion = conversion_registry<VF>::Instance().Find(strategy);
+					LOG_WARNING(mLogData.logger, "[{}] Attempting format {} converted by {} ({:.2f} ns/px)",
+					            mLogData.prefix, pixelFormat.name, to_string(strategy),
+					            conversion ? conversion->nsPerPixel : 0.0);
 					#endif
 
-					auto fallbackVideoFormat = std::move(newVideoFormat);
-					fallbackVideoFormat.pixelFormat = std::move(fallbackPixelFormat);
-					fallbackVideoFormat.CalculateDimensions();
+					candidateVideoFormat.pixelFormat = pixelFormat;
+					candidateVideoFormat.CalculateDimensions();
+				}
 
-					CMediaType fallbackMediaType(m_mt);
-					VideoFormatToMediaType(&fallbackMediaType, &fallbackVideoFormat);
+				CMediaType proposedMediaType(m_mt);
+				VideoFormatToMediaType(&proposedMediaType, &candidateVideoFormat);
 
-					hr = DoChangeMediaType(&fallbackMediaType, &fallbackVideoFormat);
-					reconnected = SUCCEEDED(hr);
-					if (reconnected)
+				hr = DoChangeMediaType(&proposedMediaType, &candidateVideoFormat);
+				reconnected = SUCCEEDED(hr);
+				if (reconnected)
+				{
+					#ifndef NO_QUILL
+					if (strategy != STRAIGHT_THROUGH)
 					{
-						auto strategy = search->second.second;
-
-						#ifndef NO_QUILL
 						LOG_WARNING(mLogData.logger,
-						            "[{}] VideoFormat changed and fallback format {} required to reconnect, updating frame conversion strategy to {}",
-						            mLogData.prefix, fallbackVideoFormat.pixelFormat.name, to_string(strategy));
-						#endif
-
-						SetFrameWriterStrategy(search->second.second, signalledFormat);
-
-						retVal = S_OK;
+						            "[{}] VideoFormat changed and format {} accepted, updating frame conversion strategy to {}",
+						            mLogData.prefix, pixelFormat.name, to_string(strategy));
 					}
-					else
-					{
-						#ifndef NO_QUILL
-						LOG_WARNING(mLogData.logger,
-						            "[{}] VideoFormat changed but fallback format also not able to reconnect! Will retry after backoff [Result: {:#08x}]",
-						            mLogData.prefix, static_cast<unsigned long>(hr),
-						            fallbackVideoFormat.pixelFormat.name);
-						#endif
+					#endif
 
-						retVal = E_FAIL;
-					}
+					SetFrameWriterStrategy(strategy, signalledFormat);
+					retVal = S_OK;
+					break;
 				}
-				else
-				{
-					#ifndef NO_QUILL
-					LOG_ERROR(mLogData.logger,
-					          "[{}] VideoFormat changed but not able to reconnect! Will retry after backoff [Result: {:#08x}]",
-					          mLogData.prefix, static_cast<unsigned long>(hr));
-					#endif
 
-					retVal = E_FAIL;
+				#ifndef NO_QUILL
+				LOG_WARNING(mLogData.logger, "[{}] VideoFormat changed but format {} not accepted [Result: {:#08x}]",
+				            mLogData.prefix, pixelFormat.name, static_cast<unsigned long>(hr));
+				#endif
+			}
+			if (!reconnected)
+			{
+				#ifndef NO_QUILL
+				LOG_ERROR(mLogData.logger,
+				          "[{}] VideoFormat changed but not able to reconnect! Will retry after backoff [Result: {:#08x}]",
+				          mLogData.prefix, static_cast<unsigned long>(hr));
+				#endif
+
+				retVal = E_FAIL;
+			}
+			if (reconnected)
+			{
+				// the new media type has the signalled frame rate
+				mCadence.Reset();
+				if (mPreviewSink)
+				{
+					mPreviewSink->SetVideoFormat(mVideoFormat);
 				}
+				mFilter->OnVideoFormatLoaded(&mVideoFormat);
 			}
-			if (reconnected) mFilter->OnVideoFormatLoaded(&mVideoFormat);
 		}
 		return retVal;
 	}
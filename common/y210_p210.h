@@ -26,8 +26,16 @@ template <typename VF>
 class y210_p210 : public IVideoFrameWriter<VF>
 {
 public:
-	y210_p210(const log_data& pLogData, int pX, int pY) : IVideoFrameWriter<VF>(pLogData, pX, pY, &P210)
+	y210_p210(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &P210)
 	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("Y210 to P210");
 	}
 
 	~y210_p210() override = default;
@@ -59,14 +67,29 @@ public:
 		uint8_t* yPlane = outSpan.subspan(0, planeSize).data();
 		uint8_t* uvPlane = outSpan.subspan(planeSize, planeSize).data();
 
-		auto alignedWidth = (width + 47) / 48 * 48;
-		auto srcStride = alignedWidth * 8 / 3;
+		// 2 pixels per 64 bits
+		auto srcStride = width * 4;
 
 		#ifndef NO_QUILL
 		const quill::StopWatchTsc swt;
 		#endif
 
-		this->convert(sourceData, srcStride, yPlane, uvPlane, width, height, this->mPixelsToPad);
+		const auto dstStride = actualWidth * 2;
+		const output_plane planes[]{{yPlane, dstStride}, {uvPlane, dstStride}};
+		light_level_frame lightLevel;
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(&lightLevel, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint16_t>(measures, dst[0], dstStride, width, firstLine, lineCount,
+			                                         [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * dstStride,
+				         dst[1] + line * dstStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
 
 		#ifndef NO_QUILL
 		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
@@ -80,42 +103,71 @@ public:
 	}
 
 private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad);
+
 	// same as yuy2 but each individual value occupies 16 bits
-	#ifdef __AVX2__
-	bool convert(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height, int pixelsToPad)
+	static void convert_line_scalar(const uint16_t* srcLine, uint16_t* dstLineY, uint16_t* dstLineUV, int x, int width)
+	{
+		srcLine += x * 2;
+		dstLineY += x;
+		dstLineUV += x;
+		for (; x < width; x += 2) // 2 pixels per pass
+		{
+			dstLineY[0] = srcLine[0];
+			dstLineY[1] = srcLine[2];
+			dstLineUV[0] = srcLine[1];
+			dstLineUV[1] = srcLine[3];
+
+			dstLineY += 2;
+			dstLineUV += 2;
+			srcLine += 4;
+		}
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                         int pixelsToPad)
 	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, dstY, dstUV, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
 		const __m256i shuffle_1 = _mm256_setr_epi8(
 			2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9, 12, 13,
 			2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9, 12, 13
 		);
 		const __m256i permute = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
-		const int yWidth = width + pixelsToPad;
-		const int uvWidth = yWidth / 2;
 		const int effectiveWidth = width + pixelsToPad;
+		const int simdWidth = width & ~7;
 
 		for (int lineNo = 0; lineNo < height; ++lineNo)
 		{
-			const uint32_t* srcLine = reinterpret_cast<const uint32_t*>(src + lineNo * srcStride);
+			const uint16_t* srcLine = reinterpret_cast<const uint16_t*>(src + lineNo * srcStride);
 			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + lineNo * effectiveWidth * 2);
 			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + lineNo * effectiveWidth * 2);
 
-			for (int x = 0; x < width; x += 8) // 32 bits per pixel in 256 bit chunks = 8 pixels per pass
+			for (int x = 0; x < simdWidth; x += 8) // 32 bits per pixel in 256 bit chunks = 8 pixels per pass
 			{
-				__m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+				__m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x * 2));
 				__m256i shuffled = _mm256_shuffle_epi8(pixels, shuffle_1);
+				// 8 UV samples in the lower lane, 8 Y samples in the upper lane
 				__m256i permuted = _mm256_permutevar8x32_epi32(shuffled, permute);
-				_mm256_storeu2_m128i(reinterpret_cast<__m128i*>(dstLineY), reinterpret_cast<__m128i*>(dstLineUV), permuted);
-				// 32 bytes read
-				dstLineUV += 16;
-				dstLineY += 16;
-				src += 32; 
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dstLineUV + x), _mm256_castsi256_si128(permuted));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dstLineY + x), _mm256_extracti128_si256(permuted, 1));
 			}
+			convert_line_scalar(srcLine, dstLineY, dstLineUV, simdWidth, width);
 		}
 		return true;
 	}
-	#else
-	bool convert(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
-	             int pixelsToPad)
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* dstY, uint8_t* dstUV, int width, int height,
+	                           int pixelsToPad)
 	{
 		auto effectiveWidth = width + pixelsToPad;
 
@@ -124,21 +176,11 @@ private:
 			const uint16_t* srcLine = reinterpret_cast<const uint16_t*>(src + y * srcStride);
 			uint16_t* dstLineY = reinterpret_cast<uint16_t*>(dstY + y * effectiveWidth * 2);
 			uint16_t* dstLineUV = reinterpret_cast<uint16_t*>(dstUV + y * effectiveWidth * 2);
-
-			for (int x = 0; x < width; x += 2) // 2 pixels per pass
-			{
-				dstLineY[0] = srcLine[0];
-				dstLineY[1] = srcLine[2];
-				dstLineUV[0] = srcLine[1];
-				dstLineUV[1] = srcLine[3];
-
-				dstLineY += 2;
-				dstLineUV += 2;
-				src += 4;
-			}
+			convert_line_scalar(srcLine, dstLineY, dstLineUV, 0, width);
 		}
 		return true;
 	}
-	#endif
+
+	convert_fn mConvert{convert_scalar};
 };
 #endif
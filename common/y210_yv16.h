@@ -0,0 +1,194 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef Y210_YV16_HEADER
+#define Y210_YV16_HEADER
+
+#include "VideoFrameWriter.h"
+#include "dither.h"
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+/**
+ * Y210 is YUY2 with 16-bit samples, the samples are dithered to 8-bit (see dither.h) which leaves YUY2 to split into
+ * planes as per yuy2_yv16.
+ */
+template <typename VF>
+class y210_yv16 : public IVideoFrameWriter<VF>
+{
+public:
+	y210_yv16(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &YV16)
+	{
+		if (pMaxIsa >= ISA_AVX2 && GetCpuFeatures().Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2;
+			this->mIsa = ISA_AVX2;
+		}
+		this->LogKernel("Y210 to YV16 (dithered)");
+	}
+
+	~y210_yv16() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		const auto actualWidth = width + this->mPixelsToPad;
+		const auto pixelCount = actualWidth * height;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		auto ySize = pixelCount;
+		auto uvSize = pixelCount / 2;
+
+		auto outSpan = std::span(outData, dstSize);
+		uint8_t* yPlane = outSpan.subspan(0, ySize).data();
+		uint8_t* vPlane = outSpan.subspan(ySize, uvSize).data();
+		uint8_t* uPlane = outSpan.subspan(ySize + uvSize, uvSize).data();
+
+		// 2 pixels per 64 bits
+		const int srcStride = width * 4;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		// stripes start on an even line so the dither pattern lines up across them
+		const int uvStride = actualWidth / 2;
+		const output_plane planes[]{{yPlane, actualWidth}, {uPlane, uvStride}, {vPlane, uvStride}};
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(nullptr, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint8_t>(measures, dst[0], actualWidth, width, firstLine, lineCount,
+			                                        [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * actualWidth,
+				         dst[1] + line * uvStride, dst[2] + line * uvStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to YV16 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           int width, int height, int pixelsToPad);
+
+	// y - u - y - v
+	static void convert_line_scalar(const uint16_t* src, uint8_t* yOut, uint8_t* uOut, uint8_t* vOut, int lineNo,
+	                                int x, int width)
+	{
+		const auto t0 = dither::threshold(lineNo, 0);
+		const auto t1 = dither::threshold(lineNo, 1);
+		for (; x < width; x += 2) // 2 pixels per pass
+		{
+			const auto column = x / 2;
+			const auto tUV = dither::threshold(lineNo, column);
+			yOut[x] = dither::to_8bit(src[x * 2], t0);
+			uOut[column] = dither::to_8bit(src[x * 2 + 1], tUV);
+			yOut[x + 1] = dither::to_8bit(src[x * 2 + 2], t1);
+			vOut[column] = dither::to_8bit(src[x * 2 + 3], tUV);
+		}
+	}
+
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                         int width, int height, int pixelsToPad)
+	{
+		// as per yuy2_yv16::convert_avx2
+		const __m256i shuffle_1 = _mm256_setr_epi8(
+			3, 7, 11, 15, 1, 5, 9, 13, 0, 2, 4, 6, 8, 10, 12, 14,
+			3, 7, 11, 15, 1, 5, 9, 13, 0, 2, 4, 6, 8, 10, 12, 14
+		);
+		const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 3, 6, 7);
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = yWidth / 2;
+		const int simdWidth = width & ~15;
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			const uint16_t* srcLine = reinterpret_cast<const uint16_t*>(src + lineNo * srcStride);
+			uint8_t* y_out = yPlane + lineNo * yWidth;
+			uint8_t* u_out = uPlane + lineNo * uvWidth;
+			uint8_t* v_out = vPlane + lineNo * uvWidth;
+
+			// Y0 U Y1 V for an even then an odd chroma column
+			const short t0 = static_cast<short>(dither::threshold(lineNo, 0));
+			const short t1 = static_cast<short>(dither::threshold(lineNo, 1));
+			const __m256i thresholds = _mm256_setr_epi16(t0, t0, t1, t0, t0, t1, t1, t1,
+			                                             t0, t0, t1, t0, t0, t1, t1, t1);
+
+			for (int x = 0; x < simdWidth; x += 16) // 2 x 8 pixels per pass
+			{
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x * 2));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x * 2 + 16));
+				const __m256i packed = _mm256_packus_epi16(dither::to_8bit_avx2(a, thresholds),
+				                                           dither::to_8bit_avx2(b, thresholds));
+				// 16 pixels of 8-bit YUY2
+				const __m256i pixels = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+				__m256i shuffled = _mm256_shuffle_epi8(pixels, shuffle_1);
+				__m256i permuted = _mm256_permutevar8x32_epi32(shuffled, permute);
+
+				// 8 bytes each of VU in the lower lane, 16 bytes of Y in the upper lane
+				__m128i vu = _mm256_castsi256_si128(permuted);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(v_out + x / 2), vu);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(u_out + x / 2), _mm_unpackhi_epi64(vu, vu));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(y_out + x), _mm256_extracti128_si256(permuted, 1));
+			}
+			convert_line_scalar(srcLine, y_out, u_out, v_out, lineNo, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           int width, int height, int pixelsToPad)
+	{
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = yWidth / 2;
+		for (int lineNo = 0; lineNo < height; ++lineNo)
+		{
+			convert_line_scalar(reinterpret_cast<const uint16_t*>(src + lineNo * srcStride), yPlane + lineNo * yWidth,
+			                    uPlane + lineNo * uvWidth, vPlane + lineNo * uvWidth, lineNo, 0, width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
@@ -0,0 +1,225 @@
+/*
+ *      Copyright (C) 2025 Matt Khan
+ *      https://github.com/3ll3d00d/ezcapture
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of
+ * the GNU General Public License as published by the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program.
+ * If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef YUV2_YV16_HEADER
+#define YUV2_YV16_HEADER
+
+#include "VideoFrameWriter.h"
+#include <span>
+
+#ifndef NO_QUILL
+#include <quill/StopWatch.h>
+#endif
+
+template <typename VF>
+class yuv2_yv16 : public IVideoFrameWriter<VF>
+{
+public:
+	yuv2_yv16(const log_data& pLogData, int pX, int pY, cpu_isa pMaxIsa = GetCpuFeatures().Best()) :
+		IVideoFrameWriter<VF>(pLogData, pX, pY, &YV16)
+	{
+		const auto& cpu = GetCpuFeatures();
+		if (pMaxIsa >= ISA_AVX2 && cpu.Supports(ISA_AVX2))
+		{
+			mConvert = convert_avx2<>;
+			this->SpecialiseForWidth(pX, mConvert, []<int W>() { return &convert_avx2<W>; });
+			this->mIsa = ISA_AVX2;
+		}
+		else if (pMaxIsa >= ISA_SSSE3 && cpu.Supports(ISA_SSSE3))
+		{
+			mConvert = convert_ssse3;
+			this->mIsa = ISA_SSSE3;
+		}
+		this->LogKernel("YUV2 to YV16");
+	}
+
+	~yuv2_yv16() override = default;
+
+	HRESULT WriteTo(VF* srcFrame, IMediaSample* dstFrame) override
+	{
+		const auto width = srcFrame->GetWidth();
+		const auto height = srcFrame->GetHeight();
+
+		auto hr = this->DetectPadding(srcFrame->GetFrameIndex(), width, dstFrame);
+		if (S_FALSE == hr)
+		{
+			return S_FALSE;
+		}
+		const auto actualWidth = width + this->mPixelsToPad;
+		const auto pixelCount = actualWidth * height;
+
+		void* d;
+		srcFrame->Start(&d);
+		const uint8_t* sourceData = static_cast<const uint8_t*>(d);
+
+		BYTE* outData;
+		dstFrame->GetPointer(&outData);
+		auto dstSize = dstFrame->GetSize();
+
+		// YV16 format: 
+		auto ySize = pixelCount;
+		auto uvSize = pixelCount / 2;
+
+		auto outSpan = std::span(outData, dstSize);
+		uint8_t* yPlane = outSpan.subspan(0, ySize).data();
+		uint8_t* vPlane = outSpan.subspan(ySize, uvSize).data();
+		uint8_t* uPlane = outSpan.subspan(ySize + uvSize, uvSize).data();
+
+		const int srcStride = width * 2;
+
+		#ifndef NO_QUILL
+		const quill::StopWatchTsc swt;
+		#endif
+
+		const int uvStride = actualWidth / 2;
+		const output_plane planes[]{{yPlane, actualWidth}, {uPlane, uvStride}, {vPlane, uvStride}};
+		active_area_frame activeArea;
+		const auto measures = this->StartMeasuring(nullptr, &activeArea);
+		this->ConvertPlanes(sourceData, srcStride, height, planes, [&](const uint8_t* srcLines, int firstLine,
+		                                                               int lineCount, uint8_t* const* dst)
+		{
+			this->template ConvertMeasured<uint8_t>(measures, dst[0], actualWidth, width, firstLine, lineCount,
+			                                        [&](int line, int lines)
+			{
+				mConvert(srcLines + line * srcStride, srcStride, dst[0] + line * actualWidth,
+				         dst[1] + line * uvStride, dst[2] + line * uvStride, width, lines, this->mPixelsToPad);
+			});
+		});
+		this->EndMeasuring(measures, width, height);
+
+		#ifndef NO_QUILL
+		auto execTime = swt.elapsed_as<std::chrono::microseconds>().count() / 1000.0;
+		LOG_TRACE_L3(this->mLogData.logger, "[{}] Converted frame to YV16 in {:.3f} ms", this->mLogData.prefix, execTime);
+		#endif
+
+		srcFrame->End();
+
+		return S_OK;
+	}
+
+private:
+	using convert_fn = bool(*)(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           int width, int height, int pixelsToPad);
+
+	// same as yuy2 but v - u order is reverted
+	// u - y - v - y
+	static void convert_line_scalar(const uint8_t* src, uint8_t* yOut, uint8_t* uOut, uint8_t* vOut, int x, int width)
+	{
+		src += x * 2;
+		yOut += x;
+		uOut += x / 2;
+		vOut += x / 2;
+		for (; x < width; x += 2) // 2 pixels per pass
+		{
+			uOut[0] = src[0];
+			yOut[0] = src[1];
+			vOut[0] = src[2];
+			yOut[1] = src[3];
+
+			yOut += 2;
+			uOut++;
+			vOut++;
+			src += 4;
+		}
+	}
+
+	template <int FixedWidth = 0>
+	EZ_TARGET_AVX2
+	static bool convert_avx2(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                         int width, int height, int pixelsToPad)
+	{
+		if constexpr (FixedWidth != 0)
+		{
+			if (width != FixedWidth)
+			{
+				return convert_avx2<>(src, srcStride, yPlane, uPlane, vPlane, width, height, pixelsToPad);
+			}
+			width = FixedWidth;
+		}
+		const __m256i shuffle_1 = _mm256_setr_epi8(
+			2, 6, 10, 14, 0, 4, 8, 12, 1, 3, 5, 7, 9, 11, 13, 15,
+			2, 6, 10, 14, 0, 4, 8, 12, 1, 3, 5, 7, 9, 11, 13, 15
+		);
+		const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 3, 6, 7);
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = yWidth / 2;
+		const int simdWidth = width & ~15;
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* srcLine = src + y * srcStride;
+			uint8_t* y_out = yPlane + y * yWidth;
+			uint8_t* u_out = uPlane + y * uvWidth;
+			uint8_t* v_out = vPlane + y * uvWidth;
+			for (int x = 0; x < simdWidth; x += 16) // 16 bits per pixel in 256 bit chunks = 16 pixels per pass
+			{
+				__m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcLine + x * 2));
+				__m256i shuffled = _mm256_shuffle_epi8(pixels, shuffle_1);
+				__m256i permuted = _mm256_permutevar8x32_epi32(shuffled, permute);
+
+				// 8 bytes each of VU in the lower lane, 16 bytes of Y in the upper lane
+				__m128i vu = _mm256_castsi256_si128(permuted);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(v_out + x / 2), vu);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(u_out + x / 2), _mm_unpackhi_epi64(vu, vu));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(y_out + x), _mm256_extracti128_si256(permuted, 1));
+			}
+			convert_line_scalar(srcLine, y_out, u_out, v_out, simdWidth, width);
+		}
+		return true;
+	}
+
+	EZ_TARGET_SSSE3
+	static bool convert_ssse3(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                          int width, int height, int pixelsToPad)
+	{
+		const __m128i shuffle_1 = _mm_setr_epi8(2, 6, 10, 14, 0, 4, 8, 12, 1, 3, 5, 7, 9, 11, 13, 15);
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = yWidth / 2;
+		const int simdWidth = width & ~15;
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* srcLine = src + y * srcStride;
+			uint8_t* y_out = yPlane + y * yWidth;
+			uint8_t* u_out = uPlane + y * uvWidth;
+			uint8_t* v_out = vPlane + y * uvWidth;
+			for (int x = 0; x < simdWidth; x += 16) // 2 x 128 bit chunks = 16 pixels per pass
+			{
+				// each chunk shuffles to 4 bytes of V, 4 bytes of U then 8 bytes of Y
+				__m128i a = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcLine + x * 2)), shuffle_1);
+				__m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcLine + x * 2 + 16)), shuffle_1);
+				__m128i vu = _mm_unpacklo_epi32(a, b);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(v_out + x / 2), vu);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(u_out + x / 2), _mm_unpackhi_epi64(vu, vu));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(y_out + x), _mm_unpackhi_epi64(a, b));
+			}
+			convert_line_scalar(srcLine, y_out, u_out, v_out, simdWidth, width);
+		}
+		return true;
+	}
+
+	static bool convert_scalar(const uint8_t* src, int srcStride, uint8_t* yPlane, uint8_t* uPlane, uint8_t* vPlane,
+	                           int width, int height, int pixelsToPad)
+	{
+		const int yWidth = width + pixelsToPad;
+		const int uvWidth = yWidth / 2;
+		for (int y = 0; y < height; ++y)
+		{
+			convert_line_scalar(src + y * srcStride, yPlane + y * yWidth, uPlane + y * uvWidth, vPlane + y * uvWidth, 0,
+			                    width);
+		}
+		return true;
+	}
+
+	convert_fn mConvert{convert_scalar};
+};
+#endif
@@ -21,6 +21,7 @@
 #include "mw_capture_filter.h"
 #include "mw_video_capture_pin.h"
 #include "mw_audio_capture_pin.h"
+#include "preview_video_pin.h"
 
 #define REG_KEY_BASE L"MWCapture"
 
@@ -214,10 +215,15 @@ magewell_capture_filter::magewell_capture_filter(LPUNKNOWN punk, HRESULT* phr) :
 
 	mClock = new MWReferenceClock(phr, mDeviceInfo.hChannel, mDeviceInfo.deviceType == MW_PRO);
 
-	auto vp = new magewell_video_capture_pin(phr, this, false);
-	vp->UpdateFrameWriterStrategy();
-	vp = new magewell_video_capture_pin(phr, this, true);
+	const auto cp = new magewell_video_capture_pin(phr, this, false);
+	cp->UpdateFrameWriterStrategy();
+	const auto vp = new magewell_video_capture_pin(phr, this, true);
 	vp->UpdateFrameWriterStrategy();
+	if (GetPreviewScale())
+	{
+		const auto pp = new preview_video_pin(phr, this, GetPreviewScale(), GetDeviceType());
+		cp->SetPreviewSink(pp->GetSink());
+	}
 
 	if (mAudioCaptureEnabled)
 	{
@@ -20,8 +20,32 @@
 
 #include "mw_video_capture_pin.h"
 #include "straight_through.h"
+#include "cpu_features.h"
+#include "frame_copy.h"
 #include <memory>
 
+namespace
+{
+	// in place byteswap of each 32bit word in 256 bit chunks, returns the number of words swapped
+	EZ_TARGET_AVX2
+	uint32_t byteswap_avx2(BYTE* data, uint32_t size)
+	{
+		const __m256i pixelEndianSwap = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+		);
+		const uint32_t chunks = size / 32;
+		__m256i* chunkToProcess = reinterpret_cast<__m256i*>(data);
+		for (uint32_t i = 0; i < chunks; ++i)
+		{
+			__m256i swapped = _mm256_shuffle_epi8(_mm256_loadu_si256(chunkToProcess), pixelEndianSwap);
+			_mm256_storeu_si256(chunkToProcess, swapped);
+			chunkToProcess++;
+		}
+		return chunks * 8;
+	}
+}
+
 magewell_video_capture_pin::video_capture::video_capture(magewell_video_capture_pin* pin, HCHANNEL hChannel) :
 	pin(pin),
 	mLogData(pin->mLogData)
@@ -115,6 +139,7 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 {
 	auto retVal = S_OK;
 	auto hasFrame = false;
+	auto repeated = false;
 	auto proDevice = deviceType == MW_PRO;
 	auto mustExit = false;
 	int64_t now;
@@ -253,16 +278,22 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 				pin->mFrameTs.snap(now, READ);
 				pin->mFrameCounter++;
 
-				if (pin->mFrameWriterStrategy != STRAIGHT_THROUGH)
+				// a repeat is dropped before it is converted
+				repeated = pin->SkipRepeatedFrame(
+					pin->mFrameWriterStrategy == STRAIGHT_THROUGH ? pmsData : pin->mCapturedFrame.data,
+					pin->mVideoFormat.imageSize);
+				if (!repeated)
 				{
+					// a straight through frame is already in the sample so the writer only measures it
 					video_sample_buffer buffer{
 						.index = pin->mFrameCounter,
-						.data = pin->mCapturedFrame.data,
+						.data = pin->mFrameWriterStrategy == STRAIGHT_THROUGH ? pmsData : pin->mCapturedFrame.data,
 						.width = pin->mVideoFormat.cx,
 						.height = pin->mVideoFormat.cy,
 						.length = pin->mVideoFormat.imageSize
 					};
 					pin->mFrameWriter->WriteTo(&buffer, pms);
+					pin->PreviewDelivered(pms);
 				}
 			}
 		}
@@ -282,11 +313,11 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 				#endif
 				BACKOFF;
 			}
-			else if (pin->mFrameWriterStrategy == STRAIGHT_THROUGH)
+			else if (pin->SkipRepeatedFrame(pin->mCapturedFrame.data,
+			                                 static_cast<long>(pin->mCapturedFrame.length)))
 			{
-				memcpy(pmsData, pin->mCapturedFrame.data, pin->mCapturedFrame.length);
 				hasFrame = true;
-				pin->mFrameTs.snap(now, READ);
+				repeated = true;
 				pin->mFrameCounter++;
 			}
 			else
@@ -299,12 +330,20 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 					.length = pin->mCapturedFrame.length
 				};
 				pin->mFrameWriter->WriteTo(&buffer, pms);
+				pin->PreviewDelivered(pms);
 				hasFrame = true;
 				pin->mFrameTs.snap(now, READ);
 				pin->mFrameCounter++;
 			}
 		}
 	}
+	if (repeated)
+	{
+		// the next frame delivered follows on from this one rather than being a discontinuity
+		pin->mPreviousFrameTime = pin->mCurrentFrameTime;
+		pin->mCurrentFrameTime = pin->mFrameTs.get(BUFFERING);
+		return S_REPEATED_FRAME;
+	}
 	if (hasFrame)
 	{
 		// in place byteswap so no need for frame conversion buffer
@@ -312,21 +351,10 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 		{
 			// endianness is wrong on a per pixel basis
 			uint32_t sampleIdx = 0;
-			#ifdef __AVX__
-			__m256i pixelEndianSwap = _mm256_set_epi8(
-				12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
-				12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
-			);
-			const uint32_t chunks = pin->mVideoFormat.imageSize / 32;
-			__m256i* chunkToProcess = reinterpret_cast<__m256i*>(pmsData);
-			for (uint32_t i = 0; i < chunks; ++i)
+			if (GetCpuFeatures().Supports(ISA_AVX2))
 			{
-				__m256i swapped = _mm256_shuffle_epi8(_mm256_loadu_si256(chunkToProcess), pixelEndianSwap);
-				_mm256_storeu_si256(chunkToProcess, swapped);
-				sampleIdx += 8;
-				chunkToProcess++;
+				sampleIdx = byteswap_avx2(pmsData, pin->mVideoFormat.imageSize);
 			}
-			#endif
 			uint32_t* sampleToProcess = reinterpret_cast<uint32_t*>(pmsData);
 			const uint32_t sz = pin->mVideoFormat.imageSize / 4;
 			for (; sampleIdx < sz; sampleIdx++)
@@ -343,6 +371,7 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 		auto endTime = pin->mCurrentFrameTime;
 		auto startTime = endTime - pin->mVideoFormat.frameInterval;
 		auto missedFrame = (pin->mCurrentFrameTime - pin->mPreviousFrameTime) >= (pin->mVideoFormat.frameInterval * 2);
+		pin->ApplyCadence(&startTime, &endTime);
 
 		pms->SetTime(&startTime, &endTime);
 		pms->SetSyncPoint(TRUE);
@@ -357,6 +386,7 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 			pin->mUpdatedMediaType = false;
 		}
 		pin->AppendHdrSideDataIfNecessary(pms, endTime);
+		pin->AppendActiveAreaSideDataIfNecessary(pms, endTime);
 		pin->RecordLatency();
 		pin->SnapTemperatureIfNecessary(endTime);
 
@@ -441,6 +471,8 @@ HRESULT magewell_video_capture_pin::video_frame_grabber::grab() const
 //////////////////////////////////////////////////////////////////////////
 // magewell_video_capture_pin
 //////////////////////////////////////////////////////////////////////////
+static const std::vector<pixel_format> convertibleFormats{UYVY, YUY2, Y210, BGR10, P210};
+
 magewell_video_capture_pin::magewell_video_capture_pin(HRESULT* phr, magewell_capture_filter* pParent, bool pPreview) :
 	hdmi_video_capture_pin(
 		phr,
@@ -449,12 +481,8 @@ magewell_video_capture_pin::magewell_video_capture_pin(HRESULT* phr, magewell_ca
 		pPreview ? L"Preview" : L"Capture",
 		pPreview ? "VideoPreview" : "VideoCapture",
 		video_format{},
-		{
-			{UYVY, {YV16, UYVY_YV16}},
-			{YUY2, {YV16, YUY2_YV16}},
-			{Y210, {P210, Y210_P210}},
-			{BGR10, {RGB48, BGR10_BGR48}},
-		},
+		conversion_registry<video_sample_buffer>::Instance().Fallbacks(convertibleFormats,
+		                                                               pParent->IsDitherTo8BitEnabled()),
 		pParent->GetDeviceType()
 	),
 	mNotify(nullptr),
@@ -603,6 +631,8 @@ void magewell_video_capture_pin::DoThreadDestroy()
 	{
 		CloseHandle(mCaptureEvent);
 	}
+	// the renderer keeps the negotiated media type across a restart so the no signal frame is still delivered in it
+	mNoSignalFrames.Clear();
 }
 
 void magewell_video_capture_pin::LoadFormat(video_format* videoFormat, video_signal* videoSignal,
@@ -629,7 +659,8 @@ void magewell_video_capture_pin::LoadFormat(video_format* videoFormat, video_sig
 	}
 	else
 	{
-		// invalid/no signal is 720x480 RGB 4:4:4 image 
+		// invalid/no signal is 720x480 RGB 4:4:4 image, only used until a signal has been negotiated as after that
+		// the negotiated format is kept and a pre-rendered no signal frame is delivered in that format instead
 		videoFormat->cx = 720;
 		videoFormat->cy = 480;
 		videoFormat->quantisation = QUANTISATION_FULL;
@@ -841,14 +872,7 @@ void magewell_video_capture_pin::OnFrameWriterStrategyUpdated()
 	case STRAIGHT_THROUGH:
 		mFrameWriter = std::make_unique<straight_through>(mLogData, mVideoFormat.cx, mVideoFormat.cy,
 		                                                  &mVideoFormat.pixelFormat);
-		break;
-	case ANY_RGB:
-	case YUV2_YV16:
-	case R210_BGR48:
-		#ifndef NO_QUILL
-		LOG_ERROR(mLogData.logger, "[{}] Conversion strategy {} is not supported by mwcapture",
-		          mLogData.prefix, to_string(mFrameWriterStrategy));
-		#endif
+		ConfigureFrameWriter();
 		break;
 	default:
 		hdmi_video_capture_pin::OnFrameWriterStrategyUpdated();
@@ -976,12 +1000,28 @@ HRESULT magewell_video_capture_pin::GetDeliveryBuffer(IMediaSample** ppSample, R
 			mHasSignal = false;
 		}
 
-		video_format newVideoFormat;
-		LoadFormat(&newVideoFormat, &mVideoSignal, &mUsbCaptureFormats);
+		// the negotiated format is kept while there is no signal so the renderer stays in the same mode
+		HRESULT onSignalResult = S_RECONNECTION_UNNECESSARY;
+		auto shouldResizeMetrics = false;
+		if (mHasSignal)
+		{
+			video_format newVideoFormat;
+			LoadFormat(&newVideoFormat, &mVideoSignal, &mUsbCaptureFormats);
+
+			shouldResizeMetrics = newVideoFormat.frameInterval != mVideoFormat.frameInterval;
 
-		auto shouldResizeMetrics = newVideoFormat.frameInterval != mVideoFormat.frameInterval;
+			onSignalResult = OnVideoSignal(newVideoFormat);
+			if (onSignalResult == S_OK || (SUCCEEDED(onSignalResult) && !mSignalNegotiated))
+			{
+				mSignalNegotiated = true;
+				mNoSignalFrames.Prepare(mVideoFormat);
+			}
+		}
 
-		auto onSignalResult = OnVideoSignal(newVideoFormat);
+		if (hadSignal && !mHasSignal && mFrameWriter)
+		{
+			mNoSignalPixelsToPad = mFrameWriter->GetPixelsToPad();
+		}
 
 		if (onSignalResult != S_RECONNECTION_UNNECESSARY || (hadSignal && !mHasSignal))
 		{
@@ -1165,6 +1205,17 @@ HRESULT magewell_video_capture_pin::GetDeliveryBuffer(IMediaSample** ppSample, R
 
 HRESULT magewell_video_capture_pin::FillBuffer(IMediaSample* pms)
 {
+	const auto* noSignalFrame = mHasSignal || !mSignalNegotiated ? nullptr : mNoSignalFrames.Get(mVideoFormat);
+	if (noSignalFrame)
+	{
+		auto retVal = DeliverNoSignalFrame(pms, noSignalFrame);
+		if (S_FALSE == HandleStreamStateChange(pms))
+		{
+			retVal = S_FALSE;
+		}
+		return retVal;
+	}
+
 	video_frame_grabber vfg(this, mFilter->GetChannelHandle(), mFilter->GetDeviceType(), pms);
 	auto retVal = vfg.grab();
 	if (S_FALSE == HandleStreamStateChange(pms))
@@ -1174,6 +1225,63 @@ HRESULT magewell_video_capture_pin::FillBuffer(IMediaSample* pms)
 	return retVal;
 }
 
+HRESULT magewell_video_capture_pin::DeliverNoSignalFrame(IMediaSample* pms, const uint8_t* frame)
+{
+	// as for the frame writers, the renderer attaches a media type to the sample when it wants lines padded
+	AM_MEDIA_TYPE* sampleMt = nullptr;
+	if (S_OK == pms->GetMediaType(&sampleMt) && sampleMt)
+	{
+		const auto header = reinterpret_cast<VIDEOINFOHEADER2*>(sampleMt->pbFormat);
+		mNoSignalPixelsToPad = std::max(static_cast<int>(header->bmiHeader.biWidth) - mVideoFormat.cx, 0);
+		DeleteMediaType(sampleMt);
+	}
+
+	const auto imageSize = no_signal_frames::PaddedImageSize(mVideoFormat, mNoSignalPixelsToPad);
+	if (pms->GetSize() < static_cast<long>(imageSize))
+	{
+		#ifndef NO_QUILL
+		LOG_TRACE_L1(mLogData.logger, "[{}] MediaSample size too small for no signal frame ({} vs {})",
+		             mLogData.prefix, pms->GetSize(), imageSize);
+		#endif
+
+		return S_REPEATED_FRAME;
+	}
+
+	BYTE* out;
+	pms->GetPointer(&out);
+	no_signal_frames::CopyTo(out, frame, mVideoFormat, mNoSignalPixelsToPad);
+	pms->SetActualDataLength(imageSize);
+
+	int64_t now;
+	GetReferenceTime(&now);
+	mPreviousFrameTime = mCurrentFrameTime;
+	mCurrentFrameTime = now;
+	auto endTime = now;
+	auto startTime = endTime - mVideoFormat.frameInterval;
+
+	pms->SetTime(&startTime, &endTime);
+	pms->SetSyncPoint(TRUE);
+	pms->SetDiscontinuity(FALSE);
+	if (mUpdatedMediaType)
+	{
+		CMediaType cmt(m_mt);
+		AM_MEDIA_TYPE* sendMediaType = CreateMediaType(&cmt);
+		pms->SetMediaType(sendMediaType);
+		DeleteMediaType(sendMediaType);
+		mUpdatedMediaType = false;
+	}
+	// the renderer stays in the mode it was in, including HDR
+	AppendHdrSideDataIfNecessary(pms, endTime);
+	mFrameCounter++;
+
+	#ifndef NO_QUILL
+	LOG_TRACE_L1(mLogData.logger, "[{}] Delivered no signal frame {} as {}x{} {}", mLogData.prefix, mFrameCounter,
+	             mVideoFormat.cx, mVideoFormat.cy, mVideoFormat.pixelFormat.name);
+	#endif
+
+	return S_OK;
+}
+
 HRESULT magewell_video_capture_pin::OnThreadCreate()
 {
 	hdmi_video_capture_pin::OnThreadCreate();
@@ -1192,6 +1300,12 @@ HRESULT magewell_video_capture_pin::OnThreadCreate()
 
 	UpdateDisplayStatus();
 
+	// a restart without a signal delivers the no signal frame in the format negotiated before the stop
+	if (mSignalNegotiated)
+	{
+		mNoSignalFrames.Prepare(mVideoFormat);
+	}
+
 	mRateSwitcher.InitIfNecessary();
 
 	auto hChannel = mFilter->GetChannelHandle();
@@ -23,6 +23,7 @@
 
 #include "mw_capture_filter.h"
 #include "video_capture_pin.h"
+#include "no_signal.h"
 #include <memory>
 
 /**
@@ -72,6 +73,8 @@ protected:
 	void OnChangeMediaType() override;
 	HRESULT LoadSignal(HCHANNEL* pChannel);
 	void OnFrameWriterStrategyUpdated() override;
+	// copies the cached no signal frame for the current format into the sample
+	HRESULT DeliverNoSignalFrame(IMediaSample* pms, const uint8_t* frame);
 
 	void SnapTemperatureIfNecessary(LONGLONG endTime)
 	{
@@ -127,6 +130,11 @@ protected:
 	HANDLE mNotifyEvent;
 	int64_t mLastTempSnapAt{0};
 	captured_frame mCapturedFrame{};
+	no_signal_frames mNoSignalFrames{};
+	// the no signal frames are only used once a signal has set the format, until then the card's image is delivered
+	bool mSignalNegotiated{false};
+	// padding the renderer asked for, as last seen by the frame writer or on a sample
+	int mNoSignalPixelsToPad{0};
 
 	// pro only
 	HANDLE mCaptureEvent;
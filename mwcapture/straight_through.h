@@ -15,14 +15,28 @@
 #ifndef MW_STRAIGHT_THROUGH_HEADER
 #define MW_STRAIGHT_THROUGH_HEADER
 
+#include <chrono>
 #include "VideoFrameWriter.h"
 #include "mw_domain.h"
 
+// frames captured directly into the sample are measured from 1 in this many lines of luma
+inline constexpr int sparseLightLevelLines = 8;
+// and no more often than this, the meter keeps the maximum of each second
+inline constexpr auto sparseLightLevelInterval = std::chrono::milliseconds(250);
+
+/**
+ * Passes the captured frame through unchanged. USB devices capture to an intermediate buffer which is copied to the
+ * sample, measuring the luma as it goes. PRO devices capture straight into the sample so there is no pass over the
+ * frame to fuse the light level meter into, those frames are instead sampled sparsely. At 4K P010 that reads ~2MB of
+ * the sample 4 times a second, the peak is taken from the sampled lines only so may miss small highlights.
+ */
 class straight_through : public IVideoFrameWriter<video_sample_buffer>
 {
 public:
 	straight_through(const log_data& pLogData, int pX, int pY, const pixel_format* pPixelFormat)
-		: IVideoFrameWriter(pLogData, pX, pY, pPixelFormat)
+		: IVideoFrameWriter(pLogData, pX, pY, pPixelFormat),
+		  mHeight(pY),
+		  mLumaBytes(PlanarLumaBytes(*pPixelFormat))
 	{
 	}
 
@@ -35,7 +49,59 @@ public:
 			return S_FALSE;
 		}
 		// TODO handle padding?
+
+		BYTE* out;
+		auto hr = dstFrame->GetPointer(&out);
+		if (FAILED(hr))
+		{
+			#ifndef NO_QUILL
+			LOG_WARNING(mLogData.logger, "[{}] Unable to fill buffer , can't get pointer to output buffer [{:#08x}]",
+			            mLogData.prefix, hr);
+			#endif
+
+			return S_FALSE;
+		}
+
+		if (srcFrame->data == out)
+		{
+			MeasureSparse(out);
+		}
+		else
+		{
+			CopyMeasured(out, srcFrame->data, srcFrame->length, mHeight, mLumaBytes);
+		}
 		return S_OK;
 	}
+
+private:
+	void MeasureSparse(const uint8_t* frame)
+	{
+		light_level_frame lightLevel;
+		const auto measures = StartMeasuring(mLumaBytes == 2 ? &lightLevel : nullptr, nullptr);
+		if (!measures.lightLevel)
+		{
+			return;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		if (now - mLastMeasuredAt < sparseLightLevelInterval)
+		{
+			return;
+		}
+		mLastMeasuredAt = now;
+
+		light_level_lines lines;
+		for (int line = 0; line < mHeight; line += sparseLightLevelLines)
+		{
+			// every sampled line goes into the histogram
+			lines.Add(frame + static_cast<size_t>(line) * mOutputRowLength, static_cast<int>(mOutputRowLength), mWidth,
+			          0, 1);
+		}
+		measures.lightLevel->Merge(lines);
+		EndMeasuring(measures, mWidth, mHeight);
+	}
+
+	int mHeight;
+	int mLumaBytes;
+	std::chrono::steady_clock::time_point mLastMeasuredAt{};
 };
 #endif
\ No newline at end of file